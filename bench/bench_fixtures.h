@@ -0,0 +1,92 @@
+#pragma once
+
+#include <boost/json.hpp>
+
+#include <memory>
+#include <random>
+#include <string>
+
+#include "../src/model.h"
+#include "../src/state_snapshot.h"
+
+// Синтетические карты и сессии для бенчмарков
+namespace bench {
+
+using namespace std::literals;
+
+// Дороги образуют квадратную сетку: roads_per_side горизонтальных и столько же вертикальных дорог
+// длиной road_length с шагом road_length / (roads_per_side - 1)
+inline model::Map MakeGridMap(
+    const std::string& map_id,
+    int roads_per_side,
+    size_t max_players = 10'000,
+    int road_length = 100
+) {
+    model::Map map{model::Map::Id{map_id}, "bench map "s + map_id, 4.0, true, 3, 3, max_players};
+    const int step = roads_per_side > 1 ? road_length / (roads_per_side - 1) : road_length;
+    for (int i = 0; i < roads_per_side; ++i) {
+        map.AddRoad(std::make_shared<model::Road>(model::Road::HORIZONTAL, model::Point{0, i * step}, road_length));
+        map.AddRoad(std::make_shared<model::Road>(model::Road::VERTICAL, model::Point{i * step, 0}, road_length));
+    }
+    map.AddOffice(model::Office{model::Office::Id{"o0"s}, {0, 0}, {5, 0}});
+    return map;
+}
+
+// Три типа трофеев, по числу loot_types_amount карт из MakeGridMap
+inline void AddLootTypes(extra_data::LootTypes& loot_types, const std::string& map_id) {
+    loot_types.AddLootTypes(map_id, boost::json::parse(R"([
+        {"name": "key", "file": "assets/key.obj", "type": "obj", "rotation": 90, "color": "#338844", "scale": 0.03, "value": 10},
+        {"name": "wallet", "file": "assets/wallet.obj", "type": "obj", "rotation": 0, "color": "#883344", "scale": 0.01, "value": 30},
+        {"name": "ball", "file": "assets/ball.obj", "type": "obj", "scale": 0.05, "value": 5}
+    ])"sv).as_array());
+}
+
+inline std::shared_ptr<const extra_data::LootTypes> MakeLootTypes(const std::string& map_id) {
+    extra_data::LootTypes loot_types;
+    AddLootTypes(loot_types, map_id);
+    return std::make_shared<const extra_data::LootTypes>(std::move(loot_types));
+}
+
+// Сессия с dogs собаками в случайных точках дорог, идущими в случайных направлениях,
+// и lost_objects предметами на дорогах
+inline std::shared_ptr<model::GameSession> MakeSession(
+    const std::shared_ptr<model::Map>& map,
+    size_t dogs,
+    size_t lost_objects,
+    uint64_t seed = 42
+) {
+    auto session = std::make_shared<model::GameSession>(map, MakeLootTypes(*map->GetId()));
+    std::mt19937_64 random{seed};
+    constexpr std::string_view DIRECTIONS[] = {"L"sv, "R"sv, "U"sv, "D"sv};
+    for (size_t i = 0; i < dogs; ++i) {
+        std::shared_ptr<model::Dog> dog = session->CreateDog("dog "s + std::to_string(i));
+        dog->MoveDog(std::string{DIRECTIONS[random() % 4]}, map->GetDogSpeedOnMap());
+    }
+    for (size_t i = 0; i < lost_objects; ++i) {
+        session->AddLostObject(model::LostObject{
+            model::LostObject::Id{i}, i % 3, map->GetRandomPositionOnRandomRoad(random), static_cast<int64_t>(i % 3) * 10
+        });
+    }
+    return session;
+}
+
+// Снимок сессии с players собаками, у каждой bag_size предметов в рюкзаке
+inline application::SessionSnapshot MakeSnapshot(size_t players, size_t lost_objects, size_t bag_size = 3) {
+    application::SessionSnapshot snapshot;
+    snapshot.dogs.reserve(players);
+    for (size_t i = 0; i < players; ++i) {
+        application::SessionSnapshot::DogState& dog = snapshot.dogs.emplace_back(application::SessionSnapshot::DogState{
+            i, "player "s + std::to_string(i), {1.5 * i, 2.5}, {1.0, 0.0}, "R"s, {}, static_cast<int>(i)
+        });
+        for (size_t j = 0; j < bag_size; ++j) {
+            dog.bag.push_back({i * bag_size + j, j % 3});
+        }
+    }
+    snapshot.lost_objects.reserve(lost_objects);
+    for (size_t i = 0; i < lost_objects; ++i) {
+        snapshot.lost_objects.push_back({i, i % 3, {0.5 * i, 10.0}});
+    }
+    return snapshot;
+}
+
+}  // namespace bench
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "../src/collision_detector.h"
+
+namespace {
+
+using namespace collision_detector;
+
+class VectorItemGathererProvider : public ItemGathererProvider {
+public:
+    VectorItemGathererProvider(size_t items_count, size_t gatherers_count, double field_size, uint64_t seed = 42) {
+        std::mt19937_64 random{seed};
+        std::uniform_real_distribution<double> coord{0., field_size};
+        std::uniform_real_distribution<double> step{-1., 1.};
+        items_.reserve(items_count);
+        for (size_t i = 0; i < items_count; ++i) {
+            items_.push_back({{coord(random), coord(random)}, 0.});
+        }
+        // Собиратели проходят за тик короткий путь, как собаки за 25-50 мс
+        gatherers_.reserve(gatherers_count);
+        for (size_t i = 0; i < gatherers_count; ++i) {
+            const geom::Point2D start{coord(random), coord(random)};
+            gatherers_.push_back({start, {start.x + step(random), start.y + step(random)}, 0.6});
+        }
+    }
+
+    size_t ItemsCount() const override {
+        return items_.size();
+    }
+
+    Item GetItem(size_t idx) const override {
+        return items_[idx];
+    }
+
+    size_t GatherersCount() const override {
+        return gatherers_.size();
+    }
+
+    Gatherer GetGatherer(size_t idx) const override {
+        return gatherers_[idx];
+    }
+
+private:
+    std::vector<Item> items_;
+    std::vector<Gatherer> gatherers_;
+};
+
+// Аргументы: количество предметов, количество собирателей
+void BM_FindGatherEvents(benchmark::State& state) {
+    const VectorItemGathererProvider provider{
+        static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1)), 100.
+    };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(FindGatherEvents(provider));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+void BM_FindGatherEventsInGrid(benchmark::State& state) {
+    const VectorItemGathererProvider provider{
+        static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1)), 100.
+    };
+    // Сетка создаётся один раз, как в игровой сессии
+    ItemGrid grid{4.};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(grid.FindGatherEvents(provider));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+}  // namespace
+
+BENCHMARK(BM_FindGatherEvents)->ArgNames({"items", "gatherers"})->RangeMultiplier(10)->Ranges({{100, 10'000}, {10, 1'000}});
+BENCHMARK(BM_FindGatherEventsInGrid)->ArgNames({"items", "gatherers"})->RangeMultiplier(10)->Ranges({{100, 10'000}, {10, 1'000}});
@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "../src/json_loader.h"
+
+namespace {
+
+using namespace std::literals;
+
+constexpr int CONFIG_MAPS = 500;
+constexpr int ROADS_PER_SIDE = 21;
+constexpr int ROAD_LENGTH = 200;
+
+// Конфигурация из maps карт, дороги каждой образуют сетку как в bench::MakeGridMap
+void WriteConfig(std::ostream& out, int maps) {
+    constexpr int step = ROAD_LENGTH / (ROADS_PER_SIDE - 1);
+    out << R"({"defaultDogSpeed": 3.0, "lootGeneratorConfig": {"period": 5.0, "probability": 0.5}, "maps": [)";
+    for (int map = 0; map < maps; ++map) {
+        out << (map ? ",\n"sv : "\n"sv) << R"({"id": "map)" << map << R"(", "name": "Map )" << map << R"(", "lootTypes": [)"
+            << R"({"name": "key", "file": "assets/key.obj", "type": "obj", "rotation": 90, "color": "#338844", "scale": 0.03, "value": 10},)"
+            << R"({"name": "wallet", "file": "assets/wallet.obj", "type": "obj", "scale": 0.01, "value": 30}], "roads": [)";
+        for (int i = 0; i < ROADS_PER_SIDE; ++i) {
+            out << (i ? ","sv : ""sv)
+                << R"({"x0": 0, "y0": )" << i * step << R"(, "x1": )" << ROAD_LENGTH << "},"
+                << R"({"x0": )" << i * step << R"(, "y0": 0, "y1": )" << ROAD_LENGTH << "}";
+        }
+        out << R"(], "buildings": [)";
+        for (int i = 0; i + 1 < ROADS_PER_SIDE; ++i) {
+            out << (i ? ","sv : ""sv) << R"({"x": )" << i * step + 1 << R"(, "y": 1, "w": )" << step - 2 << R"(, "h": )" << step - 2 << "}";
+        }
+        out << R"(], "offices": [{"id": "o0", "x": 0, "y": 0, "offsetX": 5, "offsetY": 0}]})";
+    }
+    out << "\n]}\n"sv;
+}
+
+// Файл конфигурации создаётся один раз на запуск бенчмарков и удаляется при выходе
+class GeneratedConfig {
+public:
+    GeneratedConfig()
+    : path_{std::filesystem::temp_directory_path() / "game_server_bench_config.json"}
+    {
+        std::ofstream out{path_, std::ios::trunc};
+        WriteConfig(out, CONFIG_MAPS);
+        if (!out.flush()) {
+            throw std::runtime_error("Failed to write "s + path_.string());
+        }
+    }
+
+    ~GeneratedConfig() {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+    }
+
+    const std::filesystem::path& GetPath() const noexcept {
+        return path_;
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+const std::filesystem::path& GetConfigPath() {
+    static const GeneratedConfig config;
+    return config.GetPath();
+}
+
+// Аргумент: число потоков построения карт, 0 - по числу ядер
+void BM_LoadGame(benchmark::State& state) {
+    const std::filesystem::path& path = GetConfigPath();
+    const auto threads = static_cast<unsigned>(state.range(0));
+    for (auto _ : state) {
+        model::Game game = json_loader::LoadGame(path, false, threads);
+        benchmark::DoNotOptimize(game.GetMaps().data());
+    }
+    state.SetItemsProcessed(state.iterations() * CONFIG_MAPS);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(std::filesystem::file_size(path)));
+}
+
+}  // namespace
+
+BENCHMARK(BM_LoadGame)->ArgNames({"threads"})->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_fixtures.h"
+#include "../src/application.h"
+
+namespace {
+
+using namespace std::literals;
+
+constexpr int64_t TICK_MS = 25;
+
+// Аргументы: дорог в каждом направлении, количество собак
+void BM_MoveDogByTick(benchmark::State& state) {
+    auto map = std::make_shared<model::Map>(bench::MakeGridMap("move"s, static_cast<int>(state.range(0))));
+    auto session = bench::MakeSession(map, static_cast<size_t>(state.range(1)), 0);
+    const model::Map::PointToRoadSegments& point_to_road_segments = map->GetPointToRoadSegments();
+    const std::string directions[] = {"L"s, "R"s, "U"s, "D"s};
+    size_t next_direction = 0;
+    for (auto _ : state) {
+        for (const std::shared_ptr<model::Dog>& dog : session->GetDogs()) {
+            dog->MoveDogByTick(TICK_MS, point_to_road_segments);
+            // Упёршаяся в край дороги собака поворачивает, чтобы в каждой итерации двигались все собаки
+            if (dog->GetDogSpeed().v_x == 0. && dog->GetDogSpeed().v_y == 0.) {
+                dog->MoveDog(directions[next_direction++ % 4], map->GetDogSpeedOnMap());
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+// Аргументы: количество собак, количество предметов. Сессия пересоздаётся вне замера,
+// чтобы собранные предметы не уменьшали нагрузку от итерации к итерации
+void BM_HandleCollisions(benchmark::State& state) {
+    auto map = std::make_shared<model::Map>(bench::MakeGridMap("collisions"s, 11));
+    const size_t dogs = static_cast<size_t>(state.range(0));
+    const size_t lost_objects = static_cast<size_t>(state.range(1));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto session = bench::MakeSession(map, dogs, lost_objects);
+        for (const std::shared_ptr<model::Dog>& dog : session->GetDogs()) {
+            dog->SetPrevPosition(dog->GetDogPosition());
+            dog->MoveDogByTick(TICK_MS, map->GetPointToRoadSegments());
+        }
+        state.ResumeTiming();
+
+        session->HandleCollisions();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Аргументы: количество карт, игроков на карте. Рекорды хранятся в памяти, база данных не нужна
+void BM_ApplicationTick(benchmark::State& state) {
+    const int maps = static_cast<int>(state.range(0));
+    const int players_per_map = static_cast<int>(state.range(1));
+
+    model::Game game{model::LootGeneratorConfig{5000, 0.5}, std::chrono::hours{24}};
+    extra_data::LootTypes loot_types;
+    for (int i = 0; i < maps; ++i) {
+        const std::string map_id = "map"s + std::to_string(i);
+        game.AddMap(bench::MakeGridMap(map_id, 11, 20));
+        bench::AddLootTypes(loot_types, map_id);
+    }
+    game.SetLootTypes(std::move(loot_types));
+
+    application::AppConfig config;
+    config.records_storage = application::RecordsStorage::MEMORY;
+    application::Application app{std::move(game), config};
+    for (int i = 0; i < maps; ++i) {
+        const model::Map::Id map_id{"map"s + std::to_string(i)};
+        for (int j = 0; j < players_per_map; ++j) {
+            auto [token, player_id] = app.JoinGame("player "s + std::to_string(j), map_id);
+            // Собаки всё время движутся, иначе тик обрабатывает только неподвижные собаки
+            app.MovePlayer(app.FindPlayerByToken(token), j % 2 ? "R"s : "D"s);
+        }
+    }
+
+    for (auto _ : state) {
+        app.Tick(std::chrono::milliseconds{TICK_MS});
+    }
+    state.SetItemsProcessed(state.iterations() * maps * players_per_map);
+}
+
+}  // namespace
+
+BENCHMARK(BM_MoveDogByTick)->ArgNames({"roads", "dogs"})->RangeMultiplier(10)->Ranges({{10, 100}, {10, 10'000}});
+BENCHMARK(BM_HandleCollisions)->ArgNames({"dogs", "objects"})->RangeMultiplier(10)->Ranges({{10, 1'000}, {10, 10'000}});
+BENCHMARK(BM_ApplicationTick)->ArgNames({"maps", "players"})->RangeMultiplier(10)->Ranges({{1, 100}, {10, 50}})
+    ->Unit(benchmark::kMicrosecond);
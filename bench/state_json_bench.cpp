@@ -0,0 +1,38 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_fixtures.h"
+#include "../src/api_request_handler.h"
+
+namespace {
+
+using http_handler::ApiRequestHandler;
+
+// Аргументы: количество игроков и предметов в снимке сессии
+void BM_BuildStateJSON(benchmark::State& state) {
+    const application::SessionSnapshot snapshot = bench::MakeSnapshot(
+        static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1))
+    );
+    size_t bytes = 0;
+    for (auto _ : state) {
+        std::string json = ApiRequestHandler::BuildSuccessfullStateRequestJSON(snapshot);
+        bytes += json.size();
+        benchmark::DoNotOptimize(json);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+void BM_BuildPlayersJSON(benchmark::State& state) {
+    const application::SessionSnapshot snapshot = bench::MakeSnapshot(static_cast<size_t>(state.range(0)), 0);
+    size_t bytes = 0;
+    for (auto _ : state) {
+        std::string json = ApiRequestHandler::BuildSuccessfullPlayersRequestJSON(snapshot);
+        bytes += json.size();
+        benchmark::DoNotOptimize(json);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+}  // namespace
+
+BENCHMARK(BM_BuildStateJSON)->ArgNames({"players", "objects"})->RangeMultiplier(10)->Ranges({{10, 1'000}, {10, 1'000}});
+BENCHMARK(BM_BuildPlayersJSON)->ArgNames({"players"})->RangeMultiplier(10)->Range(10, 10'000);
@@ -0,0 +1,69 @@
+#include "admission_control.h"
+
+#include <algorithm>
+
+namespace http_server {
+
+bool AdmissionControl::TryAdmit() noexcept {
+    uint64_t active = active_connections_.load(std::memory_order_relaxed);
+    do {
+        if (config_.max_connections != 0 && active >= config_.max_connections) {
+            rejected_connections_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!active_connections_.compare_exchange_weak(active, active + 1, std::memory_order_relaxed));
+    accepted_connections_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void AdmissionControl::Release() noexcept {
+    active_connections_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::chrono::milliseconds AdmissionControl::GetIdleTimeout() const noexcept {
+    if (config_.max_connections == 0) {
+        return config_.idle_timeout;
+    }
+    const double load = static_cast<double>(active_connections_.load(std::memory_order_relaxed))
+        / static_cast<double>(config_.max_connections);
+    if (load <= config_.idle_pressure_threshold) {
+        return config_.idle_timeout;
+    }
+    // Линейно сокращаем таймаут от idle_timeout до min_idle_timeout по мере заполнения оставшихся мест
+    const double pressure = std::min(1.0, (load - config_.idle_pressure_threshold) / (1.0 - config_.idle_pressure_threshold));
+    const auto range = config_.idle_timeout - config_.min_idle_timeout;
+    return config_.idle_timeout - std::chrono::duration_cast<std::chrono::milliseconds>(range * pressure);
+}
+
+void AdmissionControl::OnTickFinished(std::chrono::microseconds duration) noexcept {
+    // Вес нового замера 1/8, как при сглаживании RTT в TCP
+    constexpr int64_t SMOOTHING_SHIFT = 3;
+    const int64_t last_us = duration.count();
+    const int64_t smoothed_us = smoothed_tick_duration_us_.load(std::memory_order_relaxed);
+    last_tick_duration_us_.store(last_us, std::memory_order_relaxed);
+    smoothed_tick_duration_us_.store(smoothed_us + ((last_us - smoothed_us) >> SMOOTHING_SHIFT), std::memory_order_relaxed);
+}
+
+bool AdmissionControl::IsOverloaded() const noexcept {
+    if (config_.max_api_queue != 0
+        && api_queue_depth_.load(std::memory_order_relaxed) >= static_cast<int64_t>(config_.max_api_queue)) {
+        return true;
+    }
+    const auto max_tick_us = std::chrono::duration_cast<std::chrono::microseconds>(config_.max_tick_duration).count();
+    return max_tick_us != 0 && smoothed_tick_duration_us_.load(std::memory_order_relaxed) > max_tick_us;
+}
+
+AdmissionControl::Stats AdmissionControl::GetStats() const noexcept {
+    Stats stats;
+    stats.accepted_connections = accepted_connections_.load(std::memory_order_relaxed);
+    stats.rejected_connections = rejected_connections_.load(std::memory_order_relaxed);
+    stats.active_connections = active_connections_.load(std::memory_order_relaxed);
+    stats.idle_timeouts = idle_timeouts_.load(std::memory_order_relaxed);
+    stats.shed_requests = shed_requests_.load(std::memory_order_relaxed);
+    stats.api_queue_depth = static_cast<uint64_t>(std::max<int64_t>(0, api_queue_depth_.load(std::memory_order_relaxed)));
+    stats.last_tick_duration = std::chrono::microseconds{last_tick_duration_us_.load(std::memory_order_relaxed)};
+    stats.smoothed_tick_duration = std::chrono::microseconds{smoothed_tick_duration_us_.load(std::memory_order_relaxed)};
+    return stats;
+}
+
+}  // namespace http_server
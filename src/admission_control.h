@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace http_server {
+
+/**
+ * Контроль нагрузки на сервер: ограничение числа соединений, адаптивный таймаут простоя
+ * и признак перегрузки, по которому API отвечает 503 без постановки запроса в очередь.
+ * Один объект разделяется всеми Listener'ами (в том числе шардами) и обработчиком API,
+ * все методы потокобезопасны.
+ */
+class AdmissionControl {
+public:
+    struct Config {
+        // Максимальное число одновременно открытых соединений, 0 - без ограничения
+        size_t max_connections = 10000;
+        // Таймаут простоя соединения при низкой нагрузке
+        std::chrono::milliseconds idle_timeout{30000};
+        // Таймаут простоя, к которому он сокращается при заполнении всех соединений
+        std::chrono::milliseconds min_idle_timeout{2000};
+        // Доля занятых соединений, начиная с которой таймаут простоя сокращается
+        double idle_pressure_threshold = 0.5;
+        // Максимальное число задач API в очереди api_strand, 0 - без ограничения
+        size_t max_api_queue = 1024;
+        // Максимальная сглаженная длительность тика, 0 - не проверяется
+        std::chrono::milliseconds max_tick_duration{0};
+    };
+
+    // Счётчики для экспорта
+    struct Stats {
+        uint64_t accepted_connections = 0;
+        uint64_t rejected_connections = 0;
+        uint64_t active_connections = 0;
+        uint64_t idle_timeouts = 0;
+        uint64_t shed_requests = 0;
+        uint64_t api_queue_depth = 0;
+        std::chrono::microseconds last_tick_duration{0};
+        std::chrono::microseconds smoothed_tick_duration{0};
+    };
+
+    AdmissionControl() = default;
+
+    explicit AdmissionControl(const Config& config)
+    : config_{config}
+    {
+
+    }
+
+    // Пытается занять место под новое соединение
+    bool TryAdmit() noexcept;
+
+    // Освобождает место соединения
+    void Release() noexcept;
+
+    // Таймаут простоя с учётом текущей нагрузки: чем больше занято соединений, тем он короче
+    std::chrono::milliseconds GetIdleTimeout() const noexcept;
+
+    void OnIdleTimeout() noexcept {
+        idle_timeouts_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void OnApiTaskQueued() noexcept {
+        api_queue_depth_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void OnApiTaskStarted() noexcept {
+        api_queue_depth_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Вызывается только потоком тиков
+    void OnTickFinished(std::chrono::microseconds duration) noexcept;
+
+    // Сервер перегружен: очередь api_strand или сглаженная длительность тика превысили пороги
+    bool IsOverloaded() const noexcept;
+
+    void OnRequestShed() noexcept {
+        shed_requests_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Stats GetStats() const noexcept;
+
+private:
+    Config config_;
+
+    std::atomic<uint64_t> active_connections_{0};
+    std::atomic<uint64_t> accepted_connections_{0};
+    std::atomic<uint64_t> rejected_connections_{0};
+    std::atomic<uint64_t> idle_timeouts_{0};
+    std::atomic<uint64_t> shed_requests_{0};
+    std::atomic<int64_t> api_queue_depth_{0};
+    std::atomic<int64_t> last_tick_duration_us_{0};
+    // Экспоненциальное скользящее среднее длительности тика, отдельный долгий тик не вызывает перегрузку
+    std::atomic<int64_t> smoothed_tick_duration_us_{0};
+};
+
+}  // namespace http_server
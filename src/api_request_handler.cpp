@@ -248,7 +248,7 @@ namespace http_handler {
     }
 
     StringResponse ApiRequestHandler::HandleUnauthorized(
-        const std::string& auth_header,
+        std::string_view auth_header,
         const std::string& code,
         const std::string& message,
         unsigned http_version,
@@ -268,19 +268,18 @@ namespace http_handler {
         return str_resp;
     }
 
-    std::string ApiRequestHandler::BuildSuccessfullPlayersRequestJSON(std::vector<std::shared_ptr<application::Player>> coplayers) {
+    std::string ApiRequestHandler::BuildSuccessfullPlayersRequestJSON(const application::SessionSnapshot& session) {
         std::ostringstream ost;
         json::object answer;
-        for (std::shared_ptr<application::Player> player : coplayers) {
-            answer.emplace(std::to_string(*(player->GetId())), json::object{ {"name"s, player->GetName()} });
+        for (const application::SessionSnapshot::DogState& dog : session.dogs) {
+            answer.emplace(std::to_string(dog.player_id), json::object{ {"name"s, dog.player_name} });
         }
         PrettyPrint(ost, answer);
         return ost.str();
     }
 
     StringResponse ApiRequestHandler::HandleSuccessfullPlayersRequest(std::shared_ptr<application::Player> player, unsigned http_version,bool keep_alive) {
-        std::vector<std::shared_ptr<application::Player>> coplayers = application_.GetCurrentPlayerGameSessionPlayers(player);
-        std::string json_str = BuildSuccessfullPlayersRequestJSON(coplayers);
+        std::string json_str = BuildSuccessfullPlayersRequestJSON(*player->GetSessionSnapshot());
 
         StringResponse str_resp = MakeStringResponse(
             http::status::ok,
@@ -296,47 +295,42 @@ namespace http_handler {
         return str_resp;
     }
 
-    std::string ApiRequestHandler::BuildSuccessfullStateRequestJSON(std::vector<std::shared_ptr<application::Player>> coplayers) {
+    std::string ApiRequestHandler::BuildSuccessfullStateRequestJSON(const application::SessionSnapshot& session) {
         std::ostringstream ost;
         // Добавляем информацию о собаках
         json::object dogs_info;
-        for (std::shared_ptr<application::Player> player : coplayers) {
-            std::shared_ptr<model::Dog> dog = player->GetDog();
-
+        for (const application::SessionSnapshot::DogState& dog : session.dogs) {
             // Собираем информацию о предметах в рюкзаке
             json::array bag_items;
-            for (const auto& item : dog->GetBag().GetItems()) {
+            for (const application::SessionSnapshot::BagItem& item : dog.bag) {
                 bag_items.emplace_back(json::object{
-                    {"id"s, *item.GetId()},
-                    {"type"s, item.GetType()}
+                    {"id"s, item.id},
+                    {"type"s, item.type}
                 });
             }
 
             dogs_info.emplace(
-                std::to_string(*(player->GetId())),
+                std::to_string(dog.player_id),
                 json::object{
-                    { "pos"s, json::array{dog->GetDogPosition().x, dog->GetDogPosition().y} },
-                    { "speed"s, json::array{dog->GetDogSpeed().v_x, dog->GetDogSpeed().v_y} },
-                    { "dir"s, dog->GetStringDirection() },
+                    { "pos"s, json::array{dog.position.x, dog.position.y} },
+                    { "speed"s, json::array{dog.speed.v_x, dog.speed.v_y} },
+                    { "dir"s, dog.direction },
                     { "bag"s, bag_items },
-                    { "score"s, dog->GetScore()}
+                    { "score"s, dog.score}
                 }
             );
         }
 
         // Добавляем информацию о потерянных предметах
         json::object lost_objects;
-        if (!coplayers.empty()) {
-            std::shared_ptr<model::GameSession> session = coplayers.front()->GetSession();
-            for (const auto& [id, obj] : session->GetLostObjects()) {
-                lost_objects.emplace(
-                    std::to_string(*id),
-                    json::object{
-                        {"type"s, obj.GetType()},
-                        {"pos"s, json::array{obj.GetPosition().x, obj.GetPosition().y}}
-                    }
-                );
-            }
+        for (const application::SessionSnapshot::LostObjectState& obj : session.lost_objects) {
+            lost_objects.emplace(
+                std::to_string(obj.id),
+                json::object{
+                    {"type"s, obj.type},
+                    {"pos"s, json::array{obj.position.x, obj.position.y}}
+                }
+            );
         }
 
         json::object answer{
@@ -349,8 +343,7 @@ namespace http_handler {
     }
 
     StringResponse ApiRequestHandler::HandleSuccessfullStateRequest(std::shared_ptr<application::Player> player, unsigned http_version, bool keep_alive) {
-        std::vector<std::shared_ptr<application::Player>> coplayers = application_.GetCurrentPlayerGameSessionPlayers(player);
-        std::string json_str = BuildSuccessfullStateRequestJSON(coplayers);
+        std::string json_str = BuildSuccessfullStateRequestJSON(*player->GetSessionSnapshot());
 
         StringResponse str_resp = MakeStringResponse(
             http::status::ok,
@@ -468,7 +461,7 @@ namespace http_handler {
         unsigned http_version,bool keep_alive
     ) {
         auto [token, player_id] = application_.JoinGame(player_name, model::Map::Id{ map_id });
-        std::string json_str = BuildSuccessfullGameJoinRequestJSON(*token, *player_id);
+        std::string json_str = BuildSuccessfullGameJoinRequestJSON(token.ToHex(), *player_id);
 
         StringResponse str_resp = MakeStringResponse(
             http::status::ok,
@@ -487,7 +480,7 @@ namespace http_handler {
     StringResponse ApiRequestHandler::HandleSuccessfullPlayerActionRequest(std::shared_ptr<application::Player> player, const std::string& move_direction,
         unsigned http_version, bool keep_alive
     ) {
-        player->GetDog()->MoveDog(move_direction, player->GetSession()->GetMap()->GetDogSpeedOnMap());
+        application_.MovePlayer(player, move_direction);
         std::string json_str = "{}"s;
 
         StringResponse str_resp = MakeStringResponse(
@@ -579,26 +572,147 @@ namespace http_handler {
         return str_resp;
     }
     
+    std::string ApiRequestHandler::BuildMetricsText() {
+        std::ostringstream os;
+        metrics::WriteText(os, metrics::Collect());
+
+        if (admission_) {
+            const http_server::AdmissionControl::Stats stats = admission_->GetStats();
+            metrics::WriteHeader(os, "game_connections_accepted_total"sv, "counter"sv, "Accepted HTTP connections"sv);
+            metrics::WriteSample(os, "game_connections_accepted_total"sv, stats.accepted_connections);
+            metrics::WriteHeader(os, "game_connections_rejected_total"sv, "counter"sv, "Connections closed right after accept due to the limit"sv);
+            metrics::WriteSample(os, "game_connections_rejected_total"sv, stats.rejected_connections);
+            metrics::WriteHeader(os, "game_connections_active"sv, "gauge"sv, "Open HTTP connections"sv);
+            metrics::WriteSample(os, "game_connections_active"sv, stats.active_connections);
+            metrics::WriteHeader(os, "game_idle_timeouts_total"sv, "counter"sv, "Connections closed by the idle timeout"sv);
+            metrics::WriteSample(os, "game_idle_timeouts_total"sv, stats.idle_timeouts);
+            metrics::WriteHeader(os, "game_shed_requests_total"sv, "counter"sv, "API requests answered with 503 due to overload"sv);
+            metrics::WriteSample(os, "game_shed_requests_total"sv, stats.shed_requests);
+            metrics::WriteHeader(os, "game_api_queue_depth"sv, "gauge"sv, "API tasks waiting in the api_strand queue"sv);
+            metrics::WriteSample(os, "game_api_queue_depth"sv, stats.api_queue_depth);
+        }
+
+        const std::vector<application::MapStats> map_stats = application_.GetMapStats();
+
+        metrics::WriteHeader(os, "game_sessions"sv, "gauge"sv, "Game sessions on the map"sv);
+        for (const application::MapStats& stats : map_stats) {
+            metrics::WriteSample(os, "game_sessions"sv, stats.sessions, "map"sv, stats.map_id);
+        }
+        metrics::WriteHeader(os, "game_dogs"sv, "gauge"sv, "Dogs on the map"sv);
+        for (const application::MapStats& stats : map_stats) {
+            metrics::WriteSample(os, "game_dogs"sv, stats.dogs, "map"sv, stats.map_id);
+        }
+        metrics::WriteHeader(os, "game_lost_objects"sv, "gauge"sv, "Lost objects lying on the map"sv);
+        for (const application::MapStats& stats : map_stats) {
+            metrics::WriteSample(os, "game_lost_objects"sv, stats.lost_objects, "map"sv, stats.map_id);
+        }
+
+        return os.str();
+    }
+
+    StringResponse ApiRequestHandler::HandleMetricsRequest(unsigned http_version, bool keep_alive) {
+        StringResponse str_resp = MakeStringResponse(
+            http::status::ok,
+            BuildMetricsText(),
+            http_version,
+            keep_alive,
+            ContentType::TEXT_PROMETHEUS
+        );
+        str_resp.set(http::field::cache_control, "no-cache"s);
+
+        return str_resp;
+    }
+
+    bool ApiRequestHandler::IsAdminAuthorized(std::string_view auth_header) const noexcept {
+        if (admin_token_.empty() || !auth_header.starts_with(application::detail::TOKEN_STRATS_WITH)) {
+            return false;
+        }
+        const std::string_view token = auth_header.substr(application::detail::TOKEN_STRATS_WITH.size());
+        if (token.size() != admin_token_.size()) {
+            return false;
+        }
+        // Сравнение без раннего выхода: время ответа не зависит от длины совпавшего префикса
+        unsigned char difference = 0;
+        for (size_t i = 0; i < token.size(); ++i) {
+            difference |= static_cast<unsigned char>(token[i] ^ admin_token_[i]);
+        }
+        return difference == 0;
+    }
+
+    std::string ApiRequestHandler::BuildAdminStatsJSON() {
+        auto make_stats_object = [](const application::MapStats& stats) {
+            return json::object{
+                {"sessions"s, stats.sessions},
+                {"dogs"s, stats.dogs},
+                {"lostObjects"s, stats.lost_objects},
+                {"tokens"s, stats.tokens},
+                {"bytes"s, json::object{
+                    {"roadIndex"s, stats.road_index_bytes},
+                    {"sessions"s, stats.sessions_bytes},
+                    {"tokens"s, stats.tokens_bytes}
+                }}
+            };
+        };
+
+        json::array maps;
+        application::MapStats total;
+        for (const application::MapStats& stats : application_.GetMapStats()) {
+            json::object map_object = make_stats_object(stats);
+            map_object.emplace("id"s, stats.map_id);
+            maps.emplace_back(std::move(map_object));
+
+            total.sessions += stats.sessions;
+            total.dogs += stats.dogs;
+            total.lost_objects += stats.lost_objects;
+            total.tokens += stats.tokens;
+            total.road_index_bytes += stats.road_index_bytes;
+            total.sessions_bytes += stats.sessions_bytes;
+            total.tokens_bytes += stats.tokens_bytes;
+        }
+
+        std::ostringstream ost;
+        PrettyPrint(ost, json::object{
+            {"maps"s, std::move(maps)},
+            {"total"s, make_stats_object(total)}
+        });
+        return ost.str();
+    }
+
+    StringResponse ApiRequestHandler::HandleAdminStatsRequest(unsigned http_version, bool keep_alive) {
+        std::string json_str = BuildAdminStatsJSON();
+        StringResponse str_resp = MakeStringResponse(
+            http::status::ok,
+            json_str,
+            http_version,
+            keep_alive,
+            ContentType::APPLICATION_JSON
+        );
+        str_resp.set(http::field::content_length, std::to_string(json_str.size()));
+        str_resp.set(http::field::cache_control, "no-cache"s);
+
+        return str_resp;
+    }
+
     //
     // TWO MAIN FUCNTIONS
     //
 
-    StringResponse ApiRequestHandler::HandleSafeApiRequest(const std::string& path, const std::string& auth_header,
+    StringResponse ApiRequestHandler::HandleSafeApiRequest(std::string_view path, std::string_view auth_header,
         unsigned http_version, bool keep_alive
     ) {
 
-        std::smatch match;
+        PathMatch match;
 
-        if (std::regex_match(path, match, case_maps)) {
+        if (std::regex_match(path.begin(), path.end(), match, case_maps)) {
             // api/v1/maps/ or api/v1/maps
             return HandleAllMapsRequest(http_version,keep_alive);
-        } else if (std::regex_match(path, match, case_map)) {
+        } else if (std::regex_match(path.begin(), path.end(), match, case_map)) {
             // api/v1/maps/{id-карты}
-            std::shared_ptr<model::Map> map = application_.FindMap(model::Map::Id{ match[1] });
+            std::shared_ptr<model::Map> map = application_.FindMap(model::Map::Id{ match[1].str() });
             return HandleMapRequest(map, http_version,keep_alive);
-        } else if (std::regex_match(path, match, case_game_records)) {
+        } else if (std::regex_match(path.begin(), path.end(), match, case_game_records)) {
             std::unordered_map<std::string, std::string> params;
-            std::stringstream ss(match[1]);
+            std::stringstream ss(match[1].str());
             std::string item;
             
             while (std::getline(ss, item, '&')) {
@@ -610,7 +724,7 @@ namespace http_handler {
                 }
             }
             return HandleRecordsRequest(params, http_version, keep_alive);
-        } else if (std::regex_match(path, match, case_game)) {
+        } else if (std::regex_match(path.begin(), path.end(), match, case_game)) {
             // Получили НЕ POST запрос на /api/v1/game/..
             
             if (match[1] == "join"s) {
@@ -640,11 +754,8 @@ namespace http_handler {
                     );
                 }
 
-                // На этом этапе токен точно валидный
-                application::Token token{ auth_header.substr(application::detail::TOKEN_POS_TO_DISCARD_BEARER) };
-
-                // Находим игрока по токену
-                std::shared_ptr<application::Player> player = application_.FindPlayerByToken(token);
+                // На этом этапе формат заголовка валидный, находим игрока по токену
+                std::shared_ptr<application::Player> player = application_.FindPlayerByAuthorization(auth_header);
 
                 // Обрабатываем случай, когда игрок по токену не найден
                 if (!player) {
@@ -677,11 +788,8 @@ namespace http_handler {
                     );
                 }
 
-                // На этом этапе токен точно валидный
-                application::Token token{ auth_header.substr(application::detail::TOKEN_POS_TO_DISCARD_BEARER) };
-
-                // Находим игрока по токену
-                std::shared_ptr<application::Player> player = application_.FindPlayerByToken(token);
+                // На этом этапе формат заголовка валидный, находим игрока по токену
+                std::shared_ptr<application::Player> player = application_.FindPlayerByAuthorization(auth_header);
 
                 // Обрабатываем случай, когда игрок по токену не найден
                 if (!player) {
@@ -697,22 +805,34 @@ namespace http_handler {
                 // На этом этапе игрок найден, всё готово для 200 ответа
                 return HandleSuccessfullStateRequest(player, http_version, keep_alive);
             }
-        } else if (std::regex_match(path, match, case_player_action)) {
+        } else if (std::regex_match(path.begin(), path.end(), match, case_player_action)) {
             // safe запрос на /api/v1/game/player/action - method not allowed
             return HandleMethodNotAllowed("Invalid method"s, "POST"s, http_version, keep_alive);
+        } else if (!admin_token_.empty() && std::regex_match(path.begin(), path.end(), match, case_admin_stats)) {
+            // /api/v1/admin/stats - статистика карт из счётчиков, состояние сессий не обходится
+            if (!IsAdminAuthorized(auth_header)) {
+                return HandleUnauthorized(
+                    auth_header,
+                    "invalidToken"s,
+                    "Admin token is missing or invalid"s,
+                    http_version,
+                    keep_alive
+                );
+            }
+            return HandleAdminStatsRequest(http_version, keep_alive);
         }
         // bad request к API, который не изменяет состояние игры
         return HandleBadRequest("badRequest"s, "Bad request"s, http_version, keep_alive);
     }
 
-    StringResponse ApiRequestHandler::HandleChangingApiRequest(const std::string& path, const std::string& auth_header,
-        const std::string& request_body, http::verb request_method, const std::string& content_type,
+    StringResponse ApiRequestHandler::HandleChangingApiRequest(std::string_view path, std::string_view auth_header,
+        std::string_view request_body, http::verb request_method, std::string_view content_type,
         unsigned http_version, bool keep_alive
     ) {
 
-        std::smatch match;
+        PathMatch match;
 
-        if (std::regex_match(path, match, case_maps) || std::regex_match(path, match, case_map)) {
+        if (std::regex_match(path.begin(), path.end(), match, case_maps) || std::regex_match(path.begin(), path.end(), match, case_map)) {
             // Получили POST на url, не изменяющий состояние игры (/api/v1/maps/ например)
             // Вернем method not allowed
             return HandleMethodNotAllowed(
@@ -721,14 +841,14 @@ namespace http_handler {
                 http_version,
                 keep_alive
             );
-        } else if (std::regex_match(path, match, case_game_records)) {
+        } else if (std::regex_match(path.begin(), path.end(), match, case_game_records)) {
             return HandleMethodNotAllowed(
                 "Invalid method"s,
                 "GET, HEAD"s,
                 http_version,
                 keep_alive
             );
-        } else if (std::regex_match(path, match, case_game)) {
+        } else if (std::regex_match(path.begin(), path.end(), match, case_game)) {
             
             if (match[1] == "join"s) {
                 // /api/v1/game/join/ - обрабатываем дальше
@@ -847,7 +967,7 @@ namespace http_handler {
                 // Двигаем собак во всех игровых сессиях
                 return HandleSuccessfullTickRequest(time_delta, http_version, keep_alive);
             }
-        } else if (std::regex_match(path, match, case_player_action)) {
+        } else if (std::regex_match(path.begin(), path.end(), match, case_player_action)) {
             // /api/v1/game/player/action/ - обрабатываем дальше
             if (request_method != http::verb::post) {
                 // /api/v1/game/player/action - METHOD NOT ALLOWED
@@ -885,11 +1005,8 @@ namespace http_handler {
                 );
             }
 
-            // На этом этапе токен точно валидный
-            application::Token token{ auth_header.substr(application::detail::TOKEN_POS_TO_DISCARD_BEARER) };
-
-            // Находим игрока по токену
-            std::shared_ptr<application::Player> player = application_.FindPlayerByToken(token);
+            // На этом этапе формат заголовка валидный, находим игрока по токену
+            std::shared_ptr<application::Player> player = application_.FindPlayerByAuthorization(auth_header);
 
             // Обрабатываем случай, когда игрок по токену не найден
             if (!player) {
@@ -921,6 +1038,13 @@ namespace http_handler {
             // На этом этапе токен валидный, такой игрок есть, JSON валидный
             // Двигаем собаку и возвращаем 200
             return HandleSuccessfullPlayerActionRequest(player, move_direction, http_version, keep_alive);
+        } else if (!admin_token_.empty() && std::regex_match(path.begin(), path.end(), match, case_admin_stats)) {
+            return HandleMethodNotAllowed(
+                "Invalid method"s,
+                "GET, HEAD"s,
+                http_version,
+                keep_alive
+            );
         }
         // bad request к API, который изменяет состояние игры
         return HandleBadRequest("badRequest"s, "Bad request"s, http_version, keep_alive);
@@ -4,8 +4,11 @@
 #include <boost/json.hpp>
 
 #include "response_utils.h"
+#include "admission_control.h"
 #include "application.h"
 #include "model.h"
+#include "metrics.h"
+#include "profiler.h"
 #include <regex>
 #include <memory>
 
@@ -16,6 +19,9 @@ namespace net = boost::asio;
 
 using Strand = net::strand<net::io_context::executor_type>;
 
+// Результат сопоставления пути запроса, который хранится в string_view
+using PathMatch = std::match_results<std::string_view::const_iterator>;
+
 static const std::regex case_maps{ R"(/api/v1/maps/?)" };
 
 static const std::regex case_map{ R"(/api/v1/maps/(.+))" };
@@ -25,87 +31,145 @@ static const std::regex case_game{ R"(/api/v1/game/([^/]+)/?)" };
 static const std::regex case_game_records{R"(/api/v1/game/records(?:\?([^#]+)?)?)"};
 
 static const std::regex case_player_action{ R"(/api/v1/game/player/action/?)" };
+
+static const std::regex case_admin_stats{ R"(/api/v1/admin/stats/?)" };
 // Допустимые значения для поля "move" запроса /api/v1/game/player/action/
 static const std::unordered_set<std::string> valid_directions = { "U"s, "D"s, "R"s, "L"s, ""s };
 
 class ApiRequestHandler : public std::enable_shared_from_this<ApiRequestHandler> {
 public:
 
-    explicit ApiRequestHandler(application::Application& application, Strand api_strand, bool is_tick_needed)
-        : application_{application}, api_strand_{std::move(api_strand)}, is_tick_needed_(is_tick_needed) {
+    explicit ApiRequestHandler(application::Application& application, Strand api_strand, bool is_tick_needed,
+        std::shared_ptr<http_server::AdmissionControl> admission = nullptr)
+        : application_{application}, api_strand_{std::move(api_strand)}, is_tick_needed_(is_tick_needed),
+        admission_{std::move(admission)} {
     }
 
-    static std::shared_ptr<ApiRequestHandler> Create(application::Application& app, Strand strand, bool is_tick_needed) {
-        return std::make_shared<ApiRequestHandler>(app, std::move(strand), is_tick_needed);
+    static std::shared_ptr<ApiRequestHandler> Create(application::Application& app, Strand strand, bool is_tick_needed,
+        std::shared_ptr<http_server::AdmissionControl> admission = nullptr) {
+        return std::make_shared<ApiRequestHandler>(app, std::move(strand), is_tick_needed, std::move(admission));
+    }
+
+    // Включает /api/v1/admin/stats, доступный с заголовком "Authorization: Bearer <token>".
+    // Вызывается до запуска сервера. Пока токен не задан, запрос к /api/v1/admin/stats считается неизвестным
+    void SetAdminToken(std::string token) {
+        admin_token_ = std::move(token);
     }
 
     template <typename Body, typename Allocator, typename Send>
     void HandleRequest(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
-        auto http_version = req.version();
-        auto keep_alive = req.keep_alive();
-        std::string auth_header{req[http::field::authorization]};
-        std::string path = std::string(req.target());
-
-        auto shared_req = std::make_shared<http::request<Body, http::basic_fields<Allocator>>>(std::move(req));
-        auto shared_send = std::make_shared<std::decay_t<Send>>(std::forward<Send>(send));
-
-        auto handler = [
-            self = shared_from_this(),
-            shared_send,
-            shared_req,
-            path,
-            auth_header,
-            http_version,
-            keep_alive
-        ]() {
-            try {
-                // Этот assert не выстрелит, так как лямбда-функция будет выполняться внутри strand
-                assert(self->api_strand_.running_in_this_thread());
-                // Получаем различные данные из запроса
-                const std::string request_body = shared_req->body();
-                http::verb request_method = shared_req->method();
-                const std::string content_type = shared_req->count(http::field::content_type) ? std::string(shared_req->at(http::field::content_type)) : "";
-                // Обрабатываем безопасные запросы (не изменяющие состояния игры)
-                if (request_method == http::verb::get || request_method == http::verb::head) {
-                    (*shared_send)(self->HandleSafeApiRequest(
-                        path,
-                        auth_header,
-                        http_version, 
-                        keep_alive
-                    ));
-                } else {
-                    // Обрабатываем запросы изменяющие состояния игры
-                    (*shared_send)(self->HandleChangingApiRequest(
-                        path,
-                        auth_header,
-                        request_body,
-                        request_method,
-                        content_type,
-                        http_version,
-                        keep_alive
-                    ));
-                }
-            } catch (...) {
-                (*shared_send)(ReportServerError(http_version, keep_alive));
-            }
-        };
+        // Безопасные запросы (не изменяющие состояния игры) читают только неизменяемые карты
+        // и опубликованные снимки сессий, поэтому обрабатываются сразу в текущем потоке, минуя strand.
+        // Команды движения только проверяются и ставятся в очередь сессии, применяет их тик,
+        // поэтому strand для них тоже не нужен.
+        // Запрос живёт до конца вызова, так что путь и заголовки читаются без копирования
+        const std::string_view path = req.target();
+
+        if (req.method() == http::verb::get || req.method() == http::verb::head) {
+            HandleRequestInPlace("api.get", req, send, [this](const auto& request) {
+                return HandleSafeApiRequest(
+                    request.target(),
+                    request[http::field::authorization],
+                    request.version(),
+                    request.keep_alive()
+                );
+            });
+            return;
+        }
+        if (std::regex_match(path.begin(), path.end(), case_player_action)) {
+            HandleRequestInPlace("api.action", req, send, [this](const auto& request) {
+                return HandleChangingApiRequest(request);
+            });
+            return;
+        }
+
+        // При перегрузке сбрасываются только запросы, которые встали бы в очередь api_strand.
+        // Чтение снимков, /api/v1/admin/stats и команды движения её не занимают и обслуживаются всегда
+        if (admission_ && admission_->IsOverloaded()) {
+            admission_->OnRequestShed();
+            send(ReportServiceUnavailable(req.version(), req.keep_alive()));
+            return;
+        }
+
+        // Запрос и функция отправки ответа переносятся в strand одним объектом
+        using Pending = PendingRequest<http::request<Body, http::basic_fields<Allocator>>, std::decay_t<Send>>;
+        auto pending = std::make_shared<Pending>(std::forward<Send>(send), std::move(req));
+
         // Ставим в очередь
+        if (admission_) {
+            admission_->OnApiTaskQueued();
+        }
+        const auto queued_at = metrics::IsEnabled() ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
         net::dispatch(
             api_strand_,
-            [handler = std::move(handler)]() mutable {
-                handler();
+            [self = shared_from_this(), pending = std::move(pending), queued_at]() {
+                // Этот assert не выстрелит, так как лямбда-функция будет выполняться внутри strand
+                assert(self->api_strand_.running_in_this_thread());
+                if (self->admission_) {
+                    self->admission_->OnApiTaskStarted();
+                }
+                if (queued_at != std::chrono::steady_clock::time_point{}) {
+                    metrics::Observe(metrics::Histogram::API_QUEUE_WAIT, std::chrono::steady_clock::now() - queued_at);
+                }
+                // Обрабатываем запросы изменяющие состояния игры
+                self->HandleRequestInPlace("api.strand", pending->request, pending->send, [&self](const auto& request) {
+                    return self->HandleChangingApiRequest(request);
+                });
             }
         );
     }
+
+    // Отвечает на запрос /metrics. Число сессий, собак и потерянных предметов на картах
+    // берётся из счётчиков карт, поэтому ответ собирается сразу, минуя api_strand.
+    // Запрос не сбрасывается при перегрузке, чтобы перегрузку было видно в метриках
+    template <typename Body, typename Allocator, typename Send>
+    void HandleMetricsRequest(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
+        if (req.method() != http::verb::get && req.method() != http::verb::head) {
+            send(HandleMethodNotAllowed("Only GET, HEAD method is expected"s, "GET, HEAD"s, req.version(), req.keep_alive()));
+            return;
+        }
+
+        HandleRequestInPlace("api.metrics", req, send, [this](const auto& request) {
+            return HandleMetricsRequest(request.version(), request.keep_alive());
+        });
+    }
+
+    // Выводит текст в формате JSON с красивым форматированием 
+    static void PrettyPrint(std::ostream& os, json::value const& jv, std::string* indent = nullptr);
+
+    // Подготавливает тело JSON ответа - 200 на запрос api/v1/game/players/
+    static std::string BuildSuccessfullPlayersRequestJSON(const application::SessionSnapshot& session);
+
+    // Подготавливает тело JSON ответа - 200 на запрос api/v1/game/state/
+    static std::string BuildSuccessfullStateRequestJSON(const application::SessionSnapshot& session);
     
 private:
+    // Запрос, ожидающий обработки в strand.
+    // send хранит соединение, которому принадлежит память запроса, поэтому request объявлен после него
+    // и разрушается первым
+    template <typename Request, typename Send>
+    struct PendingRequest {
+        template <typename SendArg>
+        PendingRequest(SendArg&& send_arg, Request&& request_arg)
+        : send(std::forward<SendArg>(send_arg)), request(std::move(request_arg))
+        {
+
+        }
+
+        Send send;
+        Request request;
+    };
+
     application::Application& application_;
     Strand api_strand_;
 
     bool is_tick_needed_;
 
-    // Выводит текст в формате JSON с красивым форматированием 
-    void PrettyPrint(std::ostream& os, json::value const& jv, std::string* indent = nullptr);
+    // Контроль нагрузки: глубина очереди api_strand и признак перегрузки для ответа 503
+    std::shared_ptr<http_server::AdmissionControl> admission_;
+
+    // Токен доступа к /api/v1/admin/stats, пустой - запрос отключён
+    std::string admin_token_;
 
     // Подготавливает тело JSON ответа с информацией о всех картах
     std::string BuildAllMapsRequestJSON();
@@ -134,19 +198,13 @@ private:
     std::string BuildUnauthorizedRequestJSON(const std::string& code, const std::string& message);
 
     // Подготавливает StringResponse для not authorized
-    StringResponse HandleUnauthorized(const std::string& auth_header, const std::string& code,
+    StringResponse HandleUnauthorized(std::string_view auth_header, const std::string& code,
         const std::string& message, unsigned http_version, bool keep_alive
     );
 
-    // Подготавливает тело JSON ответа - 200 на запрос api/v1/game/players/
-    std::string BuildSuccessfullPlayersRequestJSON(std::vector<std::shared_ptr<application::Player>> coplayers);
-
     // Подготавливает StringResponse для 200 на запрос api/v1/game/players/
     StringResponse HandleSuccessfullPlayersRequest(std::shared_ptr<application::Player> player, unsigned http_version, bool keep_alive);
 
-    // Подготавливает тело JSON ответа - 200 на запрос api/v1/game/state/
-    std::string BuildSuccessfullStateRequestJSON(std::vector<std::shared_ptr<application::Player>> coplayers);
-
     // Подготавливает StringResponse для 200 на запрос api/v1/game/players/
     StringResponse HandleSuccessfullStateRequest(std::shared_ptr<application::Player> player, unsigned http_version, bool keep_alive);
 
@@ -186,14 +244,58 @@ private:
     
     StringResponse HandleRecordsRequest(const std::unordered_map<std::string, std::string>& params, unsigned http_version, bool keep_alive);
 
+    // Подготавливает тело ответа /metrics: метрики всех потоков, контроль нагрузки и состояние карт
+    std::string BuildMetricsText();
+
+    // Подготавливает StringResponse для /metrics
+    StringResponse HandleMetricsRequest(unsigned http_version, bool keep_alive);
+
+    // Проверяет заголовок Authorization запроса к /api/v1/admin/stats
+    bool IsAdminAuthorized(std::string_view auth_header) const noexcept;
+
+    // Подготавливает тело JSON ответа /api/v1/admin/stats: счётчики и оценки памяти по картам и их суммы
+    std::string BuildAdminStatsJSON();
+
+    // Подготавливает StringResponse для /api/v1/admin/stats
+    StringResponse HandleAdminStatsRequest(unsigned http_version, bool keep_alive);
+
+    // Вызывает handle(req) и отправляет результат, при исключении отвечает 500.
+    // Время подготовки ответа записывается в профилировщик под именем trace_name
+    template <typename Request, typename Send, typename Handle>
+    static void HandleRequestInPlace(const char* trace_name, const Request& req, Send& send, Handle&& handle) {
+        try {
+            auto response = [&] {
+                profiler::Zone zone{trace_name};
+                return handle(req);
+            }();
+            send(std::move(response));
+        } catch (...) {
+            send(ReportServerError(req.version(), req.keep_alive()));
+        }
+    }
+
+    template <typename Request>
+    StringResponse HandleChangingApiRequest(const Request& req) {
+        const auto content_type = req.find(http::field::content_type);
+        return HandleChangingApiRequest(
+            req.target(),
+            req[http::field::authorization],
+            req.body(),
+            req.method(),
+            content_type != req.end() ? content_type->value() : std::string_view{},
+            req.version(),
+            req.keep_alive()
+        );
+    }
+
     // Обрабатывает запросы к API, НЕ изменяющие состояние игры
-    StringResponse HandleSafeApiRequest(const std::string& path, const std::string& auth_header,
+    StringResponse HandleSafeApiRequest(std::string_view path, std::string_view auth_header,
         unsigned http_version, bool keep_alive
     );
 
     // Обрабатывает запросы к API, изменяющие состояние игры
-    StringResponse HandleChangingApiRequest(const std::string& path, const std::string& auth_header,
-        const std::string& request_body, http::verb request_method, const std::string& content_type,
+    StringResponse HandleChangingApiRequest(std::string_view path, std::string_view auth_header,
+        std::string_view request_body, http::verb request_method, std::string_view content_type,
         unsigned http_version, bool keep_alive
     );
 };
@@ -1,80 +1,259 @@
-#include <sstream>
-#include <iomanip>
-
 #include "application.h"
 #include "logger.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
 
 namespace application {
 
 using namespace logger;
 using namespace std::literals;
 
+namespace {
+
+// Добавляет время, прошедшее с предыдущей отметки, к счётчику фазы и возвращает время отметки.
+// Если замер выключен, часы не вызываются
+class PhaseTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit PhaseTimer(bool enabled)
+    : enabled_{enabled}, last_{enabled ? Clock::now() : Clock::time_point{}}
+    {
+
+    }
+
+    Clock::time_point Mark(std::chrono::nanoseconds& phase) {
+        if (!enabled_) {
+            return last_;
+        }
+        const Clock::time_point now = Clock::now();
+        phase += now - last_;
+        last_ = now;
+        return now;
+    }
+
+    Clock::time_point GetLastMark() const noexcept {
+        return last_;
+    }
+
+private:
+    bool enabled_;
+    Clock::time_point last_;
+};
+
+}  // namespace
+
 Token PlayerTokens::AddPlayer(std::shared_ptr<Player> player) {
-	std::stringstream ss;
-	ss << std::hex << std::setfill('0') << 
-		std::setw(16) << generator1_() << 
-		std::setw(16) << generator2_();
-	Token token{ ss.str() };
-	token_to_player_[token] = player;
+	Token token{ generator1_(), generator2_() };
+	SetPlayerToken(token, player);
 	return token;
 }
 
-std::shared_ptr<Player> PlayerTokens::FindPlayerByToken(Token token) {
-	if (token_to_player_.contains(token)) {
-		return token_to_player_.at(token);
+std::shared_ptr<Player> PlayerTokens::FindPlayerByToken(const Token& token) const {
+	std::shared_lock lock{mutex_};
+	if (const std::shared_ptr<Player>* player = token_to_player_.Find(token)) {
+		return *player;
 	}
 	return nullptr;
 }
 
+std::shared_ptr<Player> PlayerTokens::FindPlayerByAuthorization(std::string_view auth_header) const {
+	if (!auth_header.starts_with(detail::TOKEN_STRATS_WITH)) {
+		return nullptr;
+	}
+	std::optional<Token> token = Token::FromHex(auth_header.substr(detail::TOKEN_POS_TO_DISCARD_BEARER));
+	return token ? FindPlayerByToken(*token) : nullptr;
+}
+
+bool PlayerTokens::SetPlayerToken(const Token& token, std::shared_ptr<Player> player) {
+	std::unique_lock lock{mutex_};
+	auto [it, inserted] = player_id_to_token_.insert_or_assign(player->GetId(), token);
+	token_to_player_.InsertOrAssign(token, std::move(player));
+	return inserted;
+}
+
+bool PlayerTokens::RemovePlayer(const Player& player) {
+	std::unique_lock lock{mutex_};
+	if (auto it = player_id_to_token_.find(player.GetId()); it != player_id_to_token_.end()) {
+		token_to_player_.Erase(it->second);
+		player_id_to_token_.erase(it);
+		return true;
+	}
+	return false;
+}
+
+RecordsStorage ParseRecordsStorage(std::string_view name) {
+    if (name == "postgres"sv) {
+        return RecordsStorage::POSTGRES;
+    } else if (name == "memory"sv) {
+        return RecordsStorage::MEMORY;
+    }
+    throw std::invalid_argument("Unknown records storage: "s + std::string(name));
+}
+
+Application::OwnedRecordsStorage Application::OpenRecordsStorage(const AppConfig& config) {
+    OwnedRecordsStorage storage;
+    if (config.records_storage == RecordsStorage::POSTGRES) {
+        storage.db = std::make_unique<postgres::Database>(config.db_url);
+    } else if (config.records_file.empty()) {
+        storage.memory_records = std::make_unique<memory::PlayerRepositoryImpl>();
+    } else {
+        storage.memory_records = std::make_unique<memory::PlayerRepositoryImpl>(config.records_file);
+    }
+    return storage;
+}
+
+std::vector<MapStats> Application::GetMapStats() const {
+    // Узел хеш-таблицы: указатель на следующий узел, значение, закешированный хеш
+    // и указатель на корзину при коэффициенте заполнения не больше 1
+    auto hash_node_bytes = [](size_t value_size) {
+        return 2 * sizeof(void*) + value_size + sizeof(size_t);
+    };
+    // Сессия в Game::map_id_to_sessions_, session_id_to_players_ и session_id_to_snapshot_
+    const size_t session_index_bytes = hash_node_bytes(sizeof(std::shared_ptr<model::GameSession>))
+        + hash_node_bytes(sizeof(GameSessionIdToPlayers::value_type))
+        + hash_node_bytes(sizeof(decltype(session_id_to_snapshot_)::value_type)) + sizeof(PublishedSessionSnapshot);
+    // Игрок создаётся через make_shared, в TokenMap на токен приходится не меньше двух ячеек
+    // при коэффициенте заполнения не больше 1/2. Учитываются также индексы по id игрока и по собаке
+    const size_t token_bytes = sizeof(Player) + 2 * sizeof(long)
+        + 2 * (sizeof(Token) + sizeof(std::shared_ptr<Player>) + alignof(std::shared_ptr<Player>))
+        + hash_node_bytes(sizeof(Player::Id) + sizeof(Token))
+        + hash_node_bytes(sizeof(decltype(player_positions_)::value_type))
+        + hash_node_bytes(sizeof(decltype(dog_id_to_player_)::value_type))
+        + 2 * sizeof(std::shared_ptr<Player>);
+
+    std::vector<MapStats> stats;
+    stats.reserve(game_.GetMaps().size());
+    for (const std::shared_ptr<model::Map>& map : game_.GetMaps()) {
+        const model::MapCounters& counters = map->GetCounters();
+        MapStats& map_stats = stats.emplace_back(MapStats{*map->GetId()});
+        map_stats.sessions = counters.sessions.load(std::memory_order_relaxed);
+        map_stats.dogs = counters.dogs.load(std::memory_order_relaxed);
+        map_stats.lost_objects = counters.lost_objects.load(std::memory_order_relaxed);
+        map_stats.tokens = counters.tokens.load(std::memory_order_relaxed);
+        map_stats.road_index_bytes = map->EstimateRoadIndexBytes();
+        map_stats.sessions_bytes = model::GameSession::EstimateSessionsBytes(
+            map_stats.sessions, map_stats.dogs, map_stats.lost_objects
+        ) + map_stats.sessions * session_index_bytes;
+        map_stats.tokens_bytes = map_stats.tokens * token_bytes;
+    }
+    return stats;
+}
+
 std::shared_ptr<Player> Application::CreatePlayer(const std::string& user_name) {
-    auto player = std::make_shared<Player>(user_name);
-    players_.push_back(player);
-    return player;
+    return std::make_shared<Player>(user_name);
 };
 
 void Application::TiePlayerWithSession(std::shared_ptr<Player> player, std::shared_ptr<model::GameSession> session) {
-	session_id_to_players_[session->GetId()].push_back(player);
 	player->SetGameSession(session);
 	player->SetDog(session->CreateDog(player->GetName()));
+	game_.UpdateSessionOccupancy(session);
+	AddPlayer(std::move(player));
 };
 
 void Application::AddPlayer(std::shared_ptr<Player> player) {
-    players_.push_back(player);
-    session_id_to_players_[player->GetSessionId()].push_back(player);
+    std::shared_ptr<PublishedSessionSnapshot>& session_snapshot = session_id_to_snapshot_[player->GetSessionId()];
+    if (!session_snapshot) {
+        session_snapshot = std::make_shared<PublishedSessionSnapshot>();
+    }
+    player->SetSessionSnapshot(session_snapshot);
+
+    std::vector<std::shared_ptr<Player>>& session_players = session_id_to_players_[player->GetSessionId()];
+    player_positions_[player->GetId()] = PlayerPosition{players_.size(), session_players.size()};
+    if (std::shared_ptr<model::Dog> dog = player->GetDog()) {
+        dog_id_to_player_[dog->GetId()] = player;
+    }
+    session_players.push_back(player);
+    players_.push_back(std::move(player));
 }
 
 std::tuple<Token, Player::Id> Application::JoinGame(const std::string& user_name, const model::Map::Id& map_id) {
 	std::shared_ptr<Player> player = CreatePlayer(user_name);
-    Token token = player_tokens_.AddPlayer(player);
     std::shared_ptr<model::GameSession> game_session = game_.FindSession(map_id);
     if(!game_session){
         game_session = std::make_shared<model::GameSession>(
             game_.FindMap(map_id),
-            std::make_shared<extra_data::LootTypes>(game_.GetLootTypes())
+            game_.GetSharedLootTypes(),
+            game_.GetRandomSeed()
         );
         game_.AddSession(map_id, game_session);
     }
     TiePlayerWithSession(player, game_session);
+    PublishSessionSnapshot(*game_session);
+    if (replay_writer_) {
+        replay_writer_->RecordJoin(*player->GetId(), user_name, *map_id);
+    }
+    // Токен выдаётся последним: найденный по нему игрок уже полностью связан с сессией
+    Token token = player_tokens_.AddPlayer(player);
+    game_session->GetMap()->GetCounters().tokens.fetch_add(1, std::memory_order_relaxed);
     return std::tie(token, player->GetId());
 }
 
-std::vector<std::shared_ptr<Player>> Application::GetCurrentPlayerGameSessionPlayers(std::shared_ptr<Player> player) {
+const std::vector<std::shared_ptr<Player>>& Application::GetCurrentPlayerGameSessionPlayers(std::shared_ptr<Player> player) {
 	model::GameSession::Id session_id = player->GetSessionId();
 	return session_id_to_players_[session_id];
 }
 
+void Application::MovePlayer(const std::shared_ptr<Player>& player, const std::string& move_direction) {
+    player->GetSession()->ScheduleDogMove(player->GetDog(), move_direction);
+}
+
+void Application::PublishSessionSnapshots() {
+    for (const auto& [map_id, sessions] : GetMapIdToSession()) {
+        for (const std::shared_ptr<model::GameSession>& session : sessions) {
+            PublishSessionSnapshot(*session);
+        }
+    }
+}
+
+void Application::PublishSessionSnapshot(const model::GameSession& session) {
+    auto snapshot_it = session_id_to_snapshot_.find(session.GetId());
+    if (snapshot_it == session_id_to_snapshot_.end()) {
+        // В сессии ещё нет игроков, читать её снимок некому
+        return;
+    }
+
+    auto snapshot = std::make_shared<SessionSnapshot>();
+    if (auto players_it = session_id_to_players_.find(session.GetId()); players_it != session_id_to_players_.end()) {
+        snapshot->dogs.reserve(players_it->second.size());
+        for (const std::shared_ptr<Player>& player : players_it->second) {
+            const std::shared_ptr<model::Dog> dog = player->GetDog();
+            SessionSnapshot::DogState& dog_state = snapshot->dogs.emplace_back(SessionSnapshot::DogState{
+                *player->GetId(),
+                player->GetName(),
+                dog->GetDogPosition(),
+                dog->GetDogSpeed(),
+                dog->GetStringDirection(),
+                {},
+                dog->GetScore()
+            });
+            dog_state.bag.reserve(dog->GetBag().Size());
+            for (const model::LostObject& item : dog->GetBag().GetItems()) {
+                dog_state.bag.push_back({*item.GetId(), item.GetType()});
+            }
+        }
+    }
+
+    snapshot->lost_objects.reserve(session.GetLostObjects().size());
+    for (const auto& [id, obj] : session.GetLostObjects()) {
+        snapshot->lost_objects.push_back({*id, obj.GetType(), obj.GetPosition()});
+    }
+
+    snapshot_it->second->Publish(std::move(snapshot));
+}
+
 void Application::RetirePlayer(const std::shared_ptr<model::Dog>& dog) {
     // Находим игрока по собаке
-    auto player_it = std::find_if(players_.begin(), players_.end(),
-        [&dog](std::shared_ptr<application::Player> player) {
-            return player->GetDog() == dog;
-        });
-        
-    if (player_it == players_.end()) {
+    auto dog_it = dog_id_to_player_.find(dog->GetId());
+    if (dog_it == dog_id_to_player_.end()) {
         return;
     }
     
-    std::shared_ptr<application::Player> player = *player_it;
+    std::shared_ptr<application::Player> player = std::move(dog_it->second);
+    dog_id_to_player_.erase(dog_it);
     
     // Записываем рекорд в БД
     try {
@@ -85,6 +264,7 @@ void Application::RetirePlayer(const std::shared_ptr<model::Dog>& dog) {
             play_time_seconds
         );
         
+        profiler::Zone zone{"db.retire_player"};
         use_cases_.RetirePlayer(retired_player);
     } catch (const std::exception& e) {
         // Логируем ошибку, но не прерываем выполнение
@@ -94,72 +274,208 @@ void Application::RetirePlayer(const std::shared_ptr<model::Dog>& dog) {
     // Удаляем токен игрока
     RemovePlayerToken(player);
     
-    // Удаляем игрока из сессии
+    // Удаляем игрока из сессии и из основного списка
     RemovePlayerFromSession(player);
-    
-    // Удаляем игрока из основного списка
-    players_.erase(player_it);
 }
 
 void Application::RemovePlayerToken(const std::shared_ptr<Player>& player) {
-    auto& tokens = player_tokens_.GetMutableTokenToPlayer();
-    for (auto it = tokens.begin(); it != tokens.end(); ) {
-        if (it->second == player) {
-            it = tokens.erase(it);
-        } else {
-            ++it;
-        }
+    if (player_tokens_.RemovePlayer(*player)) {
+        player->GetSession()->GetMap()->GetCounters().tokens.fetch_sub(1, std::memory_order_relaxed);
     }
 }
 
 void Application::RemovePlayerFromSession(const std::shared_ptr<Player>& player) {
-    auto session_id = player->GetSessionId();
-    if (session_id_to_players_.count(session_id)) {
-        std::vector<std::shared_ptr<Player>>& session_players = session_id_to_players_.at(session_id);
-        session_players.erase(
-            std::remove(session_players.begin(), session_players.end(), player),
-            session_players.end()
-        );
+    auto position_it = player_positions_.find(player->GetId());
+    if (position_it == player_positions_.end()) {
+        return;
+    }
+    const PlayerPosition position = position_it->second;
+    player_positions_.erase(position_it);
+
+    // Удаляем за O(1): на место игрока переносим последний элемент и обновляем его позицию
+    if (auto session_it = session_id_to_players_.find(player->GetSessionId()); session_it != session_id_to_players_.end()) {
+        std::vector<std::shared_ptr<Player>>& session_players = session_it->second;
+        if (position.in_session + 1 != session_players.size()) {
+            session_players[position.in_session] = std::move(session_players.back());
+            player_positions_.at(session_players[position.in_session]->GetId()).in_session = position.in_session;
+        }
+        session_players.pop_back();
+    }
+
+    if (position.in_players + 1 != players_.size()) {
+        players_[position.in_players] = std::move(players_.back());
+        player_positions_.at(players_[position.in_players]->GetId()).in_players = position.in_players;
     }
+    players_.pop_back();
 }
 
-void Application::Tick(std::chrono::milliseconds time_delta) {
-    const std::chrono::milliseconds retirement_time = game_.GetMaxInactivityTime();
-	const model::Game::MapIdToSessions& map_to_sessions = GetMapIdToSession();
-	for (auto it = map_to_sessions.begin(); it != map_to_sessions.end(); ++it) {
-		for (std::shared_ptr<model::GameSession> session : it->second) {
-			// Сохраняем предыдущие позиции собак
-            for (std::shared_ptr<model::Dog> dog : session->GetDogs()) {
-                dog->SetPrevPosition(dog->GetDogPosition());
+uint64_t Application::ComputeStateHash() const {
+    auto combine = [](uint64_t hash, uint64_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+        return hash * 0xff51afd7ed558ccdull;
+    };
+    // Хеши объектов складываются, поэтому порядок обхода unordered-контейнеров не важен
+    uint64_t state_hash = 0;
+    for (const auto& [map_id, sessions] : GetMapIdToSession()) {
+        for (const std::shared_ptr<model::GameSession>& session : sessions) {
+            const uint64_t session_id = *session->GetId();
+            for (const std::shared_ptr<model::Dog>& dog : session->GetDogs()) {
+                uint64_t hash = combine(session_id, *dog->GetId());
+                hash = combine(hash, std::bit_cast<uint64_t>(dog->GetDogPosition().x));
+                hash = combine(hash, std::bit_cast<uint64_t>(dog->GetDogPosition().y));
+                hash = combine(hash, std::bit_cast<uint64_t>(dog->GetDogSpeed().v_x));
+                hash = combine(hash, std::bit_cast<uint64_t>(dog->GetDogSpeed().v_y));
+                hash = combine(hash, static_cast<uint64_t>(dog->GetScore()));
+                hash = combine(hash, dog->GetBag().Size());
+                state_hash += hash;
             }
-            
-            // Обновление позиций собак
-            for (std::shared_ptr<model::Dog> dog : session->GetDogs()) {
-                dog->MoveDogByTick(time_delta.count(), session->GetMap()->GetPointToRoadSegments());
+            for (const auto& [id, object] : session->GetLostObjects()) {
+                uint64_t hash = combine(session_id, *id);
+                hash = combine(hash, object.GetType());
+                hash = combine(hash, std::bit_cast<uint64_t>(object.GetPosition().x));
+                hash = combine(hash, std::bit_cast<uint64_t>(object.GetPosition().y));
+                state_hash += hash;
             }
+        }
+    }
+    return state_hash;
+}
 
-            // Удаляем неактивных собак и их игроков
-            std::vector<std::shared_ptr<model::Dog>> inactive_dogs = session->RemoveInactiveDogs(retirement_time);
-            for (std::shared_ptr<model::Dog> dog : inactive_dogs) {
-                RetirePlayer(dog);
-            }
+void Application::Tick(std::chrono::milliseconds time_delta) {
+    profiler::Zone zone{"tick"};
+    if (fixed_time_step_ > std::chrono::milliseconds::zero()) {
+        // Игровое время продвигается шагами одинаковой длины независимо от того, с какой частотой
+        // и с какими интервалами вызывается Tick. Остаток переходит в следующий тик
+        unsimulated_time_ += time_delta;
+        bool apply_moves = true;
+        while (unsimulated_time_ >= fixed_time_step_) {
+            unsimulated_time_ -= fixed_time_step_;
+            UpdateGameState(fixed_time_step_, apply_moves);
+            apply_moves = false;
+        }
+    } else {
+        UpdateGameState(time_delta, true);
+    }
 
-            // Обработка коллизий
-            session->HandleCollisions();
+    if (replay_writer_) {
+        // Команды, применённые в этом тике, уже записаны, тик записывается после них
+        replay_writer_->RecordTick(time_delta);
+        if (replay_writer_->IsStateHashDue()) {
+            replay_writer_->RecordStateHash(ComputeStateHash());
+        }
+    }
 
-			// Генерация новых потерянных предметов
-            unsigned loot_amount = session->GetLostObjects().size();
-            unsigned looter_amount = session->GetDogs().size();
-            unsigned new_loot = loot_generator_.Generate(time_delta, loot_amount, looter_amount);
-            
-            if (new_loot > 0) {
-                session->GenerateLoot(new_loot);
-            }
-		}
-	}
     if (listener_) {
+        profiler::Zone listener_zone{"tick.listener"};
         listener_->OnTick(time_delta);
     }
 }
 
+void Application::UpdateGameState(std::chrono::milliseconds time_delta, bool apply_moves) {
+    const std::chrono::milliseconds retirement_time = game_.GetMaxInactivityTime();
+
+    tick_sessions_.clear();
+    for (const auto& [map_id, sessions] : GetMapIdToSession()) {
+        tick_sessions_.insert(tick_sessions_.end(), sessions.begin(), sessions.end());
+    }
+    if (is_deterministic_) {
+        // Порядок обхода unordered_set зависит от адресов сессий, а от порядка обработки
+        // зависят id новых предметов и порядок сессий в SessionMatchmaker
+        std::sort(tick_sessions_.begin(), tick_sessions_.end(), [](const auto& lhs, const auto& rhs) {
+            return *lhs->GetId() < *rhs->GetId();
+        });
+    }
+
+    model::GameSession::MoveObserver record_move;
+    if (replay_writer_) {
+        record_move = [this](const model::Dog& dog, const std::string& direction) {
+            if (auto it = dog_id_to_player_.find(dog.GetId()); it != dog_id_to_player_.end()) {
+                replay_writer_->RecordMove(*it->second->GetId(), direction);
+            }
+        };
+    }
+
+    loot_sessions_.clear();
+    loot_requests_.clear();
+
+    PhaseTimer phase_timer{is_phase_timing_enabled_ || profiler::IsEnabled()};
+    const PhaseTimer::Clock::time_point sessions_start = phase_timer.GetLastMark();
+    const TickPhaseTimes times_before_step = phase_times_;
+	for (const std::shared_ptr<model::GameSession>& session : tick_sessions_) {
+		// Применяем команды игроков, накопленные с прошлого тика
+        if (apply_moves) {
+            session->ApplyScheduledMoves(record_move);
+        }
+
+		// Сохраняем предыдущие позиции собак
+        for (std::shared_ptr<model::Dog> dog : session->GetDogs()) {
+            dog->SetPrevPosition(dog->GetDogPosition());
+        }
+        
+        // Обновление позиций собак
+        for (std::shared_ptr<model::Dog> dog : session->GetDogs()) {
+            dog->MoveDogByTick(time_delta.count(), session->GetMap()->GetPointToRoadSegments());
+        }
+        phase_timer.Mark(phase_times_.move);
+
+        // Удаляем неактивных собак и их игроков
+        std::vector<std::shared_ptr<model::Dog>> inactive_dogs = session->RemoveInactiveDogs(retirement_time);
+        for (std::shared_ptr<model::Dog> dog : inactive_dogs) {
+            RetirePlayer(dog);
+        }
+        if (!inactive_dogs.empty()) {
+            // В сессии освободились места
+            game_.UpdateSessionOccupancy(session);
+        }
+        phase_timer.Mark(phase_times_.retire);
+
+        // Обработка коллизий
+        session->HandleCollisions();
+        phase_timer.Mark(phase_times_.collide);
+
+        // Запоминаем сессию для пакетной генерации трофеев
+        loot_sessions_.push_back(session.get());
+        loot_requests_.push_back({
+            &session->GetLootGeneratorState(),
+            static_cast<unsigned>(session->GetLostObjects().size()),
+            static_cast<unsigned>(session->GetDogs().size())
+        });
+        phase_timer.Mark(phase_times_.loot);
+	}
+
+    // Генерация новых потерянных предметов сразу для всех сессий
+    generated_loot_.resize(loot_requests_.size());
+    loot_generator_.Generate(time_delta, loot_requests_, generated_loot_);
+    for (size_t i = 0; i < loot_sessions_.size(); ++i) {
+        if (generated_loot_[i] > 0) {
+            loot_sessions_[i]->GenerateLoot(generated_loot_[i]);
+        }
+    }
+    const PhaseTimer::Clock::time_point loot_end = phase_timer.Mark(phase_times_.loot);
+
+    // Публикуем состояние, которое увидят GET-запросы до следующего тика
+    for (const model::GameSession* session : loot_sessions_) {
+        PublishSessionSnapshot(*session);
+    }
+    const PhaseTimer::Clock::time_point publish_end = phase_timer.Mark(phase_times_.publish);
+
+    if (profiler::IsEnabled()) {
+        // Фазы чередуются по сессиям, поэтому за шаг записывается по одному интервалу на фазу:
+        // суммарное время фазы во всех сессиях. Интервалы идут подряд от начала обхода сессий,
+        // их длительности точные, а границы между ними условные
+        PhaseTimer::Clock::time_point phase_start = sessions_start;
+        auto record_phase = [&phase_start](const char* name, PhaseTimer::Clock::time_point phase_end) {
+            profiler::Record(name, phase_start, phase_end);
+            phase_start = phase_end;
+        };
+        record_phase("tick.move", phase_start + (phase_times_.move - times_before_step.move));
+        record_phase("tick.retire", phase_start + (phase_times_.retire - times_before_step.retire));
+        record_phase("tick.collide", phase_start + (phase_times_.collide - times_before_step.collide));
+        // Сюда входит и подготовка запросов генерации в обходе сессий
+        record_phase("tick.loot", loot_end);
+        record_phase("tick.publish", publish_end);
+    }
+    ++phase_times_.steps;
+}
+
 } // namespace application
\ No newline at end of file
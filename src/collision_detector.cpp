@@ -2,6 +2,10 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <tuple>
 #include <vector>
 
 namespace collision_detector {
@@ -25,9 +29,40 @@ CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D
     return CollectionResult(sq_distance, proj_ratio);
 }
 
-std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
-    std::vector<GatheringEvent> events;
+namespace {
+
+// Проверяет, подбирает ли собиратель предмет, и при необходимости добавляет событие
+void TryGather(const Gatherer& gatherer, size_t gatherer_id, const Item& item, size_t item_id,
+    std::vector<GatheringEvent>& events
+) {
+    // Проверяем возможность сбора точки
+    auto collect_result = TryCollectPoint(
+        gatherer.start_pos, 
+        gatherer.end_pos, 
+        item.position
+    );
+
+    // Проверяем попадание в область сбора
+    double total_radius = gatherer.width + item.width;
+    if (collect_result.IsCollected(total_radius)) {
+        events.push_back({
+            item_id,
+            gatherer_id,
+            collect_result.sq_distance,
+            collect_result.proj_ratio
+        });
+    }
+}
+
+void SortEventsByTime(std::vector<GatheringEvent>& events) {
+    // Сортируем события по времени (proj_ratio)
+    std::sort(events.begin(), events.end(), [](const GatheringEvent& lhs, const GatheringEvent& rhs) {
+        return lhs.time < rhs.time;
+    });
+}
 
+// Проверяет каждую пару собиратель-предмет
+void FindAllGatherEvents(const ItemGathererProvider& provider, std::vector<GatheringEvent>& events) {
     for (size_t gatherer_id = 0; gatherer_id < provider.GatherersCount(); ++gatherer_id) {
         const auto gatherer = provider.GetGatherer(gatherer_id);
         
@@ -37,34 +72,120 @@ std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provide
         }
 
         for (size_t item_id = 0; item_id < provider.ItemsCount(); ++item_id) {
-            const auto item = provider.GetItem(item_id);
-            
-            // Проверяем возможность сбора точки
-            auto collect_result = TryCollectPoint(
-                gatherer.start_pos, 
-                gatherer.end_pos, 
-                item.position
-            );
-
-            // Проверяем попадание в область сбора
-            double total_radius = gatherer.width + item.width;
-            if (collect_result.IsCollected(total_radius)) {
-                events.push_back({
-                    item_id,
-                    gatherer_id,
-                    collect_result.sq_distance,
-                    collect_result.proj_ratio
-                });
-            }
+            TryGather(gatherer, gatherer_id, provider.GetItem(item_id), item_id, events);
         }
     }
+}
 
-    // Сортируем события по времени (proj_ratio)
-    std::sort(events.begin(), events.end(), [](const GatheringEvent& lhs, const GatheringEvent& rhs) {
-        return lhs.time < rhs.time;
-    });
+// Ключ ячейки сетки: координаты со смещением в старшей и младшей половинах числа.
+// Каждой ячейке соответствует свой ключ, а смещение сохраняет порядок,
+// поэтому ячейки столбца с одинаковой cx упорядочены по cy и идут подряд
+uint64_t GetCellKey(int32_t cx, int32_t cy) noexcept {
+    constexpr uint32_t BIAS = 0x8000'0000u;
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx) ^ BIAS) << 32) | (static_cast<uint32_t>(cy) ^ BIAS);
+}
+
+}  // namespace
+
+std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
+    std::vector<GatheringEvent> events;
+    FindAllGatherEvents(provider, events);
+    SortEventsByTime(events);
 
     return events;
 }
 
+ItemGrid::ItemGrid(double cell_size)
+: cell_size_(cell_size)
+{
+    assert(cell_size > 0.0);
+}
+
+int32_t ItemGrid::GetCellCoord(double coord) const noexcept {
+    const double cell = std::floor(coord / cell_size_);
+    return static_cast<int32_t>(std::clamp(
+        cell,
+        static_cast<double>(std::numeric_limits<int32_t>::min()),
+        static_cast<double>(std::numeric_limits<int32_t>::max())
+    ));
+}
+
+const std::vector<GatheringEvent>& ItemGrid::FindGatherEvents(const ItemGathererProvider& provider) {
+    events_.clear();
+
+    const size_t items_count = provider.ItemsCount();
+    if (items_count * provider.GatherersCount() <= LINEAR_SEARCH_MAX_PAIRS) {
+        FindAllGatherEvents(provider, events_);
+        SortEventsByTime(events_);
+        return events_;
+    }
+
+    // Раскладываем предметы по ячейкам
+    items_.clear();
+    cells_.clear();
+    items_.reserve(items_count);
+    cells_.reserve(items_count);
+    double max_item_width = 0.0;
+    for (size_t item_id = 0; item_id < items_count; ++item_id) {
+        const Item& item = items_.emplace_back(provider.GetItem(item_id));
+        max_item_width = std::max(max_item_width, item.width);
+        cells_.push_back({GetCellKey(GetCellCoord(item.position.x), GetCellCoord(item.position.y)), item_id});
+    }
+    std::sort(cells_.begin(), cells_.end(), [](const CellItem& lhs, const CellItem& rhs) {
+        return std::tie(lhs.cell_key, lhs.item_id) < std::tie(rhs.cell_key, rhs.item_id);
+    });
+
+    for (size_t gatherer_id = 0; gatherer_id < provider.GatherersCount(); ++gatherer_id) {
+        const auto gatherer = provider.GetGatherer(gatherer_id);
+
+        // Пропускаем неподвижных собирателей
+        if (gatherer.start_pos == gatherer.end_pos) {
+            continue;
+        }
+
+        // Ячейки, которые может задеть собиратель на своём пути
+        const double reach = gatherer.width + max_item_width;
+        const int64_t min_cx = GetCellCoord(std::min(gatherer.start_pos.x, gatherer.end_pos.x) - reach);
+        const int64_t max_cx = GetCellCoord(std::max(gatherer.start_pos.x, gatherer.end_pos.x) + reach);
+        const int32_t min_cy = GetCellCoord(std::min(gatherer.start_pos.y, gatherer.end_pos.y) - reach);
+        const int32_t max_cy = GetCellCoord(std::max(gatherer.start_pos.y, gatherer.end_pos.y) + reach);
+
+        // Если путь задевает больше ячеек, чем есть предметов, дешевле проверить все предметы
+        const double cells_on_path = static_cast<double>(max_cx - min_cx + 1) * static_cast<double>(max_cy - min_cy + 1);
+        if (cells_on_path > static_cast<double>(items_count)) {
+            for (size_t item_id = 0; item_id < items_count; ++item_id) {
+                TryGather(gatherer, gatherer_id, items_[item_id], item_id, events_);
+            }
+            continue;
+        }
+
+        // Ячейки одного столбца идут в cells_ подряд, поэтому на столбец нужен один двоичный поиск
+        candidates_.clear();
+        for (int64_t cx = min_cx; cx <= max_cx; ++cx) {
+            const uint64_t first_key = GetCellKey(static_cast<int32_t>(cx), min_cy);
+            const uint64_t last_key = GetCellKey(static_cast<int32_t>(cx), max_cy);
+            auto it = std::lower_bound(cells_.begin(), cells_.end(), first_key, [](const CellItem& cell, uint64_t key) {
+                return cell.cell_key < key;
+            });
+            for (; it != cells_.end() && it->cell_key <= last_key; ++it) {
+                candidates_.push_back(it->item_id);
+            }
+        }
+        // Сохраняем порядок проверки предметов таким же, как в FindGatherEvents
+        std::sort(candidates_.begin(), candidates_.end());
+        for (size_t item_id : candidates_) {
+            TryGather(gatherer, gatherer_id, items_[item_id], item_id, events_);
+        }
+    }
+
+    SortEventsByTime(events_);
+
+    return events_;
+}
+
+std::vector<GatheringEvent> FindGatherEventsInGrid(const ItemGathererProvider& provider, double cell_size) {
+    ItemGrid grid{cell_size};
+    return grid.FindGatherEvents(provider);
+}
+
 }  // namespace collision_detector
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "geom.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <vector>
 
 namespace collision_detector {
@@ -54,4 +55,37 @@ struct GatheringEvent {
 
 std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
 
+// Поиск событий сбора, при котором предметы раскладываются по ячейкам сетки со стороной cell_size,
+// и для каждого собирателя проверяются только предметы из ячеек вдоль его пути.
+// Стоимость в расчёте на одного собирателя не зависит от общего количества предметов.
+// Буферы сетки переиспользуются между вызовами
+class ItemGrid {
+public:
+    explicit ItemGrid(double cell_size);
+
+    // Находит те же события, что FindGatherEvents. Результат действителен до следующего вызова
+    const std::vector<GatheringEvent>& FindGatherEvents(const ItemGathererProvider& provider);
+
+private:
+    // При малом числе пар собиратель-предмет полный перебор дешевле построения сетки
+    static constexpr size_t LINEAR_SEARCH_MAX_PAIRS = 1024;
+
+    // Предмет в ячейке. Упорядочены по ключу ячейки, затем по номеру предмета
+    struct CellItem {
+        uint64_t cell_key;
+        size_t item_id;
+    };
+
+    int32_t GetCellCoord(double coord) const noexcept;
+
+    double cell_size_;
+    std::vector<Item> items_;
+    std::vector<CellItem> cells_;
+    std::vector<size_t> candidates_;
+    std::vector<GatheringEvent> events_;
+};
+
+// То же, что ItemGrid::FindGatherEvents, со временной сеткой
+std::vector<GatheringEvent> FindGatherEventsInGrid(const ItemGathererProvider& provider, double cell_size);
+
 }  // namespace collision_detector
\ No newline at end of file
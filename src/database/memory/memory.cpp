@@ -0,0 +1,160 @@
+#include "memory.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+
+#include "../../metrics.h"
+
+namespace memory {
+
+using namespace std::literals;
+
+namespace {
+
+// Формат файла: по строке на рекорд, поля "очки\tвремя игры\tимя" разделены табуляцией.
+// Табуляция, перевод строки и обратная косая черта в имени экранируются
+void WriteRecord(std::ostream& out, const domain::Player& player) {
+    char buffer[64];
+    char* end = std::to_chars(buffer, buffer + sizeof(buffer), player.GetScore()).ptr;
+    *end++ = '\t';
+    // Кратчайшее представление, из которого читается то же значение
+    end = std::to_chars(end, buffer + sizeof(buffer), player.GetPlayTime()).ptr;
+    *end++ = '\t';
+    out.write(buffer, end - buffer);
+    for (char c : player.GetName()) {
+        switch (c) {
+            case '\\': out << "\\\\"sv; break;
+            case '\t': out << "\\t"sv; break;
+            case '\n': out << "\\n"sv; break;
+            default: out << c;
+        }
+    }
+    out << '\n';
+}
+
+domain::Player ParseRecord(std::string_view line, size_t line_number) {
+    auto malformed = [line_number] {
+        return std::runtime_error("Malformed record at line "s + std::to_string(line_number));
+    };
+
+    size_t score = 0;
+    auto [score_end, score_ec] = std::from_chars(line.data(), line.data() + line.size(), score);
+    if (score_ec != std::errc{} || score_end == line.data() + line.size() || *score_end != '\t') {
+        throw malformed();
+    }
+    line.remove_prefix(score_end - line.data() + 1);
+
+    double play_time = 0.0;
+    auto [time_end, time_ec] = std::from_chars(line.data(), line.data() + line.size(), play_time);
+    if (time_ec != std::errc{} || time_end == line.data() + line.size() || *time_end != '\t') {
+        throw malformed();
+    }
+    line.remove_prefix(time_end - line.data() + 1);
+
+    std::string name;
+    name.reserve(line.size());
+    for (size_t i = 0; i < line.size(); ++i) {
+        if (line[i] != '\\') {
+            name.push_back(line[i]);
+            continue;
+        }
+        if (++i == line.size()) {
+            throw malformed();
+        }
+        switch (line[i]) {
+            case '\\': name.push_back('\\'); break;
+            case 't': name.push_back('\t'); break;
+            case 'n': name.push_back('\n'); break;
+            default: throw malformed();
+        }
+    }
+    return domain::Player{std::move(name), score, play_time};
+}
+
+}  // namespace
+
+bool PlayerRepositoryImpl::RecordOrder::operator()(const domain::Player& lhs, const domain::Player& rhs) const noexcept {
+    if (lhs.GetScore() != rhs.GetScore()) {
+        return lhs.GetScore() > rhs.GetScore();
+    }
+    if (lhs.GetPlayTime() != rhs.GetPlayTime()) {
+        return lhs.GetPlayTime() < rhs.GetPlayTime();
+    }
+    return lhs.GetName() < rhs.GetName();
+}
+
+PlayerRepositoryImpl::PlayerRepositoryImpl(const std::filesystem::path& records_file) {
+    if (std::filesystem::exists(records_file)) {
+        LoadRecords(records_file);
+    }
+    records_file_.open(records_file, std::ios::binary | std::ios::app);
+    if (!records_file_) {
+        throw std::runtime_error("Failed to open records file "s + records_file.string());
+    }
+}
+
+void PlayerRepositoryImpl::LoadRecords(const std::filesystem::path& records_file) {
+    std::ifstream in{records_file, std::ios::binary};
+    if (!in) {
+        throw std::runtime_error("Failed to open records file "s + records_file.string());
+    }
+
+    std::string line;
+    size_t line_number = 0;
+    // Размер файла до конца последней полной строки
+    std::streamoff complete_size = 0;
+    while (std::getline(in, line)) {
+        if (in.eof()) {
+            // У последней строки нет перевода строки: запись была прервана
+            break;
+        }
+        records_.insert(ParseRecord(line, ++line_number));
+        complete_size = in.tellg();
+    }
+    in.close();
+
+    if (static_cast<std::uintmax_t>(complete_size) != std::filesystem::file_size(records_file)) {
+        // Иначе новые рекорды дописывались бы в конец оборванной строки
+        std::filesystem::resize_file(records_file, static_cast<std::uintmax_t>(complete_size));
+    }
+}
+
+void PlayerRepositoryImpl::RetirePlayer(const domain::Player& player) {
+    metrics::ScopedTimer timer{metrics::Histogram::DB_RETIRE_PLAYER};
+    std::unique_lock lock{mutex_};
+    if (records_file_.is_open()) {
+        WriteRecord(records_file_, player);
+        records_file_.flush();
+        if (!records_file_) {
+            throw std::runtime_error("Failed to write records file"s);
+        }
+    }
+    records_.insert(player);
+}
+
+std::vector<domain::Player> PlayerRepositoryImpl::GetRecordsTable(size_t offset, size_t limit) const {
+    metrics::ScopedTimer timer{metrics::Histogram::DB_GET_RECORDS};
+    std::shared_lock lock{mutex_};
+    std::vector<domain::Player> players;
+    if (offset >= records_.size()) {
+        return players;
+    }
+    // Сдвиг по дереву линейный, но таблица рекордов запрашивается постранично с начала
+    auto it = std::next(records_.begin(), static_cast<std::ptrdiff_t>(offset));
+    players.reserve(std::min(limit, records_.size() - offset));
+    for (; it != records_.end() && players.size() < limit; ++it) {
+        players.push_back(*it);
+    }
+    return players;
+}
+
+size_t PlayerRepositoryImpl::GetSize() const {
+    std::shared_lock lock{mutex_};
+    return records_.size();
+}
+
+}  // namespace memory
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "../domain/player_repository.h"
+
+namespace memory {
+
+// Рекорды выбывших игроков в памяти процесса, упорядоченные так же, как таблица рекордов в PostgreSQL.
+// Если задан файл, рекорды загружаются из него при запуске и дописываются в его конец при выбывании игроков
+class PlayerRepositoryImpl : public domain::PlayerRepository {
+public:
+    PlayerRepositoryImpl() = default;
+
+    // Загружает рекорды из records_file, если он существует. Недописанная последняя строка
+    // (сервер остановился во время записи) отбрасывается
+    explicit PlayerRepositoryImpl(const std::filesystem::path& records_file);
+
+    void RetirePlayer(const domain::Player& player) override;
+    std::vector<domain::Player> GetRecordsTable(size_t offset, size_t limit) const override;
+
+    size_t GetSize() const;
+
+private:
+    // Очки по убыванию, затем время игры и имя по возрастанию
+    struct RecordOrder {
+        bool operator()(const domain::Player& lhs, const domain::Player& rhs) const noexcept;
+    };
+
+    void LoadRecords(const std::filesystem::path& records_file);
+
+    // Таблицу рекордов GET-запросы читают параллельно с добавлением рекордов из api_strand
+    mutable std::shared_mutex mutex_;
+    std::multiset<domain::Player, RecordOrder> records_;
+    // Открыт, только если рекорды сохраняются в файл
+    std::ofstream records_file_;
+};
+
+}  // namespace memory
@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include <iostream>
 #include "../../logger.h"
+#include "../../metrics.h"
 
 namespace postgres {
 
@@ -39,6 +40,7 @@ Database::Database(const std::string& db_url)
 }
 
 void PlayerRepositoryImpl::RetirePlayer(const domain::Player& player) {
+    metrics::ScopedTimer timer{metrics::Histogram::DB_RETIRE_PLAYER};
     postgres::ConnectionPool::ConnectionWrapper conn = connection_pool_.GetConnection();
     {
         pqxx::work work{*conn};
@@ -53,6 +55,7 @@ void PlayerRepositoryImpl::RetirePlayer(const domain::Player& player) {
 }
 
 std::vector<domain::Player> PlayerRepositoryImpl::GetRecordsTable(size_t offset, size_t limit) const {
+    metrics::ScopedTimer timer{metrics::Histogram::DB_GET_RECORDS};
     postgres::ConnectionPool::ConnectionWrapper conn = connection_pool_.GetConnection();
     std::vector<domain::Player> players;
     {
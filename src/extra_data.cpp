@@ -3,15 +3,22 @@
 namespace extra_data {
 
 void LootTypes::AddLootTypes(std::string map_id, const json::array& loot_types_arr) {
+    std::vector<LootType>& map_loot_types = map_id_to_loot_types_[map_id];
+    LootValues& map_loot_values = map_id_to_loot_values_[map_id];
     for (const json::value& loot_type_value : loot_types_arr) {
-        map_id_to_loot_types_[map_id].push_back(CreateLootType(loot_type_value));
+        map_loot_types.push_back(CreateLootType(loot_type_value));
+        map_loot_values.push_back(map_loot_types.back().value);
     }
 }
 
-const std::vector<LootTypes::LootType>& LootTypes::GetCurrentMapLootTypes(std::string map_id) const {
+const std::vector<LootTypes::LootType>& LootTypes::GetCurrentMapLootTypes(const std::string& map_id) const {
     return map_id_to_loot_types_.at(map_id);
 }
 
+const LootTypes::LootValues& LootTypes::GetCurrentMapLootValues(const std::string& map_id) const {
+    return map_id_to_loot_values_.at(map_id);
+}
+
 LootTypes::LootType LootTypes::CreateLootType(const json::value& loot_type_value) {
     LootType loot_type;
     try {
@@ -36,7 +43,7 @@ LootTypes::LootType LootTypes::CreateLootType(const json::value& loot_type_value
 }
 
 int64_t LootTypes::GetLootTypeValue(const std::string& map_id, size_t type) const {
-    return GetCurrentMapLootTypes(map_id).at(type).value;
+    return GetCurrentMapLootValues(map_id).at(type);
 }
 
 } // namespace extra_data
\ No newline at end of file
@@ -25,15 +25,21 @@ public:
         int64_t value;
     };
 
+    // Таблица ценностей предметов карты, индексируется типом предмета
+    using LootValues = std::vector<int64_t>;
+
     void AddLootTypes(std::string map_id, const json::array& loot_types_arr);
 
-    const std::vector<LootType>& GetCurrentMapLootTypes(std::string map_id) const;
+    const std::vector<LootType>& GetCurrentMapLootTypes(const std::string& map_id) const;
+
+    const LootValues& GetCurrentMapLootValues(const std::string& map_id) const;
 
     int64_t GetLootTypeValue(const std::string& map_id, size_t type) const;
 
 private:
 
     std::unordered_map<std::string, std::vector<LootType>> map_id_to_loot_types_;
+    std::unordered_map<std::string, LootValues> map_id_to_loot_values_;
 
     LootType CreateLootType(const json::value& loot_type_value);
 
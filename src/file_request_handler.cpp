@@ -1,65 +1,244 @@
 #include "file_request_handler.h"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <optional>
+#include <sstream>
+
 namespace http_handler {
 
-fs::path FileRequestHandler::DecodePath(std::string path) {
-    std::ostringstream decoded_stream;
-    for (size_t i = 0; i < path.size(); ++i) {
-        if (path[i] == '%' && i + 2 < path.size()) {
-            std::string hex_str = path.substr(i + 1, 2);
-            char decoded_char = static_cast<char>(std::strtol(hex_str.c_str(), nullptr, 16));
-            decoded_stream << decoded_char;
+namespace {
+
+constexpr std::array<std::pair<std::string_view, std::string_view>, 19> FILE_EXTENSION_TO_CONTENT_TYPE{{
+    {".htm"sv, ContentType::TEXT_HTML},
+    {".html"sv, ContentType::TEXT_HTML},
+    {".css"sv, ContentType::TEXT_CSS},
+    {".txt"sv, ContentType::TEXT_PLAIN},
+    {".js"sv, ContentType::TEXT_JAVASCRIPT},
+    {".json"sv, ContentType::APPLICATION_JSON},
+    {".xml"sv, ContentType::APPLICATION_XML},
+    {".png"sv, ContentType::IMAGE_PNG},
+    {".jpg"sv, ContentType::IMAGE_JPEG},
+    {".jpe"sv, ContentType::IMAGE_JPEG},
+    {".jpeg"sv, ContentType::IMAGE_JPEG},
+    {".gif"sv, ContentType::IMAGE_GIF},
+    {".bmp"sv, ContentType::IMAGE_BMP},
+    {".ico"sv, ContentType::IMAGE_ICO},
+    {".tiff"sv, ContentType::IMAGE_TIFF},
+    {".tif"sv, ContentType::IMAGE_TIFF},
+    {".svg"sv, ContentType::IMAGE_SVG_XML},
+    {".svgz"sv, ContentType::IMAGE_SVG_XML},
+    {".mp3"sv, ContentType::AUDIO_MPEG}
+}};
+
+constexpr char ToLowerAscii(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (ToLowerAscii(lhs[i]) != ToLowerAscii(rhs[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(EqualsIgnoreCase(".HTML"sv, ".html"sv));
+
+constexpr int HexDigitValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Разбирает неотрицательное десятичное число, занимающее всю строку
+std::optional<std::uint64_t> ParseUnsigned(std::string_view str) {
+    std::uint64_t value = 0;
+    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (str.empty() || ec != std::errc{} || ptr != str.data() + str.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// ETag файла, отдаваемого с диска: время изменения и размер, без чтения содержимого
+std::string MakeDiskFileETag(const SendfileBody::value_type& body) {
+    std::ostringstream etag;
+    etag << '"' << std::hex << body.GetModificationTime() << '-' << body.GetFileSize() << '"';
+    return etag.str();
+}
+
+// Range учитывается, только если If-Range отсутствует или совпадает с текущей версией файла
+bool IsRangeApplicable(const FileRequestHeaders& headers, std::string_view etag) {
+    return !headers.range.empty() && (headers.if_range.empty() || headers.if_range == etag);
+}
+
+template <typename Response>
+void SetCachingHeaders(Response& response, std::string_view etag, std::string_view content_type) {
+    response.set(http::field::etag, etag);
+    response.set(http::field::accept_ranges, "bytes"sv);
+    // html перепроверяется при каждом заходе, чтобы новые версии скриптов подхватывались сразу
+    response.set(
+        http::field::cache_control,
+        content_type == ContentType::TEXT_HTML ? "no-cache"sv : "public, max-age=3600"sv
+    );
+}
+
+template <typename Response>
+void SetContentRange(Response& response, const ByteRange& range, std::uint64_t total_size) {
+    response.result(http::status::partial_content);
+    response.set(
+        http::field::content_range,
+        "bytes "s + std::to_string(range.offset) + '-' + std::to_string(range.offset + range.size - 1)
+            + '/' + std::to_string(total_size)
+    );
+}
+
+StringResponse ReportRangeNotSatisfiable(std::uint64_t total_size, unsigned http_version, bool keep_alive) {
+    StringResponse response(http::status::range_not_satisfiable, http_version);
+    response.keep_alive(keep_alive);
+    response.set(http::field::content_range, "bytes */"s + std::to_string(total_size));
+    response.prepare_payload();
+    return response;
+}
+
+}  // namespace
+
+RangeParseResult ParseRange(std::string_view range, std::uint64_t total_size) {
+    constexpr std::string_view BYTES_UNIT = "bytes="sv;
+    if (!range.starts_with(BYTES_UNIT)) {
+        return std::monostate{};
+    }
+    range.remove_prefix(BYTES_UNIT.size());
+    const size_t dash = range.find('-');
+    if (dash == std::string_view::npos || range.find(',') != std::string_view::npos) {
+        // Несколько диапазонов (multipart/byteranges) не поддерживаем, отдаём весь файл
+        return std::monostate{};
+    }
+
+    const std::string_view first_str = range.substr(0, dash);
+    const std::string_view last_str = range.substr(dash + 1);
+    if (first_str.empty()) {
+        // "-suffix": последние suffix байт
+        const std::optional<std::uint64_t> suffix = ParseUnsigned(last_str);
+        if (!suffix) {
+            return std::monostate{};
+        }
+        if (*suffix == 0 || total_size == 0) {
+            return UnsatisfiableRange{};
+        }
+        const std::uint64_t size = std::min(*suffix, total_size);
+        return ByteRange{total_size - size, size};
+    }
+
+    const std::optional<std::uint64_t> first = ParseUnsigned(first_str);
+    const std::optional<std::uint64_t> last = last_str.empty() ? std::optional<std::uint64_t>{} : ParseUnsigned(last_str);
+    if (!first || (!last_str.empty() && (!last || *last < *first))) {
+        return std::monostate{};
+    }
+    if (*first >= total_size) {
+        return UnsatisfiableRange{};
+    }
+    const std::uint64_t end = last ? std::min(*last, total_size - 1) : total_size - 1;
+    return ByteRange{*first, end - *first + 1};
+}
+
+bool FileRequestHandler::DecodePath(std::string& path) {
+    // Строка запроса и фрагмент к пути файла не относятся
+    if (const size_t query_pos = path.find_first_of("?#"sv); query_pos != std::string::npos) {
+        path.resize(query_pos);
+    }
+
+    size_t out = 0;
+    for (size_t i = 0; i < path.size(); ++i, ++out) {
+        char c = path[i];
+        if (c == '%') {
+            if (i + 2 >= path.size()) {
+                return false;
+            }
+            const int high = HexDigitValue(path[i + 1]);
+            const int low = HexDigitValue(path[i + 2]);
+            if (high < 0 || low < 0) {
+                return false;
+            }
+            c = static_cast<char>(high * 16 + low);
             i += 2;
-        } else if (path[i] == '+') {
-            decoded_stream << ' ';
-        } else {
-            decoded_stream << path[i];
+            if (c == '\0') {
+                return false;
+            }
+        } else if (c == '+') {
+            c = ' ';
         }
+        // Декодированная строка не длиннее исходной, поэтому запись отстаёт от чтения
+        path[out] = c;
     }
-    return fs::path{ decoded_stream.str() };
+    path.resize(out);
+    return true;
 }
 
-bool FileRequestHandler::IsSubPath(fs::path path, fs::path base) {
-    path = fs::weakly_canonical(path);
-    base = fs::weakly_canonical(base);
+bool FileRequestHandler::NormalizePath(std::string& path) {
+    const bool is_directory = path.empty() || path.back() == '/';
 
-    for (auto b = base.begin(), p = path.begin(); b != base.end(); ++b, ++p) {
-        if (p == path.end() || *p != *b) {
-            return false;
+    // [0, out) - уже нормализованная часть: сегменты через '/', без ведущего слеша
+    size_t out = 0;
+    for (size_t pos = 0; pos < path.size();) {
+        size_t end = path.find('/', pos);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        const std::string_view segment{path.data() + pos, end - pos};
+
+        if (segment == ".."sv) {
+            if (out == 0) {
+                // Выход за пределы корневого каталога
+                return false;
+            }
+            const size_t slash = std::string_view{path.data(), out}.rfind('/');
+            out = slash == std::string_view::npos ? 0 : slash;
+        } else if (!segment.empty() && segment != "."sv) {
+            if (out > 0) {
+                path[out++] = '/';
+            }
+            std::copy(path.begin() + pos, path.begin() + end, path.begin() + out);
+            out += segment.size();
         }
+        pos = end + 1;
+    }
+    path.resize(out);
+
+    if (is_directory || path.empty()) {
+        path += path.empty() ? "index.html"sv : "/index.html"sv;
     }
     return true;
 }
 
-std::string_view FileRequestHandler::ProcessFileExtension(std::string path) {
-    const size_t pos = path.rfind('.');
-    std::string file_extension{ path.begin() + (pos != std::string::npos ? pos : path.size()), path.end() };
-    std::transform(file_extension.begin(), file_extension.end(), file_extension.begin(), tolower);
-
-    static const std::unordered_map<std::string, std::string_view> file_extension_to_content_type{
-        {".htm", ContentType::TEXT_HTML},
-        {".html", ContentType::TEXT_HTML},
-        {".css", ContentType::TEXT_CSS},
-        {".txt", ContentType::TEXT_PLAIN},
-        {".js", ContentType::TEXT_JAVASCRIPT},
-        {".json", ContentType::APPLICATION_JSON},
-        {".xml", ContentType::APPLICATION_XML},
-        {".png", ContentType::IMAGE_PNG},
-        {".jpg", ContentType::IMAGE_JPEG},
-        {".jpe", ContentType::IMAGE_JPEG},
-        {".jpeg", ContentType::IMAGE_JPEG},
-        {".gif", ContentType::IMAGE_GIF},
-        {".bmp", ContentType::IMAGE_BMP},
-        {".ico", ContentType::IMAGE_ICO},
-        {".tiff", ContentType::IMAGE_TIFF},
-        {".tif", ContentType::IMAGE_TIFF},
-        {".svg", ContentType::IMAGE_SVG_XML},
-        {".svgz", ContentType::IMAGE_SVG_XML},
-        {".mp3", ContentType::AUDIO_MPEG}
-    };
-
-    auto it = file_extension_to_content_type.find(file_extension);
-    return (it != file_extension_to_content_type.end()) ? it->second : ContentType::APPLICATION_OCTET_STREAM;
+std::string_view FileRequestHandler::ProcessFileExtension(std::string_view path) {
+    const size_t name_pos = path.rfind('/');
+    const std::string_view file_name = name_pos == std::string_view::npos ? path : path.substr(name_pos + 1);
+    const size_t dot_pos = file_name.rfind('.');
+    if (dot_pos == std::string_view::npos) {
+        return ContentType::APPLICATION_OCTET_STREAM;
+    }
+    const std::string_view file_extension = file_name.substr(dot_pos);
+
+    for (const auto& [extension, content_type] : FILE_EXTENSION_TO_CONTENT_TYPE) {
+        if (EqualsIgnoreCase(file_extension, extension)) {
+            return content_type;
+        }
+    }
+    return ContentType::APPLICATION_OCTET_STREAM;
 }
 
 StringResponse FileRequestHandler::ReportFileBadRequest(unsigned http_version, bool keep_alive) {
@@ -72,16 +251,108 @@ StringResponse FileRequestHandler::ReportFileBadRequest(unsigned http_version, b
     );
 }
 
+FileRequestResult FileRequestHandler::ReturnCachedFile(
+    const StaticFileCache::Entry& entry,
+    std::string_view content_type,
+    unsigned http_version,
+    bool keep_alive,
+    const FileRequestHeaders& headers
+) {
+    CachedFileResponse response(http::status::ok, http_version);
+    response.keep_alive(keep_alive);
+    SetCachingHeaders(response, entry.etag, content_type);
+    if (entry.gzip || entry.brotli) {
+        response.set(http::field::vary, "Accept-Encoding"sv);
+    }
+
+    if (!headers.if_none_match.empty() && MatchesIfNoneMatch(headers.if_none_match, entry.etag)) {
+        // У клиента актуальная версия - 304 not modified без тела
+        response.result(http::status::not_modified);
+        return response;
+    }
+
+    response.set(http::field::content_type, content_type);
+    response.body().buffer = entry.identity;
+    const RangeParseResult range = IsRangeApplicable(headers, entry.etag)
+        ? ParseRange(headers.range, entry.identity->size())
+        : RangeParseResult{};
+    if (std::holds_alternative<UnsatisfiableRange>(range)) {
+        return ReportRangeNotSatisfiable(entry.identity->size(), http_version, keep_alive);
+    }
+    if (const ByteRange* byte_range = std::get_if<ByteRange>(&range)) {
+        // Участок отдаётся из несжатого содержимого
+        SetContentRange(response, *byte_range, entry.identity->size());
+        response.body().offset = static_cast<size_t>(byte_range->offset);
+        response.body().length = static_cast<size_t>(byte_range->size);
+    } else if (entry.brotli && AcceptsEncoding(headers.accept_encoding, "br"sv)) {
+        response.set(http::field::content_encoding, "br"sv);
+        response.body().buffer = entry.brotli;
+    } else if (entry.gzip && AcceptsEncoding(headers.accept_encoding, "gzip"sv)) {
+        response.set(http::field::content_encoding, "gzip"sv);
+        response.body().buffer = entry.gzip;
+    }
+    response.prepare_payload();
+    return response;
+}
+
+FileRequestResult FileRequestHandler::ReturnFileFromDisk(
+    SendfileBody::value_type body,
+    std::string_view content_type,
+    unsigned http_version,
+    bool keep_alive,
+    const FileRequestHeaders& headers
+) {
+    const std::string etag = MakeDiskFileETag(body);
+    const std::uint64_t file_size = body.GetFileSize();
+
+    if (!headers.if_none_match.empty() && MatchesIfNoneMatch(headers.if_none_match, etag)) {
+        StringResponse response(http::status::not_modified, http_version);
+        response.keep_alive(keep_alive);
+        SetCachingHeaders(response, etag, content_type);
+        return response;
+    }
+
+    const RangeParseResult range = IsRangeApplicable(headers, etag) ? ParseRange(headers.range, file_size) : RangeParseResult{};
+    if (std::holds_alternative<UnsatisfiableRange>(range)) {
+        return ReportRangeNotSatisfiable(file_size, http_version, keep_alive);
+    }
+    const ByteRange* byte_range = std::get_if<ByteRange>(&range);
+    if (byte_range) {
+        body.SetRange(byte_range->offset, byte_range->size);
+    }
+
+    // файл нашелся - 200 ok (или 206 partial content для Range-запроса)
+    FileResponse response = MakeFileResponse(
+        http::status::ok,
+        std::move(body),
+        http_version,
+        keep_alive,
+        content_type
+    );
+    SetCachingHeaders(response, etag, content_type);
+    if (byte_range) {
+        SetContentRange(response, *byte_range, file_size);
+    }
+    return response;
+}
+
 FileRequestResult FileRequestHandler::ReturnFileOrReportNotFound(
-    fs::path dir,
+    const std::string& relative_path,
     unsigned http_version,
-    bool keep_alive
+    bool keep_alive,
+    const FileRequestHeaders& headers
 ) {
-    dir = fs::weakly_canonical(dir);
-    std::string_view content_type = ProcessFileExtension(dir.string());
-    http::file_body::value_type body;
+    std::string_view content_type = ProcessFileExtension(relative_path);
+
+    if (cache_) {
+        // Ключи кеша - пути относительно того же канонического корня
+        if (auto entry = cache_->Find(relative_path)) {
+            return ReturnCachedFile(*entry, content_type, http_version, keep_alive, headers);
+        }
+    }
 
-    if (sys::error_code ec; body.open(dir.string().data(), beast::file_mode::read, ec), ec) {
+    SendfileBody::value_type body;
+    if (sys::error_code ec; body.Open((static_files_dir_ / relative_path).c_str(), ec), ec) {
         // файл не нашелся - 404 not found
         return MakeStringResponse(
             http::status::not_found,
@@ -91,14 +362,7 @@ FileRequestResult FileRequestHandler::ReturnFileOrReportNotFound(
             ContentType::TEXT_PLAIN
         );
     }
-    // файл нашелся - 200 ok
-    return MakeFileResponse(
-        http::status::ok,
-        std::move(body),
-        http_version,
-        keep_alive,
-        content_type
-    );
+    return ReturnFileFromDisk(std::move(body), content_type, http_version, keep_alive, headers);
 }
 
-}  // namespace http_handler
\ No newline at end of file
+}  // namespace http_handler
@@ -1,9 +1,10 @@
 #pragma once
 
 #include "response_utils.h"
+#include "static_file_cache.h"
 
 #include <filesystem>
-#include <unordered_map>
+#include <memory>
 #include <variant>
 
 namespace http_handler {
@@ -14,57 +15,113 @@ namespace sys = boost::system;
 constexpr static std::string_view INVALID_PATH_MESSAGE = "Invalid path!"sv;
 constexpr static std::string_view NOT_FOUND_FILE_MESSAGE = "File not found!"sv;
 
-using FileRequestResult = std::variant<StringResponse, FileResponse>;
+using FileRequestResult = std::variant<StringResponse, FileResponse, CachedFileResponse>;
+
+// Заголовки запроса, от которых зависит ответ с файлом
+struct FileRequestHeaders {
+    std::string_view accept_encoding;
+    std::string_view if_none_match;
+    std::string_view range;
+    std::string_view if_range;
+};
+
+// Участок тела [offset, offset + size)
+struct ByteRange {
+    std::uint64_t offset = 0;
+    std::uint64_t size = 0;
+};
+
+// Диапазон лежит за концом файла - 416 range not satisfiable
+struct UnsatisfiableRange {};
+
+// std::monostate - заголовка нет либо он не поддерживается (несколько диапазонов), отдаётся весь файл
+using RangeParseResult = std::variant<std::monostate, ByteRange, UnsatisfiableRange>;
+
+// Разбирает заголовок Range ("bytes=first-last", "bytes=first-", "bytes=-suffix") для тела размером total_size
+RangeParseResult ParseRange(std::string_view range, std::uint64_t total_size);
 
 class FileRequestHandler {
 public:
 
-    explicit FileRequestHandler(fs::path static_files_dir)
-        : static_files_dir_{std::move(static_files_dir)} {
+    // Если передан кеш, файлы отдаются из памяти, а на диск обработчик обращается только при промахе.
+    // Корень статики приводится к каноническому виду один раз, запросы проверяются без обращения к ФС
+    explicit FileRequestHandler(fs::path static_files_dir, std::shared_ptr<const StaticFileCache> cache = nullptr)
+        : static_files_dir_{fs::weakly_canonical(static_files_dir)}, cache_{std::move(cache)} {
     }
 
     template <typename Body, typename Allocator, typename Send>
     void HandleRequest(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
         auto http_version = req.version();
         auto keep_alive = req.keep_alive();
+        // Путь декодируется и нормализуется на месте, получается путь относительно корня статики
         std::string path = std::string(req.target());
 
-        if (path.back() == '/') {
-            path += "index.html"s;
-        }
-        
-        fs::path decoded_path = DecodePath(path);
-        fs::path dir = static_files_dir_ / decoded_path.relative_path();
-    
-        if (IsSubPath(dir, static_files_dir_)) {
+        if (DecodePath(path) && NormalizePath(path)) {
             // Возвращем файл (если такой существует) или 404 not_found
             std::visit(
                 [&send](auto&& result) { send(std::forward<decltype(result)>(result)); },
-                ReturnFileOrReportNotFound(dir, http_version, keep_alive)
+                ReturnFileOrReportNotFound(
+                    path,
+                    http_version,
+                    keep_alive,
+                    FileRequestHeaders{
+                        req[http::field::accept_encoding],
+                        req[http::field::if_none_match],
+                        req[http::field::range],
+                        req[http::field::if_range]
+                    }
+                )
             );
         } else {
-            // Вышли за пределы корневого каталога - 400 bad requset
+            // Некорректное экранирование или выход за пределы корневого каталога - 400 bad requset
             send(ReportFileBadRequest(http_version, keep_alive));
         }
     }
 
-private:
-    fs::path static_files_dir_;
+    // Отбрасывает строку запроса и декодирует percent-encoding (а также +=' ') за один проход на месте.
+    // Возвращает false для некорректного экранирования и нулевого символа
+    static bool DecodePath(std::string& path);
 
-    // Декодирует percent-encoding (а также +=' ')
-    fs::path DecodePath(std::string path);
+    // Лексически нормализует путь на месте: убирает пустые сегменты, "." и "..", ведущий слеш,
+    // для каталога дописывает index.html. Возвращает false, если путь выходит за пределы корня
+    static bool NormalizePath(std::string& path);
 
-    // Возвращает true, если каталог p содержится внутри base_path.
-    bool IsSubPath(fs::path path, fs::path base);
+private:
+    fs::path static_files_dir_;
+    std::shared_ptr<const StaticFileCache> cache_;
 
-    // Получает и обрабатывает расширение файла, возвращает Content-Type
-    std::string_view ProcessFileExtension(std::string path);
+    // Получает расширение файла без копирования пути, возвращает Content-Type
+    static std::string_view ProcessFileExtension(std::string_view path);
 
     // Создает StringResponse в случае bad request к файлам
     StringResponse ReportFileBadRequest(unsigned http_version, bool keep_alive);
 
-    // Возвращет файл либо 404 not found, если файл по пути dir не найден
-    FileRequestResult ReturnFileOrReportNotFound(fs::path dir, unsigned http_version, bool keep_alive);
+    // Возвращет файл либо 404 not found, если файл по пути relative_path не найден
+    FileRequestResult ReturnFileOrReportNotFound(
+        const std::string& relative_path,
+        unsigned http_version,
+        bool keep_alive,
+        const FileRequestHeaders& headers
+    );
+
+    // Отдаёт файл из кеша: 304 при совпадении ETag, участок файла для Range-запроса,
+    // иначе лучший вариант из допустимых клиентом кодировок
+    FileRequestResult ReturnCachedFile(
+        const StaticFileCache::Entry& entry,
+        std::string_view content_type,
+        unsigned http_version,
+        bool keep_alive,
+        const FileRequestHeaders& headers
+    );
+
+    // Отдаёт файл с диска через sendfile, поддерживает условные и Range-запросы
+    FileRequestResult ReturnFileFromDisk(
+        SendfileBody::value_type body,
+        std::string_view content_type,
+        unsigned http_version,
+        bool keep_alive,
+        const FileRequestHeaders& headers
+    );
 };
 
 }  // namespace http_handler
\ No newline at end of file
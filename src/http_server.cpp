@@ -3,6 +3,10 @@
 #include <boost/asio/dispatch.hpp>
 #include <iostream>
 
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
 namespace http_server {
     
     void SessionBase::Run() {
@@ -14,25 +18,135 @@ namespace http_server {
 
     void SessionBase::Read() {
         using namespace std::literals;
-        // Очищаем запрос от прежнего значения (метод Read может быть вызван несколько раз)
-        request_ = {};
-        stream_.expires_after(30s);
-        // Считываем request_ из stream_, используя buffer_ для хранения считанных данных
-        http::async_read(stream_, buffer_, request_,
+        if (is_reading_ || is_read_closed_) {
+            return;
+        }
+        // Не читаем дальше, пока слишком много запросов ждут ответа
+        if (next_request_sequence_ - next_response_sequence_ >= limits_.max_pipelined_requests) {
+            return;
+        }
+        // Парсер создаётся заново для каждого запроса, буфер buffer_ переиспользуется:
+        // в нём уже могут лежать байты следующих конвейерных запросов
+        parser_.emplace(http::request_header<http::basic_fields<FieldsAllocator>>{FieldsAllocator{pool_}}, PoolAllocator<char>{pool_});
+        parser_->header_limit(limits_.header_limit);
+        parser_->body_limit(limits_.body_limit);
+        is_reading_ = true;
+        // Под нагрузкой таймаут простоя сокращается, чтобы быстрее освобождать места неактивных клиентов
+        stream_.expires_after(admission_->GetIdleTimeout());
+        // Считываем запрос из stream_, используя buffer_ для хранения считанных данных
+        http::async_read(stream_, buffer_, *parser_,
                             // По окончании операции будет вызван метод OnRead
                             beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
     }
 
     void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
         using namespace std::literals;
+        is_reading_ = false;
         if (ec == http::error::end_of_stream) {
-            // Нормальная ситуация - клиент закрыл соединение
-            return Close();
+            // Нормальная ситуация - клиент закрыл соединение.
+            // Закрываем сразу, если не осталось запросов без ответа
+            is_read_closed_ = true;
+            if (next_request_sequence_ == next_response_sequence_) {
+                Close();
+            }
+            return;
+        }
+        if (ec == beast::error::timeout) {
+            // Клиент простаивал дольше таймаута, basic_stream уже закрыл сокет
+            is_read_closed_ = true;
+            admission_->OnIdleTimeout();
+            return;
+        }
+        if (ec == http::error::body_limit) {
+            return RejectRequest(http::status::payload_too_large);
+        }
+        if (ec == http::error::header_limit) {
+            return RejectRequest(http::status::request_header_fields_too_large);
         }
         if (ec) {
+            is_read_closed_ = true;
             return ReportError(ec, "read"sv);
         }
-        HandleRequest(std::move(request_));
+
+        HttpRequest request = parser_->release();
+        if (!request.keep_alive()) {
+            // После ответа на этот запрос соединение будет закрыто
+            is_read_closed_ = true;
+        }
+        const uint64_t sequence = next_request_sequence_++;
+        responses_.emplace_back();
+        HandleRequest(std::move(request), sequence);
+
+        // Не дожидаясь ответа, читаем следующий конвейерный запрос
+        Read();
+    }
+
+    void SessionBase::SendFile(int fd, uint64_t offset, uint64_t size, std::size_t bytes_written, SendFileHandler&& handler) {
+#ifdef __linux__
+        SessionSocket& socket = stream_.socket();
+        if (beast::error_code ec; socket.native_non_blocking(true, ec), ec) {
+            return handler(ec, bytes_written);
+        }
+        while (size > 0) {
+            off_t file_offset = static_cast<off_t>(offset);
+            const ssize_t sent = ::sendfile(socket.native_handle(), fd, &file_offset, static_cast<size_t>(size));
+            if (sent > 0) {
+                offset += static_cast<uint64_t>(sent);
+                size -= static_cast<uint64_t>(sent);
+                bytes_written += static_cast<std::size_t>(sent);
+                continue;
+            }
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                // Буфер сокета заполнен: продолжим, когда клиент примет данные.
+                // Клиент, переставший читать, не должен удерживать соединение дольше таймаута простоя
+                is_send_timed_out_ = false;
+                send_timer_.expires_after(admission_->GetIdleTimeout());
+                send_timer_.async_wait([self = GetSharedThis()](beast::error_code ec) {
+                    // Ожидание могло завершиться раньше, чем выполнился уже сработавший таймер
+                    if (!ec && self->send_timer_.expiry() <= std::chrono::steady_clock::now()) {
+                        self->is_send_timed_out_ = true;
+                        self->is_read_closed_ = true;
+                        self->stream_.close();
+                    }
+                });
+                socket.async_wait(tcp::socket::wait_write,
+                    [self = GetSharedThis(), fd, offset, size, bytes_written, handler = std::move(handler)](beast::error_code ec) mutable {
+                        self->send_timer_.expires_at(std::chrono::steady_clock::time_point::max());
+                        if (self->is_send_timed_out_) {
+                            self->admission_->OnIdleTimeout();
+                            return handler(beast::error::timeout, bytes_written);
+                        }
+                        if (ec) {
+                            return handler(ec, bytes_written);
+                        }
+                        self->SendFile(fd, offset, size, bytes_written, std::move(handler));
+                    });
+                return;
+            }
+            // sendfile вернул 0: файл укоротили после отправки заголовков
+            return handler(sent == 0 ? beast::error_code{http::error::short_read}
+                                     : beast::error_code{errno, sys::system_category()}, bytes_written);
+        }
+        handler({}, bytes_written);
+#else
+        handler(net::error::operation_not_supported, bytes_written);
+#endif
+    }
+
+    void SessionBase::RejectRequest(http::status status) {
+        is_read_closed_ = true;
+        http::response<http::string_body> response{status, 11};
+        response.set(http::field::content_type, "text/plain"sv);
+        response.body() = std::string(http::obsolete_reason(status));
+        response.prepare_payload();
+        response.keep_alive(false);
+
+        const uint64_t sequence = next_request_sequence_++;
+        responses_.emplace_back();
+        Write(sequence, boost_time::microsec_clock::local_time(), std::move(response));
     }
 
     void SessionBase::Close() {
@@ -43,7 +157,25 @@ namespace http_server {
         }
     }
 
+    void SessionBase::EnqueueResponse(uint64_t sequence, PendingResponse&& pending) {
+        responses_[sequence - next_response_sequence_] = std::move(pending);
+        WriteNextResponse();
+    }
+
+    void SessionBase::WriteNextResponse() {
+        // Ответы уходят по одному и строго по порядку: ждём, пока будет готов самый старый
+        if (is_writing_ || responses_.empty() || !responses_.front().response) {
+            return;
+        }
+        PendingResponse pending = std::move(responses_.front());
+        responses_.pop_front();
+        ++next_response_sequence_;
+        is_writing_ = true;
+        pending.write(*this, std::move(pending.response), pending.received_at);
+    }
+
     void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+        is_writing_ = false;
         if (ec) {
             return ReportError(ec, "write"sv);
         }
@@ -53,7 +185,13 @@ namespace http_server {
             return Close();
         }
 
-        // Считываем следующий запрос
+        if (is_read_closed_ && next_request_sequence_ == next_response_sequence_) {
+            // Клиент больше ничего не пришлёт, все ответы отправлены
+            return Close();
+        }
+
+        // Отправляем следующий готовый ответ и, если чтение было приостановлено, продолжаем его
+        WriteNextResponse();
         Read();
     }
 
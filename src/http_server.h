@@ -3,14 +3,21 @@
 // boost.beast будет использовать std::string_view вместо boost::string_view
 #define BOOST_BEAST_USE_STD_STRING_VIEW
 
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 
+#include <concepts>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <optional>
 
 #include "logger.h"
+#include "admission_control.h"
+#include "pool_allocator.h"
 
 using namespace std::literals;
 
@@ -28,6 +35,44 @@ inline void ReportError(beast::error_code ec, std::string_view what) {
     LOG_WITH_DATA(error, ServerErrorData(ec.value(), ec.message(), std::string(what)), "error"sv);
 }
 
+// Ограничения, применяемые к каждому соединению
+struct SessionLimits {
+    // Максимальный размер стартовой строки и заголовков запроса
+    uint32_t header_limit = 8 * 1024;
+    // Максимальный размер тела запроса
+    uint64_t body_limit = 64 * 1024;
+    // Сколько запросов одного соединения может одновременно ожидать ответа (HTTP pipelining)
+    size_t max_pipelined_requests = 16;
+};
+
+struct ListenerConfig {
+    // Позволяет запустить по одному Listener на каждый шард с общим портом
+    bool reuse_port = false;
+    SessionLimits session_limits;
+    // Общий для всех Listener'ов контроль нагрузки; если не задан, Listener создаёт свой с настройками по умолчанию
+    std::shared_ptr<AdmissionControl> admission;
+};
+
+// Исполнитель соединения. Конкретный тип strand вместо any_io_executor: каждая асинхронная операция
+// запрашивает у исполнителя outstanding_work.tracked, и any_io_executor размещал бы новую копию strand в куче
+using SessionExecutor = net::strand<net::io_context::executor_type>;
+using SessionSocket = net::basic_stream_socket<tcp, SessionExecutor>;
+using SessionStream = beast::basic_stream<tcp, SessionExecutor>;
+using SessionTimer = net::basic_waitable_timer<std::chrono::steady_clock, net::wait_traits<std::chrono::steady_clock>, SessionExecutor>;
+
+#ifdef SO_REUSEPORT
+// Позволяет нескольким acceptor'ам слушать один порт, ядро распределяет между ними входящие соединения
+using reuse_port = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+// Тело ответа, которое можно передать в сокет напрямую из файла (см. http_handler::SendfileBody)
+template <typename Body>
+concept SendfileCapableBody = requires(const typename Body::value_type& body) {
+    { body.GetNativeHandle() } -> std::convertible_to<int>;
+    { body.GetOffset() } -> std::convertible_to<uint64_t>;
+    { body.GetSize() } -> std::convertible_to<uint64_t>;
+};
+
 class SessionBase {
 public:
     // Запрещаем копирование и присваивание объектов SessionBase и его наследников
@@ -42,52 +87,78 @@ public:
 
 
 protected:
-    using HttpRequest = http::request<http::string_body>;
-
-    explicit SessionBase(tcp::socket&& socket)
-    : stream_(std::move(socket)) 
+    // Заголовки и тело запроса размещаются в пуле соединения
+    using FieldsAllocator = PoolAllocator<char>;
+    using RequestBody = http::basic_string_body<char, std::char_traits<char>, PoolAllocator<char>>;
+    using HttpRequest = http::request<RequestBody, http::basic_fields<FieldsAllocator>>;
+
+    // Место под соединение уже занято в admission, сессия освобождает его при разрушении
+    SessionBase(SessionSocket&& socket, const SessionLimits& limits, std::shared_ptr<AdmissionControl> admission)
+    : stream_(std::move(socket)), send_timer_(stream_.get_executor()), limits_(limits), admission_(std::move(admission)),
+    pool_(std::make_shared<ConnectionPool>())
     {
 
     }
 
-    ~SessionBase() = default;
-
-    template <typename Body, typename Fields>
-    void Write(http::response<Body, Fields>&& response) {
-        // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
-        auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
-
-        auto self = GetSharedThis();
-        http::async_write(stream_, *safe_response,
-                            [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
-                                self->OnWrite(safe_response->need_eof(), ec, bytes_written);
-                                LOG_WITH_DATA(
-                                    info,
-                                    ServerResponseData(
-                                        self->GetResponseExecutionTime(boost_time::microsec_clock::local_time()),
-                                        safe_response->result_int(),
-                                        std::string((*safe_response)[http::field::content_type])
-                                    ), 
-                                    "response sent"sv
-                                );
-                            });
+    ~SessionBase() {
+        admission_->Release();
     }
 
-    void SetRequestReceivingTime(const boost_time::ptime& received_request_moment){
-        request_receiving_time_ = received_request_moment;
+    // Ответ на запрос с порядковым номером sequence. Может вызываться из любого потока,
+    // ответы отправляются клиенту строго в порядке поступления запросов
+    template <typename Body, typename Fields>
+    void Write(uint64_t sequence, boost_time::ptime received_at, http::response<Body, Fields>&& response) {
+        using Response = http::response<Body, Fields>;
+        // Запись выполняется асинхронно, поэтому response перемещаем в пул соединения
+        PendingResponse pending{
+            std::allocate_shared<Response>(PoolAllocator<Response>{pool_}, std::move(response)),
+            &SessionBase::WriteResponse<Response>,
+            received_at
+        };
+        // Очередь ответов обслуживается только в executor'е соединения
+        net::dispatch(stream_.get_executor(), [self = GetSharedThis(), sequence, pending = std::move(pending)]() mutable {
+            self->EnqueueResponse(sequence, std::move(pending));
+        });
     }
 
-    int32_t GetResponseExecutionTime(const boost_time::ptime& moment) {
-        boost_time::millisec_posix_time_system_config::time_duration_type duration = moment - request_receiving_time_;
+    static int32_t GetResponseExecutionTime(const boost_time::ptime& received_at, const boost_time::ptime& moment) {
+        boost_time::millisec_posix_time_system_config::time_duration_type duration = moment - received_at;
         return duration.total_milliseconds();
     }
 
 private:
-    // tcp_stream содержит внутри себя сокет и добавляет поддержку таймаутов
-    beast::tcp_stream stream_;
+    // Ответ, ожидающий отправки. Тип ответа стёрт: write знает, как отправить response
+    struct PendingResponse {
+        std::shared_ptr<void> response;
+        void (*write)(SessionBase& session, std::shared_ptr<void> response, boost_time::ptime received_at) = nullptr;
+        boost_time::ptime received_at;
+    };
+
+    // basic_stream содержит внутри себя сокет и добавляет поддержку таймаутов
+    SessionStream stream_;
+    // Таймаут ожидания готовности сокета в SendFile: это ожидание идёт мимо stream_ и его таймаут не покрывает
+    SessionTimer send_timer_;
+    bool is_send_timed_out_ = false;
+    // Буфер переиспользуется всеми запросами соединения
     beast::flat_buffer buffer_;
-    HttpRequest request_;
-    boost_time::ptime request_receiving_time_;
+    // Парсер пересоздаётся на месте для каждого запроса, чтобы применить ограничения
+    std::optional<http::request_parser<RequestBody, FieldsAllocator>> parser_;
+    SessionLimits limits_;
+    std::shared_ptr<AdmissionControl> admission_;
+    // Пул для запросов и объектов ответов этого соединения.
+    // Заголовки и тела ответов обработчики создают со стандартным аллокатором (см. http_handler::StringResponse)
+    std::shared_ptr<ConnectionPool> pool_;
+
+    // Порядковый номер следующего прочитанного запроса и следующего отправляемого ответа
+    uint64_t next_request_sequence_ = 0;
+    uint64_t next_response_sequence_ = 0;
+    // Готовые ответы, упорядоченные по номеру запроса начиная с next_response_sequence_;
+    // пустой response означает, что ответ ещё не готов
+    std::deque<PendingResponse> responses_;
+    bool is_reading_ = false;
+    bool is_writing_ = false;
+    // Клиент закрыл соединение или запросил его закрытие, новые запросы не читаем
+    bool is_read_closed_ = false;
 
     virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
 
@@ -97,8 +168,56 @@ private:
 
     void Close();
 
+    // Отвечает на запрос, нарушивший ограничения парсера, и закрывает соединение
+    void RejectRequest(http::status status);
+
     // Обработку запроса делегируем подклассу
-    virtual void HandleRequest(HttpRequest&& request) = 0;
+    virtual void HandleRequest(HttpRequest&& request, uint64_t sequence) = 0;
+
+    void EnqueueResponse(uint64_t sequence, PendingResponse&& pending);
+
+    template <typename Response>
+    static void WriteResponse(SessionBase& session, std::shared_ptr<void> response, boost_time::ptime received_at) {
+        auto safe_response = std::static_pointer_cast<Response>(std::move(response));
+        auto on_write = [safe_response, self = session.GetSharedThis(), received_at](beast::error_code ec, std::size_t bytes_written) {
+            self->OnWrite(safe_response->need_eof(), ec, bytes_written);
+            LOG_WITH_DATA(
+                info,
+                ServerResponseData(
+                    GetResponseExecutionTime(received_at, boost_time::microsec_clock::local_time()),
+                    safe_response->result_int(),
+                    std::string((*safe_response)[http::field::content_type])
+                ), 
+                "response sent"sv
+            );
+        };
+#ifdef __linux__
+        if constexpr (SendfileCapableBody<typename Response::body_type>) {
+            // Заголовки пишет Beast, тело ядро копирует из файла в сокет без промежуточных буферов
+            using Serializer = http::response_serializer<typename Response::body_type, typename Response::fields_type>;
+            auto serializer = std::make_shared<Serializer>(*safe_response);
+            http::async_write_header(session.stream_, *serializer,
+                                        [serializer, safe_response, self = session.GetSharedThis(), on_write = std::move(on_write)]
+                                        (beast::error_code ec, std::size_t header_bytes) mutable {
+                                            if (ec) {
+                                                return on_write(ec, header_bytes);
+                                            }
+                                            const auto& body = safe_response->body();
+                                            self->SendFile(body.GetNativeHandle(), body.GetOffset(), body.GetSize(), header_bytes, std::move(on_write));
+                                        });
+            return;
+        }
+#endif
+        http::async_write(session.stream_, *safe_response, std::move(on_write));
+    }
+
+    using SendFileHandler = std::function<void(beast::error_code ec, std::size_t bytes_written)>;
+
+    // Передаёт size байт файла fd начиная с offset в сокет соединения, не блокируя поток:
+    // когда буфер сокета заполнен, дожидается готовности сокета к записи
+    void SendFile(int fd, uint64_t offset, uint64_t size, std::size_t bytes_written, SendFileHandler&& handler);
+
+    void WriteNextResponse();
 
     void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
 };
@@ -107,8 +226,9 @@ template <typename RequestHandler>
 class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
 public:
     template <typename Handler>
-    Session(tcp::socket&& socket, Handler&& request_handler)
-        : SessionBase(std::move(socket))
+    Session(SessionSocket&& socket, Handler&& request_handler, const SessionLimits& limits,
+        std::shared_ptr<AdmissionControl> admission)
+        : SessionBase(std::move(socket), limits, std::move(admission))
         , request_handler_(std::forward<Handler>(request_handler)) {
     }
 
@@ -119,14 +239,14 @@ private:
         return this->shared_from_this();
     }
     
-    void HandleRequest(HttpRequest&& request) override {
-        SetRequestReceivingTime(boost_time::microsec_clock::local_time());
+    void HandleRequest(HttpRequest&& request, uint64_t sequence) override {
+        const boost_time::ptime received_at = boost_time::microsec_clock::local_time();
         LOG_WITH_DATA(info, ServerRequestData(GetClientIP(), std::string(request.target()), std::string(request.method_string())), "request received"sv);
         // Захватываем умный указатель на текущий объект Session в лямбде,
         // чтобы продлить время жизни сессии до вызова лямбды.
         // Используется generic-лямбда функция, способная принять response произвольного типа
-        request_handler_(std::move(request), [self = this->shared_from_this()](auto&& response) {
-            self->Write(std::move(response));
+        request_handler_(std::move(request), [self = this->shared_from_this(), sequence, received_at](auto&& response) {
+            self->Write(sequence, received_at, std::move(response));
         });
     }
 };
@@ -135,11 +255,13 @@ template <typename RequestHandler>
 class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
 public:
     template <typename Handler>
-    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler)
+    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler, const ListenerConfig& config = {})
         : ioc_(ioc)
         // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
         , acceptor_(net::make_strand(ioc))
-        , request_handler_(std::forward<Handler>(request_handler)) {
+        , request_handler_(std::forward<Handler>(request_handler))
+        , session_limits_(config.session_limits)
+        , admission_(config.admission ? config.admission : std::make_shared<AdmissionControl>()) {
         // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
         acceptor_.open(endpoint.protocol());
 
@@ -148,6 +270,13 @@ public:
         // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
         // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
         acceptor_.set_option(net::socket_base::reuse_address(true));
+        if (config.reuse_port) {
+#ifdef SO_REUSEPORT
+            acceptor_.set_option(http_server::reuse_port(true));
+#else
+            throw std::runtime_error("SO_REUSEPORT is not supported on this platform"s);
+#endif
+        }
         // Привязываем acceptor к адресу и порту endpoint
         acceptor_.bind(endpoint);
         // Переводим acceptor в состояние, в котором он способен принимать новые соединения
@@ -163,6 +292,8 @@ private:
     net::io_context& ioc_;
     tcp::acceptor acceptor_;
     RequestHandler request_handler_;
+    SessionLimits session_limits_;
+    std::shared_ptr<AdmissionControl> admission_;
 
     void DoAccept() {
         acceptor_.async_accept(
@@ -181,32 +312,45 @@ private:
     }
 
     // Метод socket::async_accept создаст сокет и передаст его в OnAccept
-    void OnAccept(sys::error_code ec, tcp::socket socket) {
+    void OnAccept(sys::error_code ec, SessionSocket socket) {
         using namespace std::literals;
 
         if (ec) {
             return ReportError(ec, "accept"sv);
         }
 
-        // Асинхронно обрабатываем сессию
-        AsyncRunSession(std::move(socket));
+        if (!admission_->TryAdmit()) {
+            // Достигнут предел соединений: сразу закрываем сокет, не тратя на него память и время
+            sys::error_code close_ec;
+            socket.close(close_ec);
+            return DoAccept();
+        }
+
+        // Асинхронно обрабатываем сессию. Если создать сессию не удалось, место освобождаем сами:
+        // деструктор SessionBase, который делает это обычно, не будет вызван
+        try {
+            AsyncRunSession(std::move(socket));
+        } catch (const std::exception& e) {
+            admission_->Release();
+            LOG_WITH_DATA(error, json::object{}, "Failed to start session: "s + e.what());
+        }
 
         // Принимаем новое соединение
         DoAccept();
     }
 
-    void AsyncRunSession(tcp::socket&& socket) {
-        std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_)->Run();
+    void AsyncRunSession(SessionSocket&& socket) {
+        std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_, session_limits_, admission_)->Run();
     }
 };
 
 template <typename RequestHandler>
-void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler) {
+void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler, const ListenerConfig& config = {}) {
     // При помощи decay_t исключим ссылки из типа RequestHandler,
     // чтобы Listener хранил RequestHandler по значению
     using MyListener = Listener<std::decay_t<RequestHandler>>;
 
-    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler), config)->Run();
 }
 
 }  // namespace http_server
@@ -1,10 +1,14 @@
 #include "json_loader.h"
 #include "extra_data.h"
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <fstream>
-#include <sstream>
+#include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace json_loader {
 
@@ -21,11 +25,111 @@ static const std::string H = "h"s;
 static const std::string OFFSET_X = "offsetX"s;
 static const std::string OFFSET_Y = "offsetY"s;
 
+namespace {
+
+// Размер блока, которым файл конфигурации передаётся парсеру
+constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+// Разбирает файл по блокам, не копируя его целиком в строку.
+// Узлы документа размещаются в storage, который должен пережить результат
+json::value ParseFile(const std::filesystem::path& json_path, json::storage_ptr storage) {
+    std::ifstream file(json_path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Can not open file: "s + json_path.string());
+    }
+
+    json::stream_parser parser;
+    parser.reset(std::move(storage));
+    std::vector<char> chunk(READ_CHUNK_SIZE);
+    while (file.read(chunk.data(), static_cast<std::streamsize>(chunk.size())) || file.gcount() > 0) {
+        parser.write(chunk.data(), static_cast<size_t>(file.gcount()));
+    }
+    if (file.bad()) {
+        throw std::runtime_error("Failed to read file: "s + json_path.string());
+    }
+    parser.finish();
+    return parser.release();
+}
+
+// Вызывает fn(index) для каждого index из [0, count) в threads потоках, включая текущий.
+// Потоки берут следующий необработанный индекс, поэтому крупные карты не задерживают остальные.
+// fn не должна выбрасывать исключений
+template <typename Fn>
+void ParallelFor(size_t count, unsigned threads, Fn&& fn) {
+    if (count == 0) {
+        return;
+    }
+    std::atomic<size_t> next_index{0};
+    auto worker = [&next_index, count, &fn] {
+        for (size_t index = next_index.fetch_add(1, std::memory_order_relaxed); index < count;
+            index = next_index.fetch_add(1, std::memory_order_relaxed)) {
+            fn(index);
+        }
+    };
+
+    // jthread дожидается завершения потока в деструкторе, в том числе если запуск следующего потока не удался
+    std::vector<std::jthread> workers;
+    const size_t extra_threads = std::min<size_t>(std::max(threads, 1u), count) - 1;
+    workers.reserve(extra_threads);
+    for (size_t i = 0; i < extra_threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+}
+
+model::Map BuildMap(
+    const json::value& map,
+    double default_dog_speed,
+    bool randomize_spawn_points,
+    int64_t default_bag_capacity,
+    size_t default_max_players
+) {
+    if (!map.as_object().contains("lootTypes"s)) {
+        throw std::runtime_error("Invalid 'maps'! 'maps' does not contain 'loot_types'!"s);
+    }
+    model::Map cur_map{
+        model::Map::Id{map.at("id").as_string().c_str()},
+        map.at("name").as_string().c_str(),
+        map.as_object().contains("dogSpeed"s) ? map.at("dogSpeed"s).as_double() : default_dog_speed,
+        randomize_spawn_points,
+        map.at("lootTypes").as_array().size(),
+        map.as_object().contains("bagCapacity"s) ? map.at("bagCapacity"s).as_int64() : default_bag_capacity,
+        map.as_object().contains("maxPlayers"s) ? ParseMaxPlayers(map.at("maxPlayers"s)) : default_max_players
+    };
+    AddRoadsToTheMap(cur_map, map.at("roads").as_array());
+    AddBuildingsToTheMap(cur_map, map.at("buildings").as_array());
+    AddOfficesToTheMap(cur_map, map.at("offices").as_array());
+    return cur_map;
+}
+
+}  // namespace
+
+size_t ParseMaxPlayers(const json::value& max_players) {
+    const int64_t value = max_players.as_int64();
+    if (value <= 0) {
+        throw std::runtime_error("Invalid 'maxPlayers'! Value must be positive"s);
+    }
+    return static_cast<size_t>(value);
+}
+
+model::MatchmakingPolicy ParseMatchmakingPolicy(const std::string& policy) {
+    if (policy == "fillFirst"s) {
+        return model::MatchmakingPolicy::FILL_FIRST;
+    }
+    if (policy == "balance"s) {
+        return model::MatchmakingPolicy::BALANCE;
+    }
+    throw std::runtime_error("Invalid 'matchmakingPolicy'! Expected 'fillFirst' or 'balance'"s);
+}
+
 void AddRoadsToTheMap(model::Map& map, const json::array& roads_arr) {
+    // Дороги добавляются вместе, чтобы индекс точек карты был зарезервирован по их суммарной длине
+    model::Map::Roads roads;
+    roads.reserve(roads_arr.size());
     for (const json::value& road : roads_arr) {
         // Если горизонтальная дорога
         if (road.as_object().contains(X1)) {
-            map.AddRoad(std::make_shared<model::Road>(
+            roads.emplace_back(std::make_shared<model::Road>(
                 model::Road::HORIZONTAL,
                 model::Point{
                     static_cast<int>(road.at(X0).as_int64()),
@@ -34,7 +138,7 @@ void AddRoadsToTheMap(model::Map& map, const json::array& roads_arr) {
                 static_cast<int>(road.at(X1).as_int64())
             ));
         } else {
-            map.AddRoad(std::make_shared<model::Road>(
+            roads.emplace_back(std::make_shared<model::Road>(
                 model::Road::VERTICAL,
                 model::Point{
                     static_cast<int>(road.at(X0).as_int64()),
@@ -44,6 +148,7 @@ void AddRoadsToTheMap(model::Map& map, const json::array& roads_arr) {
             ));
         }
     }
+    map.AddRoads(std::move(roads));
 }
 
 void AddBuildingsToTheMap(model::Map& map, const json::array& buildings_arr) {
@@ -86,51 +191,54 @@ void AddMapsToTheGame(
     const json::array& map_arr,
     double default_dog_speed,
     bool randomize_spawn_points,
-    int64_t default_bag_capacity
+    int64_t default_bag_capacity,
+    size_t default_max_players,
+    unsigned threads
 ) {
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // Карты не зависят друг от друга и строятся параллельно. Документ JSON только читается,
+    // поэтому доступ к нему из нескольких потоков безопасен
+    std::vector<std::optional<model::Map>> maps(map_arr.size());
+    std::vector<std::exception_ptr> errors(map_arr.size());
+    ParallelFor(map_arr.size(), threads, [&](size_t index) {
+        try {
+            maps[index].emplace(BuildMap(
+                map_arr[index],
+                default_dog_speed,
+                randomize_spawn_points,
+                default_bag_capacity,
+                default_max_players
+            ));
+        } catch (...) {
+            errors[index] = std::current_exception();
+        }
+    });
+
+    // Карты добавляются в порядке файла: ошибка первой некорректной карты и порядок карт
+    // такие же, как при последовательной загрузке
     extra_data::LootTypes loot_types;
-    for (const json::value& map : map_arr) {
-        if (!map.as_object().contains("lootTypes"s)) {
-            throw std::runtime_error("Invalid 'maps'! 'maps' does not contain 'loot_types'!"s);
+    for (size_t index = 0; index < map_arr.size(); ++index) {
+        if (errors[index]) {
+            std::rethrow_exception(errors[index]);
         }
-        json::array loot_types_arr = map.at("lootTypes").as_array();
-        std::string str_map_id = map.at("id").as_string().c_str();
-        loot_types.AddLootTypes(str_map_id, loot_types_arr);
-        model::Map cur_map{
-            model::Map::Id{str_map_id},
-            map.at("name").as_string().c_str(),
-            map.as_object().contains("dogSpeed"s) ? map.at("dogSpeed"s).as_double() : default_dog_speed,
-            randomize_spawn_points,
-            loot_types_arr.size(),
-            map.as_object().contains("bagCapacity"s) ? map.at("bagCapacity"s).as_int64() : default_bag_capacity,
-        };
-        AddRoadsToTheMap(cur_map, map.at("roads").as_array());
-        AddBuildingsToTheMap(cur_map, map.at("buildings").as_array());
-        AddOfficesToTheMap(cur_map, map.at("offices").as_array());
-        game.AddMap(cur_map);
+        loot_types.AddLootTypes(*maps[index]->GetId(), map_arr[index].at("lootTypes").as_array());
+        game.AddMap(std::move(*maps[index]));
+        maps[index].reset();
     }
     game.SetLootTypes(std::move(loot_types));
 }
 
-model::Game LoadGame(const std::filesystem::path& json_path, bool randomize_spawn_points) {
-    // Загрузить содержимое файла json_path, например, в виде строки
-    // Распарсить строку как JSON, используя boost::json::parse
-    // Загрузить модель игры из файла
-
-    // Открываем файл для чтения
-    std::ifstream file(json_path);
-    if (!file.is_open()) {
-        throw std::runtime_error("Can not open file: "s + json_path.string());
-    }
-
-    // Читаем содержимое файла в строку
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string json_string = buffer.str();
+model::Game LoadGame(const std::filesystem::path& json_path, bool randomize_spawn_points, unsigned threads) {
+    // Документ нужен только на время загрузки, поэтому его узлы выделяются из монотонного ресурса
+    // и освобождаются разом
+    json::monotonic_resource json_resource;
+    const json::value json_root = ParseFile(json_path, &json_resource);
+    const json::object& json_obj = json_root.as_object();
 
-    json::object json_obj = json::parse(json_string).as_object();
-
-    json::array maps_arr = json_obj.at("maps"s).as_array();
+    const json::array& maps_arr = json_obj.at("maps"s).as_array();
 
     double default_dog_speed = DOG_SPEED_BY_DEFAULT;
     if (json_obj.contains("defaultDogSpeed"s)) {
@@ -139,14 +247,14 @@ model::Game LoadGame(const std::filesystem::path& json_path, bool randomize_spaw
 
     int64_t default_bag_capacity = BAG_CAPACITY_BY_DEFAULT;
     if (json_obj.contains("defaultBagCapacity"s)) {
-        default_dog_speed = json_obj.at("defaultBagCapacity"s).as_int64();
+        default_bag_capacity = json_obj.at("defaultBagCapacity"s).as_int64();
     }
 
     if (!json_obj.contains("lootGeneratorConfig"s)) {
         throw std::runtime_error("Invalid config file! 'lootGeneratorConfig' is missing!"s);
     }
 
-    json::object loot_gen_json = json_obj.at("lootGeneratorConfig"s).as_object();
+    const json::object& loot_gen_json = json_obj.at("lootGeneratorConfig"s).as_object();
 
     model::LootGeneratorConfig loot_generator_config;
     try {
@@ -171,18 +279,31 @@ model::Game LoadGame(const std::filesystem::path& json_path, bool randomize_spaw
         retirement_time_sec = json_obj.at("dogRetirementTime"s).as_double();
     }
 
+    size_t default_max_players = model::Map::DEFAULT_MAX_PLAYERS;
+    if (json_obj.contains("defaultMaxPlayers"s)) {
+        default_max_players = ParseMaxPlayers(json_obj.at("defaultMaxPlayers"s));
+    }
+
+    model::MatchmakingPolicy matchmaking_policy = model::MatchmakingPolicy::FILL_FIRST;
+    if (json_obj.contains("matchmakingPolicy"s)) {
+        matchmaking_policy = ParseMatchmakingPolicy(json_obj.at("matchmakingPolicy"s).as_string().c_str());
+    }
+
     model::Game game {
         loot_generator_config,
         std::chrono::milliseconds{
             static_cast<int64_t>(retirement_time_sec * SECONDS_TO_MILISECONDS)
-        }
+        },
+        matchmaking_policy
     };
 
     AddMapsToTheGame(
         game, maps_arr,
         default_dog_speed,
         randomize_spawn_points,
-        default_bag_capacity
+        default_bag_capacity,
+        default_max_players,
+        threads
     );
 
     return game;
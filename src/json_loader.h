@@ -15,18 +15,26 @@ constexpr static double DEFAULT_RETIREMENT_TIME_SEC = 60.0;
 namespace json = boost::json;
 using namespace std::literals;
 
+// Карты строятся в threads потоках, 0 - по числу ядер
 void AddMapsToTheGame(
     model::Game& game,
     const json::array& map_arr,
     double default_dog_speed,
     bool randomize_spawn_points,
-    int64_t default_bag_capacity
+    int64_t default_bag_capacity,
+    size_t default_max_players = model::Map::DEFAULT_MAX_PLAYERS,
+    unsigned threads = 1
 );
 
+size_t ParseMaxPlayers(const json::value& max_players);
+
+model::MatchmakingPolicy ParseMatchmakingPolicy(const std::string& policy);
+
 void AddRoadsToTheMap(model::Map& map, const json::array& roads_arr);
 void AddBuildingsToTheMap(model::Map& map, const json::array& buildings_arr);
 void AddOfficesToTheMap(model::Map& map, const json::array& offices_arr);
 
-model::Game LoadGame(const std::filesystem::path& json_path, bool randomize_spawn_points);
+// Разбирает файл потоково и строит карты в threads потоках, 0 - по числу ядер
+model::Game LoadGame(const std::filesystem::path& json_path, bool randomize_spawn_points, unsigned threads = 0);
 
 }  // namespace json_loader
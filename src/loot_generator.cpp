@@ -1,6 +1,7 @@
 #include "loot_generator.h"
 
 #include <algorithm>
+#include <cassert>
 #include <cmath>
 
 namespace loot_gen {
@@ -9,18 +10,42 @@ unsigned LootGenerator::Generate(
     TimeInterval time_delta,
     unsigned loot_count,
     unsigned looter_count) {
-    
+    return Generate(state_, time_delta, loot_count, looter_count);
+}
+
+unsigned LootGenerator::Generate(
+    State& state,
+    TimeInterval time_delta,
+    unsigned loot_count,
+    unsigned looter_count) const {
+
     // Остальная логика генератора
-    time_without_loot_ += time_delta;
+    state.time_without_loot += time_delta;
     const unsigned loot_shortage = loot_count > looter_count ? 0u : looter_count - loot_count;
-    const double ratio = std::chrono::duration<double>{time_without_loot_} / base_interval_;
+    if (loot_shortage == 0) {
+        // Трофеев хватает всем мародёрам - не тратим время на pow и генератор случайных чисел
+        return 0;
+    }
+    const double ratio = std::chrono::duration<double>{state.time_without_loot} / base_interval_;
     const double probability
         = std::clamp((1.0 - std::pow(1.0 - probability_, ratio)) * random_generator_(), 0.0, 1.0);
     const unsigned generated_loot = static_cast<unsigned>(std::round(loot_shortage * probability));
     if (generated_loot > 0) {
-        time_without_loot_ = {};
+        state.time_without_loot = {};
     }
     return generated_loot;
 }
 
+void LootGenerator::Generate(
+    TimeInterval time_delta,
+    std::span<const Request> requests,
+    std::span<unsigned> generated) const {
+    assert(requests.size() == generated.size());
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const Request& request = requests[i];
+        generated[i] = Generate(*request.state, time_delta, request.loot_count, request.looter_count);
+    }
+}
+
 } // namespace loot_gen
@@ -1,6 +1,7 @@
 #pragma once
 #include <chrono>
 #include <functional>
+#include <span>
 
 namespace loot_gen {
 
@@ -12,6 +13,28 @@ public:
     using RandomGenerator = std::function<double()>;
     using TimeInterval = std::chrono::milliseconds;
 
+    /*
+     * Состояние генератора, принадлежащее одной игровой сессии.
+     * Хранится в самой сессии, поэтому частота появления трофеев
+     * в сессии не зависит от количества других сессий.
+     */
+    struct State {
+        TimeInterval time_without_loot{};
+    };
+
+    /*
+     * Запрос на генерацию трофеев для одной сессии в пакетном режиме
+     *
+     * state - состояние генератора сессии
+     * loot_count - количество трофеев на карте сессии
+     * looter_count - количество мародёров в сессии
+     */
+    struct Request {
+        State* state = nullptr;
+        unsigned loot_count = 0;
+        unsigned looter_count = 0;
+    };
+
     /*
      * base_interval - базовый отрезок времени > 0
      * probability - вероятность появления трофея в течение базового интервала времени
@@ -35,13 +58,24 @@ public:
      */
     unsigned Generate(TimeInterval time_delta, unsigned loot_count, unsigned looter_count);
 
+    /*
+     * То же, что и Generate выше, но для состояния конкретной сессии
+     */
+    unsigned Generate(State& state, TimeInterval time_delta, unsigned loot_count, unsigned looter_count) const;
+
+    /*
+     * Пакетная генерация: за один проход вычисляет количество трофеев для всех сессий.
+     * generated[i] - количество трофеев для requests[i], размеры спанов должны совпадать.
+     */
+    void Generate(TimeInterval time_delta, std::span<const Request> requests, std::span<unsigned> generated) const;
+
 private:
     static double DefaultGenerator() noexcept {
         return 1.0;
     };
     TimeInterval base_interval_;
     double probability_;
-    TimeInterval time_without_loot_{};
+    State state_;
     RandomGenerator random_generator_;
 };
 
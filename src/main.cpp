@@ -1,11 +1,20 @@
 #include "sdk.h"
 
+#include <boost/asio/executor_work_guard.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/signal_set.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <iostream>
 #include <filesystem>
 #include <thread>
 #include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#endif
 
 #include "ticker.h"
 #include "programm_options.h"
@@ -15,6 +24,8 @@
 #include "request_handler.h"
 #include "logger.h"
 #include "serialization_listener.h"
+#include "metrics.h"
+#include "profiler.h"
 
 using namespace std::literals;
 using namespace logger;
@@ -25,6 +36,8 @@ namespace fs = std::filesystem;
 namespace {
 
 constexpr const char GAME_DB_URL[]{"GAME_DB_URL"};
+// Токен доступа к /api/v1/admin/stats. Без него запрос статистики отключён
+constexpr const char GAME_ADMIN_TOKEN[]{"GAME_ADMIN_TOKEN"};
 
 application::AppConfig GetConfigFromEnv() {
     application::AppConfig config;
@@ -36,6 +49,29 @@ application::AppConfig GetConfigFromEnv() {
     return config;
 }
 
+void SaveProfilerTrace(const fs::path& trace_file) {
+    try {
+        profiler::SaveChromeTrace(trace_file);
+        LOG_WITH_DATA(info, (json::object{{"file", trace_file.string()}}), "profiler trace saved"sv);
+    } catch (const std::exception& ex) {
+        LOG_WITH_DATA(error, json::object{}, "Failed to save profiler trace: "s + ex.what());
+    }
+}
+
+// Сохраняет трассировку профилировщика по каждому сигналу SIGUSR1.
+// Выгрузка занимает десятки миллисекунд, поэтому выполняется в saver, а не в потоке ввода-вывода
+void WaitProfilerSignal(net::signal_set& signals, net::thread_pool& saver, const fs::path& trace_file) {
+    signals.async_wait([&signals, &saver, trace_file](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+        if (ec) {
+            return;
+        }
+        net::post(saver, [trace_file] {
+            SaveProfilerTrace(trace_file);
+        });
+        WaitProfilerSignal(signals, saver, trace_file);
+    });
+}
+
 // Запускает функцию fn на n потоках, включая текущий
 template <typename Fn>
 void RunWorkers(unsigned n, const Fn& fn) {
@@ -49,6 +85,31 @@ void RunWorkers(unsigned n, const Fn& fn) {
     fn();
 }
 
+// Привязывает текущий поток к ядру, чтобы шард не мигрировал между ядрами
+void PinCurrentThreadToCore(unsigned core) {
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core % std::max(1u, std::thread::hardware_concurrency()), &cpu_set);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#endif
+}
+
+// Запускает каждый io_context в отдельном потоке, привязанном к своему ядру.
+// Первый io_context выполняется в текущем потоке
+void RunShards(const std::vector<net::io_context*>& shards) {
+    std::vector<std::jthread> workers;
+    workers.reserve(shards.size() - 1);
+    for (unsigned i = 1; i < shards.size(); ++i) {
+        workers.emplace_back([ioc = shards[i], i] {
+            PinCurrentThreadToCore(i);
+            ioc->run();
+        });
+    }
+    PinCurrentThreadToCore(0);
+    shards.front()->run();
+}
+
 }  // namespace
 
 int main(int argc, const char* argv[]) {
@@ -58,21 +119,58 @@ int main(int argc, const char* argv[]) {
     if (!args) {
         std::cerr << "Usage: ./game_server [--tick-period <time-in-ms>] --config-file <config-path> "
                   << "--www-root <static-files-dir> --randomize-spawn-points=<1/0>"
-                  << "[--state-file <state-file>] [--save-state-period <time-in-ms>]" 
+                  << "[--state-file <state-file>] [--save-state-period <time-in-ms>] [--io-shards <n>] [--tick-catch-up <skip|merge|substeps>] [--max-tick-duration <time-in-ms>] [--metrics]"
+                  << "[--random-seed <n>] [--fixed-time-step <time-in-ms>] [--record-replay <replay-file>]" 
+                  << "[--records-storage <postgres|memory>] [--records-file <records-file>] [--profile-file <trace-file>]"
                   << std::endl;
         return EXIT_FAILURE;
     }
+    if (args->metrics) {
+        metrics::Enable();
+    }
+    if (!args->profile_file.empty()) {
+        profiler::Enable(args->profile_buffer);
+    }
     try {
         // 1. Загружаем карту из файла и построить модель игры
         model::Game game = json_loader::LoadGame(args->config_file, args->randomize_spawn_points);
         fs::path static_files_dir{ args->www_root };
 
-        // 2. Инициализируем io_context
+        // 2. Инициализируем io_context.
+        // В режиме шардов каждый io_context обслуживается одним потоком, ioc - нулевой шард.
+        // Шардируется только ввод-вывод: Application, api_strand и тики одни на все шарды
+        // и выполняются в отдельном game_ioc без acceptor'а, иначе соединения, принятые шардом,
+        // ждали бы каждый тик и сохранение состояния
         const unsigned num_threads = std::thread::hardware_concurrency();
-        net::io_context ioc(num_threads);
+        const unsigned num_shards = args->io_shards;
+        net::io_context ioc(num_shards ? 1 : num_threads);
+        std::vector<std::unique_ptr<net::io_context>> extra_shards;
+        std::vector<net::io_context*> shards{&ioc};
+        for (unsigned i = 1; i < num_shards; ++i) {
+            shards.push_back(extra_shards.emplace_back(std::make_unique<net::io_context>(1)).get());
+        }
+        std::optional<net::io_context> game_ioc;
+        if (num_shards) {
+            game_ioc.emplace(1);
+        }
+        net::io_context& strand_ioc = game_ioc ? *game_ioc : ioc;
 
         // 3. Создаем приложение
-        application::Application app{ std::move(game), application::AppConfig{} };
+        application::AppConfig app_config;
+        app_config.records_storage = application::ParseRecordsStorage(args->records_storage);
+        app_config.records_file = args->records_file;
+        app_config.random_seed = args->random_seed;
+        app_config.fixed_time_step = std::chrono::milliseconds(args->fixed_time_step);
+        if (!args->record_replay.empty()) {
+            // Журнал воспроизводится только детерминированным моделированием
+            if (!args->state_file.empty() && fs::exists(args->state_file)) {
+                throw std::runtime_error("Replay can only be recorded from an empty game, remove the state file"s);
+            }
+            if (!app_config.random_seed) {
+                app_config.random_seed = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+            }
+        }
+        application::Application app{ std::move(game), app_config };
         // application::Application app{ std::move(game), GetConfigFromEnv() }; - ДЛЯ ТЕСТИРОВАНИЯ ЛОКАЛЬНО, НЕ В КОНТЕЙНЕРЕ
 
         // 4. Добавляем слушатель для сериализации, если указан файл состояния
@@ -96,27 +194,69 @@ int main(int argc, const char* argv[]) {
             app.SetListener(listener);
         }
 
+        std::shared_ptr<replay::ReplayWriter> replay_writer;
+        if (!args->record_replay.empty()) {
+            replay_writer = std::make_shared<replay::ReplayWriter>(args->record_replay, replay::Header{
+                *app_config.random_seed,
+                app_config.fixed_time_step,
+                args->randomize_spawn_points
+            });
+            app.SetReplayWriter(replay_writer);
+        }
+
         // 5. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
         net::signal_set signals(ioc, SIGINT, SIGTERM);
-        signals.async_wait([&ioc](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+        signals.async_wait([&shards, &game_ioc](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
             if (!ec) {
                 LOG_WITH_DATA(info, ServerStopedData(0), "server exited"sv);
-                ioc.stop();
+                for (net::io_context* shard : shards) {
+                    shard->stop();
+                }
+                if (game_ioc) {
+                    game_ioc->stop();
+                }
             }
         });
 
+        // Один поток сохранения: выгрузки по нескольким сигналам подряд не пишут файл одновременно
+        net::thread_pool profiler_saver{1};
+        net::signal_set profiler_signals(ioc);
+        if (!args->profile_file.empty()) {
+            profiler_signals.add(SIGUSR1);
+            WaitProfilerSignal(profiler_signals, profiler_saver, args->profile_file);
+        }
+
         // 6.1 strand для выполнения запросов к API
-        auto api_strand = net::make_strand(ioc);
+        auto api_strand = net::make_strand(strand_ioc);
+
+        // Контроль нагрузки общий для всех шардов и обработчика API.
+        // Если тики в среднем дольше порога (по умолчанию два периода), сервер не успевает,
+        // и запросы, которые встали бы в очередь api_strand, получают 503
+        http_server::AdmissionControl::Config admission_config;
+        admission_config.max_connections = args->max_connections;
+        admission_config.max_api_queue = args->max_api_queue;
+        admission_config.max_tick_duration = std::chrono::milliseconds(
+            args->max_tick_duration ? args->max_tick_duration : 2 * args->tick_period
+        );
+        auto admission = std::make_shared<http_server::AdmissionControl>(admission_config);
 
         // 6.2 Создаем обработчики
         std::shared_ptr<http_handler::ApiRequestHandler> api_handler{
             http_handler::ApiRequestHandler::Create(
                 app,
                 api_strand,
-                !args->tick_period
+                !args->tick_period,
+                admission
             )
         };
-        http_handler::FileRequestHandler file_handler{ static_files_dir };
+        if (const char* admin_token = std::getenv(GAME_ADMIN_TOKEN); admin_token && *admin_token) {
+            api_handler->SetAdminToken(admin_token);
+        }
+        // Статика загружается в память один раз и перечитывается при изменении файлов
+        auto static_file_cache = std::make_shared<http_handler::StaticFileCache>(static_files_dir);
+        static_file_cache->Build();
+        static_file_cache->StartWatching();
+        http_handler::FileRequestHandler file_handler{ static_files_dir, static_file_cache };
 
         // 6.3 Создаём обработчик HTTP-запросов и связываем его с API и File обработчиками
         auto handler = std::make_shared<http_handler::RequestHandler>(std::move(api_handler), std::move(file_handler));
@@ -124,30 +264,92 @@ int main(int argc, const char* argv[]) {
         // 7. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
         const auto address = net::ip::make_address("0.0.0.0");
         constexpr net::ip::port_type port = 8080;
-        http_server::ServeHttp(ioc, {address, port}, [&handler](auto&& req, auto&& send) {
-            handler->operator()(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
-        });
+        // В режиме шардов у каждого шарда свой acceptor на общем порту (SO_REUSEPORT),
+        // соединение обслуживается целиком в шарде, принявшем его
+        http_server::ListenerConfig listener_config;
+        listener_config.reuse_port = num_shards > 0;
+        listener_config.session_limits.body_limit = args->request_body_limit;
+        listener_config.admission = admission;
+        for (net::io_context* shard : shards) {
+            http_server::ServeHttp(*shard, {address, port}, [&handler](auto&& req, auto&& send) {
+                handler->operator()(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
+            }, listener_config);
+        }
 
         // 8. Настраиваем вызов метода Application::Tick каждые time_delta миллисекунд внутри strand
+        std::shared_ptr<ticker::Ticker> game_ticker;
         if (args->tick_period) {
-            auto ticker = std::make_shared<ticker::Ticker>(api_strand, std::chrono::milliseconds(args->tick_period),
-                [&app](std::chrono::milliseconds time_delta) { app.Tick(time_delta); }
+            ticker::Ticker::Config ticker_config;
+            ticker_config.period = std::chrono::milliseconds(args->tick_period);
+            ticker_config.catch_up = ticker::ParseCatchUpPolicy(args->tick_catch_up);
+            ticker_config.max_substeps = args->tick_max_substeps;
+            game_ticker = std::make_shared<ticker::Ticker>(api_strand, ticker_config,
+                [&app, admission](std::chrono::milliseconds time_delta) {
+                    const auto tick_start = std::chrono::steady_clock::now();
+                    app.Tick(time_delta);
+                    admission->OnTickFinished(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - tick_start
+                    ));
+                }
             );
-            ticker->Start();
+            game_ticker->Start();
         }
 
         // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
         LOG_WITH_DATA(info, ServerStartedData(address.to_string(), port), "server started"sv);
 
         // 9. Запускаем обработку асинхронных операций
-        RunWorkers(std::max(1u, num_threads), [&ioc] {
-            ioc.run();
-        });
+        if (num_shards) {
+            // Без --tick-period в game_ioc нет таймеров, работа появляется только с запросами к API
+            auto game_work = net::make_work_guard(*game_ioc);
+            std::jthread game_thread{[&game_ioc] {
+                game_ioc->run();
+            }};
+            try {
+                RunShards(shards);
+            } catch (...) {
+                game_ioc->stop();
+                throw;
+            }
+            // Тик или join, выполняющиеся в момент остановки, должны завершиться до сохранения состояния
+            game_thread.join();
+        } else {
+            RunWorkers(std::max(1u, num_threads), [&ioc] {
+                ioc.run();
+            });
+        }
+
+        // Итоговые счётчики допуска соединений и сброса нагрузки
+        const http_server::AdmissionControl::Stats admission_stats = admission->GetStats();
+        LOG_WITH_DATA(info, (json::object{
+            {"accepted_connections", admission_stats.accepted_connections},
+            {"rejected_connections", admission_stats.rejected_connections},
+            {"idle_timeouts", admission_stats.idle_timeouts},
+            {"shed_requests", admission_stats.shed_requests}
+        }), "admission stats"sv);
+
+        if (game_ticker) {
+            const ticker::Ticker::Stats ticker_stats = game_ticker->GetStats();
+            LOG_WITH_DATA(info, (json::object{
+                {"ticks", ticker_stats.ticks},
+                {"overruns", ticker_stats.overruns},
+                {"late_periods", ticker_stats.late_periods},
+                {"dropped_periods", ticker_stats.dropped_periods},
+                {"max_duration_us", ticker_stats.max_duration.count()}
+            }), "ticker stats"sv);
+        }
 
         // 10. Cохранение при штатном завершении
         if (listener) {
             listener->OnShutdown();
         }
+        if (replay_writer) {
+            replay_writer->Flush();
+        }
+        profiler_saver.join();
+        if (!args->profile_file.empty()) {
+            SaveProfilerTrace(args->profile_file);
+        }
 
     } catch (const std::exception& ex) {
         LOG_WITH_DATA(error, ServerStopedData(EXIT_FAILURE, ex.what()), "server stopped"sv);
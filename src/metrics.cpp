@@ -0,0 +1,237 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace metrics {
+
+using namespace std::literals;
+
+namespace detail {
+std::atomic<bool> enabled{false};
+}  // namespace detail
+
+namespace {
+
+struct HistogramInfo {
+    std::string_view name;
+    std::string_view label;
+    std::string_view label_value;
+    std::string_view help;
+};
+
+constexpr std::string_view REQUEST_HELP = "Time from reading an HTTP request to passing its response to the connection"sv;
+constexpr std::string_view DB_HELP = "Duration of player repository calls"sv;
+
+// Описание гистограмм в порядке перечисления Histogram
+constexpr std::array<HistogramInfo, HISTOGRAM_COUNT> HISTOGRAM_INFO{{
+    {"game_tick_duration_seconds"sv, {}, {}, "Time spent processing a timer tick, including catch-up substeps"sv},
+    {"game_api_queue_wait_seconds"sv, {}, {}, "Time API tasks spend in the api_strand queue"sv},
+    {"game_state_save_duration_seconds"sv, {}, {}, "Duration of saving the game state snapshot"sv},
+    {"game_db_call_duration_seconds"sv, "call"sv, "retire_player"sv, DB_HELP},
+    {"game_db_call_duration_seconds"sv, "call"sv, "get_records"sv, DB_HELP},
+    {"game_http_request_duration_seconds"sv, "route"sv, "maps"sv, REQUEST_HELP},
+    {"game_http_request_duration_seconds"sv, "route"sv, "map"sv, REQUEST_HELP},
+    {"game_http_request_duration_seconds"sv, "route"sv, "join"sv, REQUEST_HELP},
+    {"game_http_request_duration_seconds"sv, "route"sv, "players"sv, REQUEST_HELP},
+    {"game_http_request_duration_seconds"sv, "route"sv, "state"sv, REQUEST_HELP},
+    {"game_http_request_duration_seconds"sv, "route"sv, "action"sv, REQUEST_HELP},
+    {"game_http_request_duration_seconds"sv, "route"sv, "tick"sv, REQUEST_HELP},
+    {"game_http_request_duration_seconds"sv, "route"sv, "records"sv, REQUEST_HELP},
+    {"game_http_request_duration_seconds"sv, "route"sv, "other_api"sv, REQUEST_HELP},
+    {"game_http_request_duration_seconds"sv, "route"sv, "metrics"sv, REQUEST_HELP},
+    {"game_http_request_duration_seconds"sv, "route"sv, "static"sv, REQUEST_HELP},
+}};
+
+struct CounterInfo {
+    std::string_view name;
+    std::string_view help;
+};
+
+constexpr std::array<CounterInfo, COUNTER_COUNT> COUNTER_INFO{{
+    {"game_ticks_total"sv, "Number of ticks performed"sv},
+    {"game_tick_overruns_total"sv, "Number of ticks that took longer than the tick period"sv},
+    {"game_tick_late_periods_total"sv, "Tick periods that elapsed before the ticker could process them on time"sv},
+    {"game_tick_dropped_periods_total"sv, "Tick periods whose time was not passed to the game"sv},
+}};
+
+// Значения верхних границ корзин в секундах для метки le
+constexpr std::array<std::string_view, BUCKET_BOUNDS.size()> BUCKET_LABELS{
+    "0.00005"sv, "0.0001"sv, "0.00025"sv, "0.0005"sv, "0.001"sv, "0.0025"sv, "0.005"sv, "0.01"sv,
+    "0.025"sv, "0.05"sv, "0.1"sv, "0.25"sv, "0.5"sv, "1"sv, "2.5"sv, "5"sv, "10"sv
+};
+
+struct HistogramData {
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+    std::atomic<uint64_t> sum_ns{0};
+};
+
+// Данные одного потока. Пишет в них только поток-владелец, поэтому достаточно
+// раздельных load/store: обновления не теряются, а Collect() видит согласованные слова
+struct ThreadData {
+    std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+    std::array<HistogramData, HISTOGRAM_COUNT> histograms{};
+};
+
+void Add(std::atomic<uint64_t>& value, uint64_t delta) noexcept {
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+class Registry {
+public:
+    // Данные потоков не освобождаются: после завершения потока его значения остаются в сумме
+    ThreadData& Register() {
+        std::lock_guard lock{mutex_};
+        return *threads_.emplace_back(std::make_unique<ThreadData>());
+    }
+
+    Snapshot Collect() const {
+        Snapshot snapshot;
+        std::lock_guard lock{mutex_};
+        for (const std::unique_ptr<ThreadData>& data : threads_) {
+            for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+                snapshot.counters[i] += data->counters[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < HISTOGRAM_COUNT; ++i) {
+                HistogramSnapshot& histogram = snapshot.histograms[i];
+                for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+                    const uint64_t count = data->histograms[i].buckets[bucket].load(std::memory_order_relaxed);
+                    histogram.buckets[bucket] += count;
+                    histogram.count += count;
+                }
+                histogram.sum += std::chrono::nanoseconds(data->histograms[i].sum_ns.load(std::memory_order_relaxed));
+            }
+        }
+        return snapshot;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadData>> threads_;
+};
+
+Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+ThreadData& GetThreadData() {
+    thread_local ThreadData& data = GetRegistry().Register();
+    return data;
+}
+
+void WriteSeconds(std::ostream& os, std::chrono::nanoseconds duration) {
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
+    const int64_t fraction = (duration - seconds).count();
+    os << seconds.count() << '.';
+    // Дробная часть всегда из 9 цифр, чтобы не зависеть от настроек потока вывода
+    for (int64_t divider = 100'000'000; divider > 0; divider /= 10) {
+        os << static_cast<char>('0' + fraction / divider % 10);
+    }
+}
+
+void WriteLabelValue(std::ostream& os, std::string_view value) {
+    for (char c : value) {
+        switch (c) {
+            case '\\': os << "\\\\"sv; break;
+            case '"': os << "\\\""sv; break;
+            case '\n': os << "\\n"sv; break;
+            default: os << c;
+        }
+    }
+}
+
+void WriteLabels(std::ostream& os, std::string_view label, std::string_view label_value, std::string_view le = {}) {
+    if (label.empty() && le.empty()) {
+        return;
+    }
+    os << '{';
+    if (!label.empty()) {
+        os << label << "=\""sv;
+        WriteLabelValue(os, label_value);
+        os << '"';
+        if (!le.empty()) {
+            os << ',';
+        }
+    }
+    if (!le.empty()) {
+        os << "le=\""sv << le << '"';
+    }
+    os << '}';
+}
+
+}  // namespace
+
+void Enable() noexcept {
+    detail::enabled.store(true, std::memory_order_relaxed);
+}
+
+void Increment(Counter counter, uint64_t value) noexcept {
+    if (!IsEnabled()) {
+        return;
+    }
+    Add(GetThreadData().counters[static_cast<size_t>(counter)], value);
+}
+
+void Observe(Histogram histogram, std::chrono::nanoseconds duration) noexcept {
+    if (!IsEnabled()) {
+        return;
+    }
+    duration = std::max(duration, std::chrono::nanoseconds::zero());
+    const size_t bucket = std::lower_bound(BUCKET_BOUNDS.begin(), BUCKET_BOUNDS.end(), duration) - BUCKET_BOUNDS.begin();
+    HistogramData& data = GetThreadData().histograms[static_cast<size_t>(histogram)];
+    Add(data.buckets[bucket], 1);
+    Add(data.sum_ns, duration.count());
+}
+
+Snapshot Collect() {
+    return GetRegistry().Collect();
+}
+
+void WriteHeader(std::ostream& os, std::string_view name, std::string_view type, std::string_view help) {
+    os << "# HELP "sv << name << ' ' << help << '\n';
+    os << "# TYPE "sv << name << ' ' << type << '\n';
+}
+
+void WriteSample(std::ostream& os, std::string_view name, uint64_t value,
+    std::string_view label, std::string_view label_value) {
+    os << name;
+    WriteLabels(os, label, label_value);
+    os << ' ' << value << '\n';
+}
+
+void WriteText(std::ostream& os, const Snapshot& snapshot) {
+    for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+        WriteHeader(os, COUNTER_INFO[i].name, "counter"sv, COUNTER_INFO[i].help);
+        WriteSample(os, COUNTER_INFO[i].name, snapshot.counters[i]);
+    }
+
+    for (size_t i = 0; i < HISTOGRAM_COUNT; ++i) {
+        const HistogramInfo& info = HISTOGRAM_INFO[i];
+        const HistogramSnapshot& histogram = snapshot.histograms[i];
+        // Заголовок выводится один раз на семейство
+        if (i == 0 || HISTOGRAM_INFO[i - 1].name != info.name) {
+            WriteHeader(os, info.name, "histogram"sv, info.help);
+        }
+
+        uint64_t cumulative = 0;
+        for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+            cumulative += histogram.buckets[bucket];
+            os << info.name << "_bucket"sv;
+            WriteLabels(os, info.label, info.label_value, bucket < BUCKET_LABELS.size() ? BUCKET_LABELS[bucket] : "+Inf"sv);
+            os << ' ' << cumulative << '\n';
+        }
+        os << info.name << "_sum"sv;
+        WriteLabels(os, info.label, info.label_value);
+        os << ' ';
+        WriteSeconds(os, histogram.sum);
+        os << '\n';
+        os << info.name << "_count"sv;
+        WriteLabels(os, info.label, info.label_value);
+        os << ' ' << histogram.count << '\n';
+    }
+}
+
+}  // namespace metrics
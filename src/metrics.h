@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace metrics {
+
+/**
+ * Метрики сервера для экспорта в формате Prometheus.
+ * Каждый поток пишет в собственный набор счётчиков без блокировок и без атомарных
+ * операций чтение-модификация-запись, при запросе /metrics наборы всех потоков суммируются.
+ * Сбор метрик выключен, пока не вызван Enable(), и в этом случае запись стоит одной проверки флага
+ */
+
+// Счётчики, только возрастающие
+enum class Counter : size_t {
+    TICKS,
+    TICK_OVERRUNS,
+    TICK_LATE_PERIODS,
+    TICK_DROPPED_PERIODS,
+    COUNT
+};
+
+// Гистограммы длительностей. Метрики одного семейства с разными метками идут подряд
+enum class Histogram : size_t {
+    TICK_DURATION,
+    API_QUEUE_WAIT,
+    STATE_SAVE,
+    DB_RETIRE_PLAYER,
+    DB_GET_RECORDS,
+    REQUEST_MAPS,
+    REQUEST_MAP,
+    REQUEST_JOIN,
+    REQUEST_PLAYERS,
+    REQUEST_STATE,
+    REQUEST_ACTION,
+    REQUEST_TICK,
+    REQUEST_RECORDS,
+    REQUEST_OTHER_API,
+    REQUEST_METRICS,
+    REQUEST_STATIC,
+    COUNT
+};
+
+constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::COUNT);
+constexpr size_t HISTOGRAM_COUNT = static_cast<size_t>(Histogram::COUNT);
+
+// Верхние границы корзин гистограмм, последняя корзина (+Inf) не хранится в массиве
+constexpr std::array<std::chrono::nanoseconds, 17> BUCKET_BOUNDS{
+    std::chrono::microseconds{50}, std::chrono::microseconds{100}, std::chrono::microseconds{250},
+    std::chrono::microseconds{500}, std::chrono::milliseconds{1}, std::chrono::microseconds{2500},
+    std::chrono::milliseconds{5}, std::chrono::milliseconds{10}, std::chrono::milliseconds{25},
+    std::chrono::milliseconds{50}, std::chrono::milliseconds{100}, std::chrono::milliseconds{250},
+    std::chrono::milliseconds{500}, std::chrono::seconds{1}, std::chrono::milliseconds{2500},
+    std::chrono::seconds{5}, std::chrono::seconds{10}
+};
+constexpr size_t BUCKET_COUNT = BUCKET_BOUNDS.size() + 1;
+
+namespace detail {
+extern std::atomic<bool> enabled;
+}  // namespace detail
+
+inline bool IsEnabled() noexcept {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+void Enable() noexcept;
+
+void Increment(Counter counter, uint64_t value = 1) noexcept;
+
+void Observe(Histogram histogram, std::chrono::nanoseconds duration) noexcept;
+
+// Сумма значений всех потоков на момент вызова Collect()
+struct HistogramSnapshot {
+    // Число наблюдений в каждой корзине (не накопленное)
+    std::array<uint64_t, BUCKET_COUNT> buckets{};
+    uint64_t count = 0;
+    std::chrono::nanoseconds sum{0};
+};
+
+struct Snapshot {
+    std::array<uint64_t, COUNTER_COUNT> counters{};
+    std::array<HistogramSnapshot, HISTOGRAM_COUNT> histograms{};
+
+    uint64_t Get(Counter counter) const noexcept {
+        return counters[static_cast<size_t>(counter)];
+    }
+
+    const HistogramSnapshot& Get(Histogram histogram) const noexcept {
+        return histograms[static_cast<size_t>(histogram)];
+    }
+};
+
+Snapshot Collect();
+
+// Выводит счётчики и гистограммы в текстовом формате Prometheus
+void WriteText(std::ostream& os, const Snapshot& snapshot);
+
+// Выводит заголовок семейства метрик (HELP и TYPE)
+void WriteHeader(std::ostream& os, std::string_view name, std::string_view type, std::string_view help);
+
+// Выводит значение метрики с необязательной меткой label="value"
+void WriteSample(std::ostream& os, std::string_view name, uint64_t value,
+    std::string_view label = {}, std::string_view label_value = {});
+
+// Замеряет время жизни объекта и добавляет его в гистограмму
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram histogram) noexcept
+    : histogram_{histogram}, enabled_{IsEnabled()}
+    {
+        if (enabled_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        if (enabled_) {
+            Observe(histogram_, std::chrono::steady_clock::now() - start_);
+        }
+    }
+
+private:
+    Histogram histogram_;
+    bool enabled_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace metrics
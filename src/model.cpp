@@ -1,11 +1,23 @@
 #include "model.h"
 
+#include <cstdlib>
 #include <stdexcept>
 
 namespace model {
 using namespace std::literals;
 
 // --- MAP ------ MAP ------ MAP ------ MAP ------ MAP ------ MAP ------ MAP ---
+namespace {
+
+// Число точек с целыми координатами на дороге
+size_t CountRoadPoints(const Road& road) noexcept {
+    return static_cast<size_t>(
+        std::abs(road.IsHorizontal() ? road.GetEnd().x - road.GetStart().x : road.GetEnd().y - road.GetStart().y)
+    ) + 1;
+}
+
+}  // namespace
+
 void Map::AddOffice(Office office) {
     if (warehouse_id_to_index_.contains(office.GetId())) {
         throw std::invalid_argument("Duplicate warehouse");
@@ -37,11 +49,31 @@ void Map::AddRoad(std::shared_ptr<Road> road) {
             point_to_road_segments_[Point{ road->GetStart().x, begin }].push_back(road);
         }
     }
+    road_segment_refs_ += CountRoadPoints(*road);
 }
 
-Position Map::GetRandomPositionOnRandomRoad() const {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+void Map::AddRoads(Roads roads) {
+    size_t road_points = point_to_road_segments_.size();
+    for (const std::shared_ptr<Road>& road : roads) {
+        road_points += CountRoadPoints(*road);
+    }
+    // Точки пересечений дорог учтены несколько раз, поэтому резерв может быть немного больше нужного
+    roads_.reserve(roads_.size() + roads.size());
+    point_to_road_segments_.reserve(road_points);
+    for (std::shared_ptr<Road>& road : roads) {
+        AddRoad(std::move(road));
+    }
+}
+
+size_t Map::EstimateRoadIndexBytes() const noexcept {
+    using Node = PointToRoadSegments::value_type;
+    // Узел хранит указатель на следующий узел, пару и закешированный хеш, массив корзин - по указателю на корзину
+    return point_to_road_segments_.bucket_count() * sizeof(void*)
+        + point_to_road_segments_.size() * (sizeof(void*) + sizeof(Node) + sizeof(size_t))
+        + road_segment_refs_ * sizeof(std::shared_ptr<Road>);
+}
+
+Position Map::GetRandomPositionOnRandomRoad(RandomEngine& gen) const {
     std::uniform_int_distribution<size_t> dist(0, roads_.size() - 1);
 
     size_t random_road_index = dist(gen);
@@ -115,6 +147,45 @@ void Dog::MoveDog(const std::string& str_dir, double speed) {
     }
 }
 
+void Dog::ScheduleMove(std::string_view str_dir) noexcept {
+    ScheduledMove move = ScheduledMove::STOP;
+    if (str_dir == "U"sv) {
+        move = ScheduledMove::UP;
+    }
+    else if (str_dir == "D"sv) {
+        move = ScheduledMove::DOWN;
+    }
+    else if (str_dir == "R"sv) {
+        move = ScheduledMove::RIGHT;
+    }
+    else if (str_dir == "L"sv) {
+        move = ScheduledMove::LEFT;
+    }
+    scheduled_move_.move.store(move, std::memory_order_release);
+}
+
+std::optional<std::string_view> Dog::TakeScheduledMove() noexcept {
+    // Большинство собак между тиками команд не получают, обходимся без записи
+    if (scheduled_move_.move.load(std::memory_order_relaxed) == ScheduledMove::NONE) {
+        return std::nullopt;
+    }
+    switch (scheduled_move_.move.exchange(ScheduledMove::NONE, std::memory_order_acquire)) {
+    case ScheduledMove::NONE:
+        return std::nullopt;
+    case ScheduledMove::UP:
+        return "U"sv;
+    case ScheduledMove::DOWN:
+        return "D"sv;
+    case ScheduledMove::RIGHT:
+        return "R"sv;
+    case ScheduledMove::LEFT:
+        return "L"sv;
+    case ScheduledMove::STOP:
+        break;
+    }
+    return ""sv;
+}
+
 bool Dog::IsPositionValid(const Position& pos, const std::vector<std::shared_ptr<Road>>& dog_roads) const {
     return std::any_of(dog_roads.begin(), dog_roads.end(), [&pos](const auto& road) {
         const auto& segment = road->GetRoadSegment();
@@ -231,12 +302,13 @@ bool Dog::IsInactive(const std::chrono::milliseconds& inactivity_threshold) cons
 //
 // --- GAME SESSION ------ GAME SESSION ------ GAME SESSION ------ GAME SESSION ---
 std::shared_ptr<Dog> GameSession::CreateDog(const std::string& dog_name) {
-    assert(dogs_.size() != max_dogs_amount_);
+    assert(!IsSessionFull());
     dogs_.emplace_back(std::make_shared<Dog>(
         dog_name,
-        map_->GetDogPosition(),
+        map_->GetDogPosition(random_engine_),
         map_->GetBagCapacityOnMap()
     ));
+    map_->GetCounters().dogs.fetch_add(1, std::memory_order_relaxed);
 
     // Генерируем 1 новый предмет при каждом входе игрока
     GenerateLoot(1);
@@ -244,18 +316,44 @@ std::shared_ptr<Dog> GameSession::CreateDog(const std::string& dog_name) {
     return dogs_.back();
 }
 
-void GameSession::GenerateLoot(unsigned count) {
+GameSession::~GameSession() {
+    MapCounters& counters = map_->GetCounters();
+    counters.sessions.fetch_sub(1, std::memory_order_relaxed);
+    counters.dogs.fetch_sub(dogs_.size(), std::memory_order_relaxed);
+    counters.lost_objects.fetch_sub(lost_objects_.size(), std::memory_order_relaxed);
+}
+
+size_t GameSession::EstimateSessionsBytes(size_t sessions, size_t dogs, size_t lost_objects) noexcept {
+    using LostObjectNode = decltype(lost_objects_)::value_type;
+    // Собака создаётся через make_shared: объект и счётчики ссылок в одном блоке
+    constexpr size_t DOG_BYTES = sizeof(std::shared_ptr<Dog>) + sizeof(Dog) + 2 * sizeof(long);
+    // Узел таблицы предметов и указатель на корзину при коэффициенте заполнения не больше 1
+    constexpr size_t LOST_OBJECT_BYTES = 2 * sizeof(void*) + sizeof(LostObjectNode) + sizeof(size_t);
+    return sessions * sizeof(GameSession) + dogs * DOG_BYTES + lost_objects * LOST_OBJECT_BYTES;
+}
+
+uint64_t GameSession::MakeRandomSeed(Id id, std::optional<uint64_t> random_seed) {
+    if (random_seed) {
+        // splitmix64: соседние id дают независимые зёрна
+        uint64_t z = *random_seed + (*id + 1) * 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
     std::random_device rd;
-    std::mt19937 gen(rd());
+    return (static_cast<uint64_t>(rd()) << 32) | rd();
+}
+
+void GameSession::GenerateLoot(unsigned count) {
     std::uniform_int_distribution<size_t> type_dist(0, map_->GetLootTypesAmount() - 1);
     
     for (unsigned i = 0; i < count; ++i) {
-        size_t type = type_dist(gen);
+        size_t type = type_dist(random_engine_);
         AddLostObject(LostObject{
             LostObject::Id{lost_objects_ids_++},
             type,
-            map_->GetRandomPositionOnRandomRoad(),
-            loot_types_ptr_->GetLootTypeValue(*map_->GetId(), type)
+            map_->GetRandomPositionOnRandomRoad(random_engine_),
+            (*loot_values_)[type]
         });
     }
 }
@@ -269,7 +367,7 @@ class ItemGathererProviderImpl : public collision_detector::ItemGathererProvider
 public:
     ItemGathererProviderImpl(
         const std::vector<std::shared_ptr<Dog>>& dogs,
-        const std::unordered_map<LostObject::Id, LostObject, GameSession::LostObjectIdHasher>& lost_objects,
+        const std::vector<LostObject*>& lost_objects,
         const std::vector<Office>& offices
     ) : dogs_(dogs), lost_objects_(lost_objects), offices_(offices) {}
 
@@ -279,9 +377,8 @@ public:
 
     collision_detector::Item GetItem(size_t idx) const override {
         if (idx < lost_objects_.size()) {
-            auto it = lost_objects_.begin();
-            std::advance(it, idx);
-            return {geom::Point2D{it->second.GetPosition().x, it->second.GetPosition().y}, 0.0};
+            const Position& position = lost_objects_[idx]->GetPosition();
+            return {geom::Point2D{position.x, position.y}, 0.0};
         } else {
             idx -= lost_objects_.size();
             const auto& office = offices_.at(idx);
@@ -294,7 +391,7 @@ public:
     }
 
     collision_detector::Gatherer GetGatherer(size_t idx) const override {
-        std::shared_ptr<Dog> dog = dogs_.at(idx);
+        const std::shared_ptr<Dog>& dog = dogs_.at(idx);
         return {
             geom::Point2D{dog->GetPrevPosition().x, dog->GetPrevPosition().y},
             geom::Point2D{dog->GetDogPosition().x, dog->GetDogPosition().y},
@@ -304,13 +401,14 @@ public:
 
 private:
     const std::vector<std::shared_ptr<Dog>>& dogs_;
-    const std::unordered_map<LostObject::Id, LostObject, GameSession::LostObjectIdHasher>& lost_objects_;
+    const std::vector<LostObject*>& lost_objects_;
     const std::vector<Office>& offices_;
 };
 
 void GameSession::RemoveCollectedObjects() {
     std::unordered_map<LostObject::Id, LostObject, GameSession::LostObjectIdHasher>& objects = GetMutableLostObjects();
     
+    const size_t objects_before = objects.size();
     // Используем erase-remove idiom для unordered_map
     for (auto it = objects.begin(); it != objects.end(); ) {
         if (it->second.IsCollected()) {
@@ -319,25 +417,33 @@ void GameSession::RemoveCollectedObjects() {
             ++it;
         }
     }
+    map_->GetCounters().lost_objects.fetch_sub(objects_before - objects.size(), std::memory_order_relaxed);
 }
 
 void GameSession::HandleCollisions() {
-    ItemGathererProviderImpl provider(GetDogs(), GetLostObjects(), GetMap()->GetOffices());
-    auto events = collision_detector::FindGatherEvents(provider);
+    // Снимок предметов: индекс события напрямую указывает на предмет
+    collision_objects_.clear();
+    collision_objects_.reserve(lost_objects_.size());
+    for (auto& [id, object] : GetMutableLostObjects()) {
+        collision_objects_.push_back(&object);
+    }
+
+    ItemGathererProviderImpl provider(GetDogs(), collision_objects_, GetMap()->GetOffices());
+    // Разбиение на ячейки сохраняет стоимость в расчёте на собаку постоянной в больших сессиях
+    const auto& events = collision_grid_.FindGatherEvents(provider);
 
     for (const auto& event : events) {
-        std::shared_ptr<Dog> dog = GetDogs().at(event.gatherer_id);
+        const std::shared_ptr<Dog>& dog = GetDogs().at(event.gatherer_id);
         
-        if (event.item_id < GetLostObjects().size()) {
+        if (event.item_id < collision_objects_.size()) {
             // Коллизия с предметом
             if (!dog->GetBag().IsFull()) {
-                auto it = GetMutableLostObjects().begin();
-                std::advance(it, event.item_id);
-                if (it->second.IsCollected()) {
+                LostObject& object = *collision_objects_[event.item_id];
+                if (object.IsCollected()) {
                     continue;
                 }
-                it->second.MarkAsCollected();
-                dog->CollectItem(it->second);
+                object.MarkAsCollected();
+                dog->CollectItem(object);
             }
         } else {
             // Коллизия с базой - сдача предметов
@@ -369,13 +475,90 @@ std::vector<std::shared_ptr<Dog>> GameSession::RemoveInactiveDogs(const std::chr
 
     // Удаляем неактивных собак из сесиии
     dogs_.erase(partition_it, dogs_.end());
+    map_->GetCounters().dogs.fetch_sub(inactive_dogs.size(), std::memory_order_relaxed);
     
     return inactive_dogs;
 }
+
+void GameSession::ApplyScheduledMoves(const MoveObserver& on_applied) {
+    const double dog_speed = map_->GetDogSpeedOnMap();
+    for (const auto& dog : dogs_) {
+        if (const auto move = dog->TakeScheduledMove()) {
+            // Строка из одного символа помещается в SSO и не требует выделения памяти
+            const std::string direction{*move};
+            dog->MoveDog(direction, dog_speed);
+            if (on_applied) {
+                on_applied(*dog, direction);
+            }
+        }
+    }
+}
 // --- GAME SESSION ------ GAME SESSION ------ GAME SESSION ------ GAME SESSION ---
 //
 //
 //
+// --- MATCHMAKER ------ MATCHMAKER ------ MATCHMAKER ------ MATCHMAKER ---
+void SessionMatchmaker::Update(const std::shared_ptr<GameSession>& session) {
+    const size_t fill = session->GetDogs().size();
+    if (session->matchmaking_slot_.fill == fill) {
+        return;
+    }
+    Remove(*session);
+
+    // Заполненные сессии в индексе не храним
+    if (session->IsSessionFull()) {
+        return;
+    }
+    if (sessions_by_fill_.size() <= fill) {
+        sessions_by_fill_.resize(session->GetMaxDogsAmount());
+    }
+    std::vector<std::shared_ptr<GameSession>>& group = sessions_by_fill_[fill];
+    session->matchmaking_slot_ = {fill, group.size()};
+    group.push_back(session);
+}
+
+void SessionMatchmaker::Remove(GameSession& session) {
+    GameSession::MatchmakingSlot& slot = session.matchmaking_slot_;
+    if (slot.fill == GameSession::MatchmakingSlot::NOT_INDEXED) {
+        return;
+    }
+    // Удаляем за O(1): на место сессии переносим последнюю сессию группы
+    std::vector<std::shared_ptr<GameSession>>& group = sessions_by_fill_[slot.fill];
+    if (slot.index + 1 != group.size()) {
+        group[slot.index] = std::move(group.back());
+        group[slot.index]->matchmaking_slot_.index = slot.index;
+    }
+    group.pop_back();
+    slot = {};
+}
+
+std::shared_ptr<GameSession> SessionMatchmaker::Find() const noexcept {
+    if (policy_ == MatchmakingPolicy::BALANCE) {
+        for (const auto& group : sessions_by_fill_) {
+            if (!group.empty()) {
+                return group.back();
+            }
+        }
+    } else {
+        for (auto it = sessions_by_fill_.rbegin(); it != sessions_by_fill_.rend(); ++it) {
+            if (!it->empty()) {
+                return it->back();
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool SessionMatchmaker::Contains(const GameSession& session) const noexcept {
+    const GameSession::MatchmakingSlot& slot = session.matchmaking_slot_;
+    return slot.fill < sessions_by_fill_.size()
+        && slot.index < sessions_by_fill_[slot.fill].size()
+        && sessions_by_fill_[slot.fill][slot.index].get() == &session;
+}
+// --- MATCHMAKER ------ MATCHMAKER ------ MATCHMAKER ------ MATCHMAKER ---
+//
+//
+//
 // --- GAME ------ GAME ------ GAME ------ GAME ------ GAME ------ GAME ------ GAME ---
 void Game::AddMap(Map map) {
     const size_t index = maps_.size();
@@ -402,28 +585,21 @@ void Game::AddSession(const Map::Id& map_id, std::shared_ptr<GameSession> sessio
 
     if (auto [it, inserted] = map_id_to_sessions_[map_id].emplace(session); !inserted) {
         throw std::invalid_argument("Session with id "s + std::to_string(*session->GetId()) + " already exists"s);
-    } else {
-        try {
-            map_id_to_sessions_.at(map_id).emplace(std::move(session));
-        }
-        catch (...) {
-            map_id_to_sessions_.at(map_id).erase(it);
-            throw;
-        }
     }
+    map_id_to_matchmaker_.try_emplace(map_id, matchmaking_policy_).first->second.Update(session);
 }
 
 std::shared_ptr<GameSession> Game::FindSession(const Map::Id& id) const noexcept {
-    if (auto it = map_id_to_sessions_.find(id); it != map_id_to_sessions_.end()) {
-        std::unordered_set<std::shared_ptr<GameSession>> cur_map_sessions = it->second;
-        for (std::shared_ptr<GameSession> session : cur_map_sessions) {
-            if (!session->IsSessionFull()) {
-                return session;
-            }
-        }
-        return nullptr;
+    if (auto it = map_id_to_matchmaker_.find(id); it != map_id_to_matchmaker_.end()) {
+        return it->second.Find();
     }
     return nullptr;
 }
+
+void Game::UpdateSessionOccupancy(const std::shared_ptr<GameSession>& session) {
+    if (auto it = map_id_to_matchmaker_.find(session->GetMap()->GetId()); it != map_id_to_matchmaker_.end()) {
+        it->second.Update(session);
+    }
+}
 // --- GAME ------ GAME ------ GAME ------ GAME ------ GAME ------ GAME ------ GAME ---
 }  // namespace model
@@ -2,6 +2,7 @@
 
 #include <boost/asio/io_context.hpp>
 
+#include <atomic>
 #include <string>
 #include <unordered_map>
 #include <memory>
@@ -9,11 +10,15 @@
 #include <unordered_set>
 #include <random>
 #include <chrono>
+#include <functional>
+#include <optional>
+#include <string_view>
 #include <iostream> // KILL ME
 
 #include "tagged.h"
 #include "extra_data.h"
 #include "collision_detector.h"
+#include "loot_generator.h"
 
 namespace model {
 
@@ -24,6 +29,10 @@ namespace net = boost::asio;
 using Dimension = int;
 using Coord = Dimension;
 
+// Генератор псевдослучайных чисел модели. У каждой сессии свой генератор,
+// поэтому результат не зависит от порядка обработки сессий
+using RandomEngine = std::mt19937_64;
+
 struct Point {
     Coord x, y;
 
@@ -210,6 +219,24 @@ private:
     bool is_collected_ = false;
 };
 
+// Количество объектов во всех сессиях карты. Счётчики изменяются вместе с объектами
+// и читаются из любого потока, поэтому статистику можно получить без обхода сессий в api_strand
+struct MapCounters {
+    MapCounters() = default;
+
+    // Сессии ссылаются на исходную карту, копия карты начинает с нулевых счётчиков
+    MapCounters(const MapCounters&) noexcept {
+
+    }
+
+    MapCounters& operator=(const MapCounters&) = delete;
+
+    std::atomic<size_t> sessions{0};
+    std::atomic<size_t> dogs{0};
+    std::atomic<size_t> lost_objects{0};
+    std::atomic<size_t> tokens{0};
+};
+
 class Map {
 public:
     using Id = util::Tagged<std::string, Map>;
@@ -218,29 +245,37 @@ public:
     using Offices = std::vector<Office>;
 
     struct PointHasher {
-        size_t operator()(const Point& point) const {
-            size_t hash_1 = std::hash<int>{}(point.x);
-            size_t hash_2 = std::hash<int>{}(point.y);
-            return hash_1 ^ (hash_2 << 1);
+        // Координаты упаковываются в 64-битный ключ, биты которого перемешиваются умножением.
+        // Хеш x ^ (y << 1) совпадал у многих точек сетки дорог, и их цепочки в корзинах были длинными
+        size_t operator()(const Point& point) const noexcept {
+            const uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(point.x)) << 32)
+                | static_cast<uint32_t>(point.y);
+            const uint64_t hash = key * 0x9e3779b97f4a7c15ull;
+            return static_cast<size_t>(hash ^ (hash >> 32));
         }
     };
 
     using PointToRoadSegments = std::unordered_map<Point, std::vector<std::shared_ptr<Road>>, PointHasher>;
 
+    // Максимальное количество игроков в одной сессии карты по умолчанию
+    constexpr static size_t DEFAULT_MAX_PLAYERS = 5;
+
     Map(
         Id id,
         std::string name,
         double dog_speed,
         bool randomize_spawn_points,
         size_t loot_types_amount,
-        int64_t bag_capacity
+        int64_t bag_capacity,
+        size_t max_players = DEFAULT_MAX_PLAYERS
     ) noexcept
     : id_(std::move(id)),
     name_(std::move(name)),
     dog_speed_(dog_speed),
     randomize_spawn_points_(randomize_spawn_points),
     loot_types_amount_(loot_types_amount),
-    bag_capacity_(bag_capacity)
+    bag_capacity_(bag_capacity),
+    max_players_(max_players)
     {
 
     }
@@ -267,6 +302,10 @@ public:
 
     void AddRoad(std::shared_ptr<Road> road);
 
+    // Добавляет дороги, заранее резервируя место в индексе точек по суммарной длине дорог,
+    // чтобы индекс не перестраивался по мере заполнения
+    void AddRoads(Roads roads);
+
     void AddBuilding(const Building& building) {
         buildings_.emplace_back(building);
     }
@@ -277,12 +316,12 @@ public:
         randomize_spawn_points_ = randomize_spawn_points;
     }
 
-    Position GetRandomPositionOnRandomRoad() const;
+    Position GetRandomPositionOnRandomRoad(RandomEngine& random_engine) const;
 
     Position GetStartPointOnFirstRoad() const;
 
-    Position GetDogPosition() const {
-        return randomize_spawn_points_ ? GetRandomPositionOnRandomRoad() : GetStartPointOnFirstRoad();
+    Position GetDogPosition(RandomEngine& random_engine) const {
+        return randomize_spawn_points_ ? GetRandomPositionOnRandomRoad(random_engine) : GetStartPointOnFirstRoad();
     }
 
     double GetDogSpeedOnMap() {
@@ -293,6 +332,18 @@ public:
         return point_to_road_segments_;
     }
 
+    // Приблизительный объём памяти индекса точек дорог в байтах.
+    // Индекс заполняется только при загрузке, поэтому оценка не требует синхронизации
+    size_t EstimateRoadIndexBytes() const noexcept;
+
+    MapCounters& GetCounters() noexcept {
+        return counters_;
+    }
+
+    const MapCounters& GetCounters() const noexcept {
+        return counters_;
+    }
+
     size_t GetLootTypesAmount() const noexcept {
         return loot_types_amount_;
     }
@@ -301,6 +352,10 @@ public:
         return bag_capacity_;
     }
 
+    size_t GetMaxPlayers() const noexcept {
+        return max_players_;
+    }
+
 private:
     double dog_speed_;
     using OfficeIdToIndex = std::unordered_map<Office::Id, size_t, util::TaggedHasher<Office::Id>>;
@@ -314,12 +369,18 @@ private:
     Offices offices_;
 
     PointToRoadSegments point_to_road_segments_;
+    // Суммарная длина списков дорог в point_to_road_segments_
+    size_t road_segment_refs_ = 0;
+
+    MapCounters counters_;
 
     bool randomize_spawn_points_;
 
     size_t loot_types_amount_ = 0;
 
     int64_t bag_capacity_;
+
+    size_t max_players_;
 };
 
 struct Speed {
@@ -430,6 +491,13 @@ public:
 
     void MoveDog(const std::string& str_dir, double speed);
 
+    // Запоминает команду движения до начала следующего тика. Можно вызывать из любого потока,
+    // для собаки хранится только последняя команда
+    void ScheduleMove(std::string_view str_dir) noexcept;
+
+    // Забирает запомненную команду: направление ("" - остановка) или nullopt, если команды не было
+    std::optional<std::string_view> TakeScheduledMove() noexcept;
+
     bool IsPositionValid(const Position& pos, const std::vector<std::shared_ptr<Road>>& dog_roads) const;
 
     void GetWallStopAndSetPosition(const Position& pos, const std::vector<std::shared_ptr<Road>>& dog_roads);
@@ -509,6 +577,27 @@ private:
 
     std::chrono::milliseconds time_since_join_{0};
     std::chrono::milliseconds time_since_last_move_{0};
+
+    enum class ScheduledMove : uint8_t {
+        NONE,
+        STOP,
+        UP,
+        DOWN,
+        LEFT,
+        RIGHT
+    };
+    // Ячейка команды не копирует её: ожидающая команда не входит в состояние собаки
+    struct ScheduledMoveSlot {
+        std::atomic<ScheduledMove> move{ScheduledMove::NONE};
+
+        ScheduledMoveSlot() = default;
+        ScheduledMoveSlot(const ScheduledMoveSlot&) noexcept {
+        }
+        ScheduledMoveSlot& operator=(const ScheduledMoveSlot&) noexcept {
+            return *this;
+        }
+    };
+    ScheduledMoveSlot scheduled_move_;
 };
 
 class GameSession {
@@ -517,18 +606,37 @@ public:
     using GameSesionIdHasher = util::TaggedHasher<GameSession::Id>;
     using LostObjectIdHasher = util::TaggedHasher<LostObject::Id>;
 
-    GameSession(std::shared_ptr<Map> map, std::shared_ptr<extra_data::LootTypes> loot_types_ptr)
-    : id_(Id{ GameSession::sessions_ids_++ }), map_(map), loot_types_ptr_(loot_types_ptr)
+    // Генератор сессии инициализируется зерном, выведенным из random_seed и id сессии,
+    // без random_seed - из std::random_device
+    GameSession(
+        std::shared_ptr<Map> map,
+        std::shared_ptr<const extra_data::LootTypes> loot_types_ptr,
+        std::optional<uint64_t> random_seed = std::nullopt
+    )
+    : GameSession(Id{ GameSession::sessions_ids_++ }, std::move(map), std::move(loot_types_ptr), random_seed)
     {
 
     };
 
-    GameSession(Id id, std::shared_ptr<Map> map, std::shared_ptr<extra_data::LootTypes> loot_types_ptr)
-    : id_(id), map_(map), loot_types_ptr_(loot_types_ptr)
+    GameSession(
+        Id id,
+        std::shared_ptr<Map> map,
+        std::shared_ptr<const extra_data::LootTypes> loot_types_ptr,
+        std::optional<uint64_t> random_seed = std::nullopt
+    )
+    : id_(id), map_(map), max_dogs_amount_(map_->GetMaxPlayers()), loot_types_ptr_(loot_types_ptr),
+    // Таблица ценностей разрешается один раз, дальше доступ по индексу типа
+    loot_values_(&loot_types_ptr_->GetCurrentMapLootValues(*map_->GetId())),
+    random_engine_(MakeRandomSeed(id, random_seed))
     {
-
+        map_->GetCounters().sessions.fetch_add(1, std::memory_order_relaxed);
     };
 
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+
+    ~GameSession();
+
     const Id& GetId() const noexcept {
         return id_;
     }
@@ -541,10 +649,15 @@ public:
 
     void AddDog(std::shared_ptr<Dog> dog) {
         dogs_.push_back(dog);
+        map_->GetCounters().dogs.fetch_add(1, std::memory_order_relaxed);
     }
 
     bool IsSessionFull() const {
-        return dogs_.size() == max_dogs_amount_;
+        return dogs_.size() >= max_dogs_amount_;
+    }
+
+    size_t GetMaxDogsAmount() const noexcept {
+        return max_dogs_amount_;
     }
 
     const std::vector<std::shared_ptr<Dog>>& GetDogs() const {
@@ -552,7 +665,9 @@ public:
     }
 
     void AddLostObject(const LostObject& object) {
-        lost_objects_.emplace(object.GetId(), object);
+        if (lost_objects_.emplace(object.GetId(), object).second) {
+            map_->GetCounters().lost_objects.fetch_add(1, std::memory_order_relaxed);
+        }
     }
 
     void GenerateLoot(unsigned count);
@@ -573,19 +688,66 @@ public:
 
     std::vector<std::shared_ptr<Dog>> RemoveInactiveDogs(const std::chrono::milliseconds& inactivity_threshold);
 
+    // Приблизительный объём памяти сессий с заданным числом собак и предметов в байтах
+    static size_t EstimateSessionsBytes(size_t sessions, size_t dogs, size_t lost_objects) noexcept;
+
+    // Состояние генератора трофеев этой сессии
+    loot_gen::LootGenerator::State& GetLootGeneratorState() {
+        return loot_generator_state_;
+    }
+
+    // Запоминает команду движения собаки до следующего тика. Можно вызывать из любого потока
+    void ScheduleDogMove(const std::shared_ptr<Dog>& dog, std::string_view move_direction) noexcept {
+        dog->ScheduleMove(move_direction);
+    }
+
+    using MoveObserver = std::function<void(const Dog& dog, const std::string& direction)>;
+
+    // Применяет запомненные команды движения собак сессии.
+    // on_applied вызывается для каждой применённой команды
+    void ApplyScheduledMoves(const MoveObserver& on_applied = {});
+
 private:
+    friend class SessionMatchmaker;
+
     inline static size_t sessions_ids_ = 0;
     Id id_;
 
     std::shared_ptr<Map> map_;
 
-    const size_t max_dogs_amount_ = 5;
+    const size_t max_dogs_amount_;
     std::vector<std::shared_ptr<Dog>> dogs_;
 
     inline static size_t lost_objects_ids_ = 0;
     std::unordered_map<LostObject::Id, LostObject, LostObjectIdHasher> lost_objects_;
 
-    std::shared_ptr<extra_data::LootTypes> loot_types_ptr_;
+    // Общие для всей игры неизменяемые типы трофеев
+    std::shared_ptr<const extra_data::LootTypes> loot_types_ptr_;
+    // Ценности трофеев карты сессии (принадлежат *loot_types_ptr_)
+    const extra_data::LootTypes::LootValues* loot_values_;
+
+    loot_gen::LootGenerator::State loot_generator_state_;
+
+    // Зерно генератора сессии: из общего зерна и id сессии или из std::random_device
+    static uint64_t MakeRandomSeed(Id id, std::optional<uint64_t> random_seed);
+    RandomEngine random_engine_;
+
+    // Положение сессии в индексе SessionMatchmaker (заполненность и позиция в группе)
+    struct MatchmakingSlot {
+        static constexpr size_t NOT_INDEXED = static_cast<size_t>(-1);
+        size_t fill = NOT_INDEXED;
+        size_t index = 0;
+    };
+    MatchmakingSlot matchmaking_slot_;
+
+    // Указатели на предметы для доступа по индексу при обработке коллизий,
+    // буфер переиспользуется между тиками
+    std::vector<LostObject*> collision_objects_;
+
+    // Сторона ячейки сетки, по которой раскладываются предметы при поиске коллизий
+    constexpr static double COLLISION_CELL_SIZE = 4.0;
+    // Сетка предметов для поиска коллизий, её буферы переиспользуются между тиками
+    collision_detector::ItemGrid collision_grid_{COLLISION_CELL_SIZE};
 
     void RemoveCollectedObjects();
 
@@ -595,6 +757,40 @@ private:
     }
 };
 
+// Политика выбора сессии для нового игрока
+enum class MatchmakingPolicy {
+    FILL_FIRST, // в первую очередь заполняем самые заполненные сессии
+    BALANCE     // распределяем игроков равномерно по сессиям
+};
+
+// Индекс сессий одной карты со свободными местами, сгруппированных по заполненности.
+// Сессия хранит свою позицию в индексе, поэтому обновление и удаление выполняются за O(1),
+// а поиск просматривает не больше групп, чем мест в сессии
+class SessionMatchmaker {
+public:
+    explicit SessionMatchmaker(MatchmakingPolicy policy = MatchmakingPolicy::FILL_FIRST)
+    : policy_(policy)
+    {
+
+    }
+
+    // Перемещает сессию в группу, соответствующую текущему количеству собак
+    void Update(const std::shared_ptr<GameSession>& session);
+
+    void Remove(GameSession& session);
+
+    // Возвращает сессию со свободным местом согласно политике или nullptr.
+    // Просматривает группы заполненности, то есть не больше maxPlayers групп
+    std::shared_ptr<GameSession> Find() const noexcept;
+
+    // Проверяет, что сессия хранится в индексе на позиции, записанной в её MatchmakingSlot
+    bool Contains(const GameSession& session) const noexcept;
+
+private:
+    MatchmakingPolicy policy_;
+    std::vector<std::vector<std::shared_ptr<GameSession>>> sessions_by_fill_;
+};
+
 struct LootGeneratorConfig {
     int period;
     double probability;
@@ -606,8 +802,14 @@ public:
     using MapIdHasher = util::TaggedHasher<Map::Id>;
     using MapIdToSessions = std::unordered_map<Map::Id, std::unordered_set<std::shared_ptr<GameSession>>, MapIdHasher>;
 
-    Game(LootGeneratorConfig loot_generator_config, std::chrono::milliseconds max_inactivity_time) 
-    : loot_generator_config_{loot_generator_config}, max_inactivity_time_{max_inactivity_time}
+    Game(
+        LootGeneratorConfig loot_generator_config,
+        std::chrono::milliseconds max_inactivity_time,
+        MatchmakingPolicy matchmaking_policy = MatchmakingPolicy::FILL_FIRST
+    ) 
+    : loot_generator_config_{loot_generator_config},
+    max_inactivity_time_{max_inactivity_time},
+    matchmaking_policy_{matchmaking_policy}
     {
 
     }
@@ -624,15 +826,23 @@ public:
 
     std::shared_ptr<GameSession> FindSession(const Map::Id& id) const noexcept;
 
+    // Должен вызываться после изменения количества собак в сессии
+    void UpdateSessionOccupancy(const std::shared_ptr<GameSession>& session);
+
     const MapIdToSessions& GetMapIdToSession() const noexcept {
         return map_id_to_sessions_;
     }
 
-    void SetLootTypes(const extra_data::LootTypes& loot_types) {
-        loot_types_ = std::move(loot_types);
+    void SetLootTypes(extra_data::LootTypes loot_types) {
+        loot_types_ = std::make_shared<const extra_data::LootTypes>(std::move(loot_types));
     }
 
     const extra_data::LootTypes& GetLootTypes() const {
+        return *loot_types_;
+    }
+
+    // Типы трофеев разделяются всеми сессиями игры без копирования
+    std::shared_ptr<const extra_data::LootTypes> GetSharedLootTypes() const {
         return loot_types_;
     }
 
@@ -644,6 +854,16 @@ public:
         return max_inactivity_time_;
     }
 
+    // Зерно, из которого выводятся зёрна генераторов новых сессий игры.
+    // Без зерна генераторы инициализируются из std::random_device
+    void SetRandomSeed(std::optional<uint64_t> seed) noexcept {
+        random_seed_ = seed;
+    }
+
+    std::optional<uint64_t> GetRandomSeed() const noexcept {
+        return random_seed_;
+    }
+
 private:
     using MapIdToIndex = std::unordered_map<Map::Id, size_t, MapIdHasher>;
 
@@ -652,10 +872,17 @@ private:
 
     MapIdToSessions map_id_to_sessions_;
 
+    using MapIdToMatchmaker = std::unordered_map<Map::Id, SessionMatchmaker, MapIdHasher>;
+    MapIdToMatchmaker map_id_to_matchmaker_;
+
     LootGeneratorConfig loot_generator_config_;
-    extra_data::LootTypes loot_types_;
+    std::shared_ptr<const extra_data::LootTypes> loot_types_ = std::make_shared<const extra_data::LootTypes>();
 
     std::chrono::milliseconds max_inactivity_time_;
+
+    MatchmakingPolicy matchmaking_policy_;
+
+    std::optional<uint64_t> random_seed_;
 };
 
 }  // namespace model
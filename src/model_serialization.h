@@ -286,10 +286,10 @@ public:
             }
         }
 
-        for (const auto& [token, player] : app.GetPlayerTokens().GetTokenToPlayer()) {
+        app.GetPlayerTokens().GetTokenToPlayer().ForEach([this](const application::Token& token, const auto& player) {
             players_.emplace_back(*player);
-            players_.back().SetToken(*token);
-        }
+            players_.back().SetToken(token.ToHex());
+        });
     }
 
     template <typename Archive>
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+
+namespace http_server {
+
+/**
+ * Пул памяти соединения. Блоки освобождаются и в других потоках (например, в api_strand),
+ * поэтому доступ к пулу защищён мьютексом. std::pmr::synchronized_pool_resource не подходит:
+ * в libstdc++ каждый его экземпляр занимает ключ pthread TSS, а их не больше 1024 на процесс.
+ */
+class ConnectionPool : public std::pmr::memory_resource {
+private:
+    std::mutex mutex_;
+    std::pmr::unsynchronized_pool_resource pool_;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        std::lock_guard lock{mutex_};
+        return pool_.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::lock_guard lock{mutex_};
+        pool_.deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/**
+ * Аллокатор, выделяющий память из пула соединения.
+ * Каждая копия аллокатора владеет пулом, поэтому запросы и ответы могут пережить соединение:
+ * пул будет разрушен вместе с последним объектом, выделившим в нём память.
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(std::shared_ptr<ConnectionPool> pool) noexcept
+    : pool_{std::move(pool)}
+    {
+
+    }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept
+    : pool_{other.GetPool()}
+    {
+
+    }
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(pool_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        pool_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    const std::shared_ptr<ConnectionPool>& GetPool() const noexcept {
+        return pool_;
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept {
+        return pool_ == other.GetPool();
+    }
+
+private:
+    std::shared_ptr<ConnectionPool> pool_;
+};
+
+}  // namespace http_server
@@ -0,0 +1,199 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace profiler {
+
+using namespace std::literals;
+
+namespace detail {
+std::atomic<bool> enabled{false};
+}  // namespace detail
+
+namespace {
+
+struct Slot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> start_ns{0};
+    std::atomic<int64_t> end_ns{0};
+};
+
+// Кольцевой буфер одного потока. Пишет в него только поток-владелец: увеличивает счётчик начатых записей,
+// заполняет ячейку и увеличивает счётчик завершённых записей. Читатель копирует завершённые интервалы,
+// затем по счётчику начатых записей отбрасывает ячейки, которые могли быть перезаписаны во время чтения
+struct ThreadBuffer {
+    ThreadBuffer(uint32_t tid, size_t capacity)
+    : tid{tid}, capacity{capacity}, slots{std::make_unique<Slot[]>(capacity)}
+    {
+
+    }
+
+    uint32_t tid;
+    size_t capacity;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> started{0};
+    std::atomic<uint64_t> written{0};
+};
+
+struct Interval {
+    const char* name;
+    int64_t start_ns;
+    int64_t end_ns;
+};
+
+class Registry {
+public:
+    void SetCapacity(size_t capacity) {
+        std::lock_guard lock{mutex_};
+        capacity_ = std::max<size_t>(capacity, 1);
+        origin_ = Clock::now();
+    }
+
+    // Буферы потоков не освобождаются, чтобы интервалы завершившихся потоков попали в выгрузку
+    ThreadBuffer& Register() {
+        std::lock_guard lock{mutex_};
+        const auto tid = static_cast<uint32_t>(threads_.size() + 1);
+        return *threads_.emplace_back(std::make_unique<ThreadBuffer>(tid, capacity_));
+    }
+
+    Clock::time_point GetOrigin() const {
+        std::lock_guard lock{mutex_};
+        return origin_;
+    }
+
+    // Вызывает fn(tid, intervals) для каждого потока
+    template <typename Fn>
+    void ForEachThread(Fn&& fn) const {
+        std::vector<Interval> intervals;
+        std::lock_guard lock{mutex_};
+        for (const std::unique_ptr<ThreadBuffer>& buffer : threads_) {
+            Copy(*buffer, intervals);
+            fn(buffer->tid, intervals);
+        }
+    }
+
+private:
+    static void Copy(const ThreadBuffer& buffer, std::vector<Interval>& intervals) {
+        intervals.clear();
+        const uint64_t written = buffer.written.load(std::memory_order_acquire);
+        const uint64_t first = written > buffer.capacity ? written - buffer.capacity : 0;
+        intervals.reserve(written - first);
+        for (uint64_t i = first; i < written; ++i) {
+            const Slot& slot = buffer.slots[i % buffer.capacity];
+            intervals.push_back({
+                slot.name.load(std::memory_order_relaxed),
+                slot.start_ns.load(std::memory_order_relaxed),
+                slot.end_ns.load(std::memory_order_relaxed)
+            });
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // Пока шло копирование, поток мог начать записывать новые интервалы поверх самых старых
+        const uint64_t started_after = buffer.started.load(std::memory_order_relaxed);
+        const uint64_t first_intact = started_after > buffer.capacity ? started_after - buffer.capacity : 0;
+        if (first_intact > first) {
+            intervals.erase(intervals.begin(), intervals.begin() + static_cast<std::ptrdiff_t>(std::min(first_intact - first, intervals.size())));
+        }
+    }
+
+    mutable std::mutex mutex_;
+    size_t capacity_ = DEFAULT_CAPACITY;
+    Clock::time_point origin_ = Clock::now();
+    std::vector<std::unique_ptr<ThreadBuffer>> threads_;
+};
+
+Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+ThreadBuffer& GetThreadBuffer() {
+    thread_local ThreadBuffer& buffer = GetRegistry().Register();
+    return buffer;
+}
+
+int64_t ToNanoseconds(Clock::time_point time) noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// Микросекунды с тремя знаками после запятой, без зависимости от настроек потока вывода
+void WriteMicroseconds(std::ostream& os, int64_t ns) {
+    if (ns < 0) {
+        os << '-';
+        ns = -ns;
+    }
+    os << ns / 1000 << '.' << static_cast<char>('0' + ns / 100 % 10)
+       << static_cast<char>('0' + ns / 10 % 10) << static_cast<char>('0' + ns % 10);
+}
+
+}  // namespace
+
+void Enable(size_t capacity) {
+    GetRegistry().SetCapacity(capacity);
+    detail::enabled.store(true, std::memory_order_relaxed);
+}
+
+void Record(const char* name, Clock::time_point start, Clock::time_point end) noexcept {
+    if (!IsEnabled()) {
+        return;
+    }
+    ThreadBuffer& buffer = GetThreadBuffer();
+    const uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    Slot& slot = buffer.slots[index % buffer.capacity];
+    buffer.started.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start_ns.store(ToNanoseconds(start), std::memory_order_relaxed);
+    slot.end_ns.store(ToNanoseconds(end), std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void WriteChromeTrace(std::ostream& os) {
+    const int64_t origin_ns = ToNanoseconds(GetRegistry().GetOrigin());
+    bool first_event = true;
+    auto begin_event = [&os, &first_event] {
+        os << (first_event ? "\n"sv : ",\n"sv);
+        first_event = false;
+    };
+
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":["sv;
+    GetRegistry().ForEachThread([&](uint32_t tid, const std::vector<Interval>& intervals) {
+        begin_event();
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"sv << tid
+           << ",\"args\":{\"name\":\"thread "sv << tid << "\"}}"sv;
+        for (const Interval& interval : intervals) {
+            begin_event();
+            // Имена интервалов - строковые литералы без кавычек и обратных косых черт
+            os << "{\"name\":\""sv << interval.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"sv << tid << ",\"ts\":"sv;
+            WriteMicroseconds(os, interval.start_ns - origin_ns);
+            os << ",\"dur\":"sv;
+            WriteMicroseconds(os, interval.end_ns - interval.start_ns);
+            os << '}';
+        }
+    });
+    os << "\n]}\n"sv;
+}
+
+void SaveChromeTrace(const std::filesystem::path& path) {
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream out{temp_path, std::ios::trunc};
+        if (!out) {
+            throw std::runtime_error("Failed to open trace file "s + temp_path.string());
+        }
+        WriteChromeTrace(out);
+        if (!out.flush()) {
+            throw std::runtime_error("Failed to write trace file "s + temp_path.string());
+        }
+    }
+    std::filesystem::rename(temp_path, path);
+}
+
+}  // namespace profiler
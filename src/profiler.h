@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+
+namespace profiler {
+
+/**
+ * Профилировщик фаз тика и обработчиков API.
+ * Каждый поток записывает интервалы (имя, начало, конец) в собственный кольцевой буфер без блокировок,
+ * при переполнении старые интервалы затираются. По запросу буферы всех потоков выгружаются
+ * в формате Chrome trace event (chrome://tracing, Perfetto).
+ * Пока не вызван Enable(), запись интервала стоит одной проверки флага
+ */
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+namespace detail {
+extern std::atomic<bool> enabled;
+}  // namespace detail
+
+inline bool IsEnabled() noexcept {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+// Включает запись. capacity - сколько последних интервалов хранит каждый поток.
+// Вызывается до запуска рабочих потоков
+void Enable(size_t capacity = DEFAULT_CAPACITY);
+
+// Записывает интервал в буфер текущего потока. name должен жить до конца программы (строковый литерал)
+void Record(const char* name, Clock::time_point start, Clock::time_point end) noexcept;
+
+// Выводит интервалы из буферов всех потоков в формате JSON Chrome trace event.
+// Потоки продолжают запись, интервалы, затёртые во время выгрузки, пропускаются
+void WriteChromeTrace(std::ostream& os);
+
+// Записывает трассировку во временный файл и переименовывает его в path
+void SaveChromeTrace(const std::filesystem::path& path);
+
+// Записывает интервал от создания до разрушения объекта
+class Zone {
+public:
+    explicit Zone(const char* name) noexcept
+    : name_{IsEnabled() ? name : nullptr}
+    {
+        if (name_) {
+            start_ = Clock::now();
+        }
+    }
+
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+
+    ~Zone() {
+        if (name_) {
+            Record(name_, start_, Clock::now());
+        }
+    }
+
+private:
+    const char* name_;
+    Clock::time_point start_;
+};
+
+}  // namespace profiler
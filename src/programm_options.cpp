@@ -15,6 +15,11 @@ namespace programm_options {
         ("help,h", "Usage: ./game_server --tick-period <time-in-ms> --config-file <config-path> --www-root <static-files-dir> --randomize-spawn-points")
         // Опция --tick-period milliseconds задаёт период автоматического обновления игрового состояния в миллисекундах
         ("tick-period,t", po::value(&args.tick_period)->value_name("milliseconds"s), "set tick period")
+        // Опция --tick-catch-up policy задаёт, как тикер догоняет расписание, если отстал на несколько периодов:
+        // skip - пропустить их, merge - передать их суммарное время одним тиком, substeps - выполнить тик для каждого
+        ("tick-catch-up", po::value(&args.tick_catch_up)->value_name("skip|merge|substeps"s), "set how missed tick periods are caught up")
+        // Опция --tick-max-substeps n ограничивает число тиков подряд при --tick-catch-up substeps
+        ("tick-max-substeps", po::value(&args.tick_max_substeps)->value_name("n"s), "set max ticks run at once to catch up")
         // Опция --config-file file задаёт путь к конфигурационному JSON-файлу игры
         ("config-file,c", po::value(&args.config_file)->value_name("file"s), "set config file path")
         // Опция --www-root dir задаёт путь к каталогу со статическими файлами игры
@@ -24,7 +29,38 @@ namespace programm_options {
         // Опция --state-file file задает путь к файлу сохранения состояния сервера
         ("state-file", po::value(&args.state_file)->value_name("file"s), "set state file path")
         // Опция --save-state-period milliseconds задаёт период автоматического сохранения игрового состояния в миллисекундах
-        ("save-state-period", po::value(&args.save_state_period)->value_name("milliseconds"s), "set save state period");
+        ("save-state-period", po::value(&args.save_state_period)->value_name("milliseconds"s), "set save state period")
+        // Опция --io-shards n разделяет ввод-вывод на n однопоточных io_context, у каждого свой acceptor с SO_REUSEPORT.
+        // Состояние игры не шардируется: тики и api_strand выполняются в одном отдельном потоке без acceptor'а
+        ("io-shards", po::value(&args.io_shards)->value_name("n"s), "run n single-threaded io shards with SO_REUSEPORT listeners")
+        // Опция --request-body-limit bytes ограничивает размер тела HTTP-запроса, при превышении клиент получает 413
+        ("request-body-limit", po::value(&args.request_body_limit)->value_name("bytes"s), "set max HTTP request body size")
+        // Опция --max-connections n ограничивает число одновременных соединений, лишние закрываются сразу после accept
+        ("max-connections", po::value(&args.max_connections)->value_name("n"s), "set max simultaneous connections (0 - unlimited)")
+        // Опция --max-api-queue n задаёт длину очереди api_strand, при превышении которой API отвечает 503
+        ("max-api-queue", po::value(&args.max_api_queue)->value_name("n"s), "set max queued API tasks before shedding load with 503")
+        // Опция --max-tick-duration milliseconds задаёт сглаженную длительность тика, при превышении которой
+        // запросы к api_strand получают 503. По умолчанию - два периода тика
+        ("max-tick-duration", po::value(&args.max_tick_duration)->value_name("milliseconds"s), "set smoothed tick duration before shedding load with 503")
+        // Опция --metrics включает сбор метрик и их экспорт в формате Prometheus по запросу GET /metrics
+        ("metrics", po::bool_switch(&args.metrics), "collect metrics and export them at /metrics in Prometheus format")
+        // Опция --random-seed n задаёт зерно генераторов случайных чисел: при одинаковых входных событиях
+        // игра приходит в одинаковое состояние
+        ("random-seed", po::value<uint64_t>()->value_name("n"s), "make the simulation deterministic with this seed")
+        // Опция --fixed-time-step milliseconds моделирует игру шагами одинаковой длины независимо от длительности тиков
+        ("fixed-time-step", po::value(&args.fixed_time_step)->value_name("milliseconds"s), "simulate the game in steps of fixed length")
+        // Опция --record-replay file записывает присоединения, команды и тики в журнал для game_server_replay
+        ("record-replay", po::value(&args.record_replay)->value_name("file"s), "record game inputs for game_server_replay")
+        // Опция --records-storage postgres|memory задаёт, где хранятся рекорды выбывших игроков. В памяти рекорды
+        // теряются при перезапуске, если не задан --records-file
+        ("records-storage", po::value(&args.records_storage)->value_name("postgres|memory"s), "set where records of retired players are stored")
+        // Опция --records-file file загружает рекорды из файла при запуске и дописывает в него новые
+        ("records-file", po::value(&args.records_file)->value_name("file"s), "append records kept in memory to this file")
+        // Опция --profile-file file включает профилировщик фаз тика и обработчиков API. Трассировка в формате
+        // Chrome trace event сохраняется в файл по сигналу SIGUSR1 и при завершении сервера
+        ("profile-file", po::value(&args.profile_file)->value_name("file"s), "enable profiler and save Chrome trace to file on SIGUSR1 and exit")
+        // Опция --profile-buffer n задаёт, сколько последних интервалов профилировщик хранит для каждого потока
+        ("profile-buffer", po::value(&args.profile_buffer)->value_name("n"s), "set number of profiler intervals kept per thread");
 
     // variables_map хранит значения опций после разбора
     po::variables_map vm;
@@ -45,6 +81,22 @@ namespace programm_options {
         throw std::runtime_error("Static files root has not been specified"s);
     }
 
+    if (vm.contains("random-seed"s)) {
+        args.random_seed = vm["random-seed"s].as<uint64_t>();
+    }
+    if (args.fixed_time_step < 0) {
+        throw std::runtime_error("Fixed time step must not be negative"s);
+    }
+    if (args.max_tick_duration < 0) {
+        throw std::runtime_error("Max tick duration must not be negative"s);
+    }
+    if (args.profile_buffer == 0) {
+        throw std::runtime_error("Profiler buffer must not be empty"s);
+    }
+    if (!args.records_file.empty() && args.records_storage != "memory"s) {
+        throw std::runtime_error("Records file can only be used with --records-storage memory"s);
+    }
+
     // С опциями программы всё в порядке, возвращаем структуру args
     return args;
 }
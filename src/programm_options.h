@@ -11,11 +11,42 @@ using namespace std::literals;
 
 struct Args {
     int64_t tick_period{0};
+    // Поведение тикера при отставании от расписания: skip, merge или substeps
+    std::string tick_catch_up{"merge"};
+    // Максимум шагов подряд для tick_catch_up = substeps
+    unsigned tick_max_substeps{5};
     std::string config_file;
     std::string www_root;
     bool randomize_spawn_points{false};
     std::string state_file;
     int64_t save_state_period{0};
+    // Количество шардов ввода-вывода, 0 - общий io_context для всех потоков.
+    // Шардируется только ввод-вывод, состояние игры остаётся общим
+    unsigned io_shards{0};
+    // Максимальный размер тела HTTP-запроса в байтах
+    uint64_t request_body_limit{64 * 1024};
+    // Максимальное число одновременных соединений, 0 - без ограничения
+    size_t max_connections{10000};
+    // Максимальная очередь запросов к api_strand, после которой API отвечает 503
+    size_t max_api_queue{1024};
+    // Сглаженная длительность тика в миллисекундах, после которой API отвечает 503, 0 - два периода тика
+    int64_t max_tick_duration{0};
+    // Сбор метрик и их экспорт по запросу /metrics
+    bool metrics{false};
+    // Зерно генераторов случайных чисел модели, включает детерминированное моделирование
+    std::optional<uint64_t> random_seed;
+    // Длительность шага моделирования в миллисекундах, 0 - шаг равен тику
+    int64_t fixed_time_step{0};
+    // Файл журнала для воспроизведения игры утилитой game_server_replay
+    std::string record_replay;
+    // Хранилище рекордов выбывших игроков: postgres или memory
+    std::string records_storage{"postgres"};
+    // Файл, в который дописываются рекорды при хранении в памяти
+    std::string records_file;
+    // Файл трассировки профилировщика, сохраняется по сигналу SIGUSR1 и при завершении
+    std::string profile_file;
+    // Сколько последних интервалов профилировщик хранит для каждого потока
+    size_t profile_buffer{64 * 1024};
 };
 
 
@@ -0,0 +1,194 @@
+#include "replay_log.h"
+
+#include <stdexcept>
+#include <string_view>
+
+namespace replay {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr std::string_view MAGIC = "GSREPLAY"sv;
+constexpr char FORMAT_VERSION = 1;
+// Размер буфера, после заполнения которого данные сбрасываются в файл
+constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+// Максимальная длина строки в журнале, защищает от чтения повреждённого файла
+constexpr uint64_t MAX_STRING_SIZE = 4096;
+
+enum class EventType : char {
+    JOIN = 'J',
+    MOVE = 'M',
+    TICK = 'T',
+    STATE_HASH = 'H'
+};
+
+}  // namespace
+
+ReplayWriter::ReplayWriter(const std::filesystem::path& path, const Header& header, uint64_t state_hash_period)
+    : out_{path, std::ios::binary | std::ios::trunc}
+    , state_hash_period_{state_hash_period} {
+    if (!out_) {
+        throw std::runtime_error("Failed to open replay file "s + path.string());
+    }
+    buffer_.reserve(FLUSH_THRESHOLD + MAX_STRING_SIZE);
+    buffer_.insert(buffer_.end(), MAGIC.begin(), MAGIC.end());
+    buffer_.push_back(FORMAT_VERSION);
+    for (int i = 0; i < 8; ++i) {
+        buffer_.push_back(static_cast<char>(header.random_seed >> (8 * i)));
+    }
+    WriteVarint(header.fixed_time_step.count());
+    buffer_.push_back(header.randomize_spawn_points ? 1 : 0);
+    Flush();
+}
+
+ReplayWriter::~ReplayWriter() {
+    try {
+        Flush();
+    } catch (...) {
+    }
+}
+
+void ReplayWriter::RecordJoin(uint64_t player_id, std::string_view player_name, std::string_view map_id) {
+    buffer_.push_back(static_cast<char>(EventType::JOIN));
+    WriteVarint(player_id);
+    WriteString(player_name);
+    WriteString(map_id);
+    FlushIfFull();
+}
+
+void ReplayWriter::RecordMove(uint64_t player_id, std::string_view direction) {
+    buffer_.push_back(static_cast<char>(EventType::MOVE));
+    WriteVarint(player_id);
+    WriteString(direction);
+    FlushIfFull();
+}
+
+void ReplayWriter::RecordTick(std::chrono::milliseconds time_delta) {
+    buffer_.push_back(static_cast<char>(EventType::TICK));
+    WriteVarint(time_delta.count());
+    ++ticks_;
+    FlushIfFull();
+}
+
+void ReplayWriter::RecordStateHash(uint64_t hash) {
+    buffer_.push_back(static_cast<char>(EventType::STATE_HASH));
+    WriteVarint(hash);
+    FlushIfFull();
+}
+
+void ReplayWriter::Flush() {
+    if (buffer_.empty()) {
+        return;
+    }
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    out_.flush();
+    buffer_.clear();
+    if (!out_) {
+        throw std::runtime_error("Failed to write replay file"s);
+    }
+}
+
+void ReplayWriter::WriteVarint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer_.push_back(static_cast<char>(value));
+}
+
+void ReplayWriter::WriteString(std::string_view value) {
+    value = value.substr(0, MAX_STRING_SIZE);
+    WriteVarint(value.size());
+    buffer_.insert(buffer_.end(), value.begin(), value.end());
+}
+
+void ReplayWriter::FlushIfFull() {
+    if (buffer_.size() >= FLUSH_THRESHOLD) {
+        Flush();
+    }
+}
+
+ReplayReader::ReplayReader(const std::filesystem::path& path)
+    : in_{path, std::ios::binary} {
+    if (!in_) {
+        throw std::runtime_error("Failed to open replay file "s + path.string());
+    }
+    std::string magic(MAGIC.size(), '\0');
+    char version = 0;
+    if (!in_.read(magic.data(), magic.size()) || magic != MAGIC || !in_.get(version)) {
+        throw std::runtime_error("Not a replay file: "s + path.string());
+    }
+    if (version != FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported replay format version "s + std::to_string(version));
+    }
+    unsigned char seed_bytes[8];
+    if (!in_.read(reinterpret_cast<char*>(seed_bytes), sizeof(seed_bytes))) {
+        throw std::runtime_error("Truncated replay header"s);
+    }
+    for (int i = 0; i < 8; ++i) {
+        header_.random_seed |= static_cast<uint64_t>(seed_bytes[i]) << (8 * i);
+    }
+    header_.fixed_time_step = std::chrono::milliseconds(ReadVarint());
+    char randomize = 0;
+    if (!in_.get(randomize)) {
+        throw std::runtime_error("Truncated replay header"s);
+    }
+    header_.randomize_spawn_points = randomize != 0;
+}
+
+std::optional<Event> ReplayReader::Next() {
+    char type = 0;
+    if (!in_.get(type)) {
+        return std::nullopt;
+    }
+    switch (static_cast<EventType>(type)) {
+        case EventType::JOIN: {
+            JoinEvent event;
+            event.player_id = ReadVarint();
+            event.player_name = ReadString();
+            event.map_id = ReadString();
+            return event;
+        }
+        case EventType::MOVE: {
+            MoveEvent event;
+            event.player_id = ReadVarint();
+            event.direction = ReadString();
+            return event;
+        }
+        case EventType::TICK:
+            return TickEvent{std::chrono::milliseconds(ReadVarint())};
+        case EventType::STATE_HASH:
+            return StateHashEvent{ReadVarint()};
+    }
+    throw std::runtime_error("Unknown replay event type "s + std::to_string(static_cast<int>(type)));
+}
+
+uint64_t ReplayReader::ReadVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        char byte = 0;
+        if (!in_.get(byte)) {
+            throw std::runtime_error("Truncated replay event"s);
+        }
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Malformed varint in replay file"s);
+}
+
+std::string ReplayReader::ReadString() {
+    const uint64_t size = ReadVarint();
+    if (size > MAX_STRING_SIZE) {
+        throw std::runtime_error("Replay string is too long"s);
+    }
+    std::string value(size, '\0');
+    if (!in_.read(value.data(), static_cast<std::streamsize>(size))) {
+        throw std::runtime_error("Truncated replay event"s);
+    }
+    return value;
+}
+
+}  // namespace replay
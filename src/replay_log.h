@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace replay {
+
+/**
+ * Журнал входных событий игры для воспроизведения в детерминированном режиме.
+ * Формат: заголовок с параметрами моделирования, затем записи из байта типа и полей
+ * в виде целых переменной длины (LEB128). Команды движения записываются в момент применения
+ * перед тиком, в котором они применены, поэтому воспроизведение повторяет их порядок точно
+ */
+
+// Параметры, от которых зависит результат моделирования, кроме файла конфигурации
+struct Header {
+    uint64_t random_seed = 0;
+    std::chrono::milliseconds fixed_time_step{0};
+    bool randomize_spawn_points = false;
+};
+
+struct JoinEvent {
+    uint64_t player_id = 0;
+    std::string player_name;
+    std::string map_id;
+};
+
+struct MoveEvent {
+    uint64_t player_id = 0;
+    std::string direction;
+};
+
+struct TickEvent {
+    std::chrono::milliseconds time_delta{0};
+};
+
+// Контрольная сумма состояния игры после предыдущего тика
+struct StateHashEvent {
+    uint64_t hash = 0;
+};
+
+using Event = std::variant<JoinEvent, MoveEvent, TickEvent, StateHashEvent>;
+
+class ReplayWriter {
+public:
+    // Создаёт файл журнала и записывает заголовок. state_hash_period - через сколько тиков
+    // записывается контрольная сумма состояния, 0 - не записывается
+    ReplayWriter(const std::filesystem::path& path, const Header& header, uint64_t state_hash_period = 100);
+
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+    ~ReplayWriter();
+
+    // Методы записи вызываются из api_strand
+    void RecordJoin(uint64_t player_id, std::string_view player_name, std::string_view map_id);
+    void RecordMove(uint64_t player_id, std::string_view direction);
+    void RecordTick(std::chrono::milliseconds time_delta);
+    void RecordStateHash(uint64_t hash);
+
+    // Пора ли записать контрольную сумму после последнего тика
+    bool IsStateHashDue() const noexcept {
+        return state_hash_period_ && ticks_ % state_hash_period_ == 0;
+    }
+
+    void Flush();
+
+private:
+    void WriteVarint(uint64_t value);
+    void WriteString(std::string_view value);
+    void FlushIfFull();
+
+    std::ofstream out_;
+    std::vector<char> buffer_;
+    uint64_t state_hash_period_;
+    uint64_t ticks_ = 0;
+};
+
+class ReplayReader {
+public:
+    // Открывает журнал и читает заголовок, при ошибке формата выбрасывает исключение
+    explicit ReplayReader(const std::filesystem::path& path);
+
+    const Header& GetHeader() const noexcept {
+        return header_;
+    }
+
+    // Следующее событие или nullopt в конце журнала
+    std::optional<Event> Next();
+
+private:
+    uint64_t ReadVarint();
+    std::string ReadString();
+
+    std::ifstream in_;
+    Header header_;
+};
+
+}  // namespace replay
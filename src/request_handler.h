@@ -9,6 +9,7 @@
 #include "response_utils.h"
 #include "file_request_handler.h"
 #include "api_request_handler.h"
+#include "metrics.h"
 
 #include <algorithm>
 #include <iostream> //DELETE ME
@@ -30,13 +31,35 @@ public:
 
     template <typename Body, typename Allocator, typename Send>
     void operator()(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
+        if (!metrics::IsEnabled()) {
+            Dispatch(std::move(req), std::forward<Send>(send));
+            return;
+        }
+
+        // Время ответа считается от разбора запроса до передачи ответа соединению,
+        // в том числе ожидание в очереди api_strand
+        const metrics::Histogram route = GetRouteHistogram(req.target());
+        Dispatch(std::move(req), [send = std::forward<Send>(send), route, start = std::chrono::steady_clock::now()](auto&& response) mutable {
+            metrics::Observe(route, std::chrono::steady_clock::now() - start);
+            send(std::forward<decltype(response)>(response));
+        });
+    }
+
+private:
+    std::shared_ptr<ApiRequestHandler> api_handler_;
+    FileRequestHandler file_handler_;
+
+    template <typename Body, typename Allocator, typename Send>
+    void Dispatch(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
         auto http_version = req.version();
         auto keep_alive = req.keep_alive();
-        std::string path = std::string(req.target());
-        std::string prefix_for_api = "/api/"s;
+        const bool is_api_request = req.target().starts_with("/api/"sv);
 
         try {
-            if (path.starts_with(prefix_for_api)) {
+            if (metrics::IsEnabled() && IsMetricsTarget(req.target())) {
+                // экспорт метрик, доступен только при включённом сборе
+                api_handler_->HandleMetricsRequest(std::move(req), std::forward<Send>(send));
+            } else if (is_api_request) {
                 // запрос к API
                 api_handler_->HandleRequest(std::move(req), std::forward<Send>(send));
             } else {
@@ -49,9 +72,44 @@ public:
         }
     }
 
-private:
-    std::shared_ptr<ApiRequestHandler> api_handler_;
-    FileRequestHandler file_handler_;
+    static bool IsMetricsTarget(std::string_view target) {
+        return target == "/metrics"sv || target.starts_with("/metrics?"sv);
+    }
+
+    // Гистограмма времени ответа для маршрута. Сопоставление по префиксу без регулярных выражений,
+    // неизвестные пути API учитываются вместе
+    static metrics::Histogram GetRouteHistogram(std::string_view target) {
+        using metrics::Histogram;
+        constexpr std::string_view maps_prefix = "/api/v1/maps"sv;
+        constexpr std::string_view game_prefix = "/api/v1/game/"sv;
+
+        if (!target.starts_with("/api/"sv)) {
+            return IsMetricsTarget(target) ? Histogram::REQUEST_METRICS : Histogram::REQUEST_STATIC;
+        }
+        if (target.starts_with(maps_prefix)) {
+            const std::string_view rest = target.substr(maps_prefix.size());
+            return rest.empty() || rest == "/"sv ? Histogram::REQUEST_MAPS : Histogram::REQUEST_MAP;
+        }
+        if (!target.starts_with(game_prefix)) {
+            return Histogram::REQUEST_OTHER_API;
+        }
+
+        const std::string_view endpoint = target.substr(game_prefix.size());
+        if (endpoint.starts_with("join"sv)) {
+            return Histogram::REQUEST_JOIN;
+        } else if (endpoint.starts_with("players"sv)) {
+            return Histogram::REQUEST_PLAYERS;
+        } else if (endpoint.starts_with("state"sv)) {
+            return Histogram::REQUEST_STATE;
+        } else if (endpoint.starts_with("player/action"sv)) {
+            return Histogram::REQUEST_ACTION;
+        } else if (endpoint.starts_with("tick"sv)) {
+            return Histogram::REQUEST_TICK;
+        } else if (endpoint.starts_with("records"sv)) {
+            return Histogram::REQUEST_RECORDS;
+        }
+        return Histogram::REQUEST_OTHER_API;
+    }
 };
 
 }  // namespace http_handler
@@ -1,7 +1,55 @@
 #include "response_utils.h"
 
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
 namespace http_handler {
 
+void SendfileBody::value_type::Open(const char* path, beast::error_code& ec) {
+    file_.open(path, beast::file_mode::read, ec);
+    if (ec) {
+        return;
+    }
+    struct stat file_stat{};
+    if (fstat(file_.native_handle(), &file_stat) != 0) {
+        ec.assign(errno, boost::system::system_category());
+        return;
+    }
+    if (!S_ISREG(file_stat.st_mode)) {
+        // Каталоги и специальные файлы не отдаём
+        ec = boost::system::errc::make_error_code(boost::system::errc::no_such_file_or_directory);
+        return;
+    }
+    file_size_ = static_cast<std::uint64_t>(file_stat.st_size);
+    modification_time_ = static_cast<std::int64_t>(file_stat.st_mtim.tv_sec) * 1'000'000'000 + file_stat.st_mtim.tv_nsec;
+    offset_ = 0;
+    size_ = file_size_;
+}
+
+boost::optional<std::pair<SendfileBody::writer::const_buffers_type, bool>> SendfileBody::writer::get(beast::error_code& ec) {
+    ec = {};
+    if (remaining_ == 0) {
+        return boost::none;
+    }
+    if (!buffer_) {
+        buffer_ = std::make_unique<char[]>(BUFFER_SIZE);
+    }
+    const size_t to_read = static_cast<size_t>(std::min<std::uint64_t>(remaining_, BUFFER_SIZE));
+    const ssize_t bytes_read = pread(body_.GetNativeHandle(), buffer_.get(), to_read, static_cast<off_t>(position_));
+    if (bytes_read <= 0) {
+        // Файл укоротили после того, как заголовки с его длиной уже отправлены
+        ec = bytes_read == 0 ? beast::error_code{http::error::short_read}
+                             : beast::error_code{errno, boost::system::system_category()};
+        return boost::none;
+    }
+    position_ += static_cast<std::uint64_t>(bytes_read);
+    remaining_ -= static_cast<std::uint64_t>(bytes_read);
+    return std::make_pair(const_buffers_type{buffer_.get(), static_cast<size_t>(bytes_read)}, remaining_ > 0);
+}
+
 StringResponse MakeStringResponse(
     http::status status,
     std::string_view body,
@@ -18,7 +66,7 @@ StringResponse MakeStringResponse(
 
 FileResponse MakeFileResponse(
     http::status status,
-    http::file_body::value_type body,
+    SendfileBody::value_type body,
     unsigned http_version,
     bool keep_alive,
     std::string_view content_type) {
@@ -40,4 +88,17 @@ StringResponse ReportServerError(unsigned http_version, bool keep_alive) {
     );
 }
 
+StringResponse ReportServiceUnavailable(unsigned http_version, bool keep_alive) {
+    StringResponse response = MakeStringResponse(
+        http::status::service_unavailable,
+        R"({"code": "serviceUnavailable", "message": "Server is overloaded, try again later"})"sv,
+        http_version,
+        keep_alive,
+        ContentType::APPLICATION_JSON
+    );
+    response.set(http::field::retry_after, "1"sv);
+    response.set(http::field::cache_control, "no-cache"sv);
+    return response;
+}
+
 }  // namespace http_handler
\ No newline at end of file
@@ -4,7 +4,10 @@
 #define BOOST_BEAST_USE_STD_STRING_VIEW
 
 #include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
 
+#include <memory>
+#include <string>
 #include <string_view>
 
 namespace http_handler {
@@ -14,10 +17,137 @@ using namespace std::literals;
 namespace beast = boost::beast;
 namespace http = beast::http;
 
-// Ответ, тело которого представлено в виде строки
+// Ответ, тело которого представлено в виде строки.
+// Заголовки и тело используют стандартный аллокатор, а не пул соединения: ответы создают обработчики,
+// которые соединения не знают (api_strand, бенчмарки, тесты), и передавать им аллокатор пришлось бы
+// через каждый метод ApiRequestHandler. В пул соединения попадает сам объект ответа (SessionBase::Write),
+// тело при этом перемещается, а не копируется
 using StringResponse = http::response<http::string_body>;
+// Тело ответа - участок файла на диске. На Linux сессия передаёт его в сокет через sendfile,
+// минуя буферы пространства пользователя; writer нужен только там, где sendfile недоступен
+struct SendfileBody {
+    class value_type {
+    public:
+        // Открывает файл на чтение, по умолчанию телом будет весь файл
+        void Open(const char* path, beast::error_code& ec);
+
+        // Ограничивает тело участком [offset, offset + size) для Range-запросов
+        void SetRange(std::uint64_t offset, std::uint64_t size) noexcept {
+            offset_ = offset;
+            size_ = size;
+        }
+
+        int GetNativeHandle() const noexcept {
+            return file_.native_handle();
+        }
+
+        std::uint64_t GetOffset() const noexcept {
+            return offset_;
+        }
+
+        std::uint64_t GetSize() const noexcept {
+            return size_;
+        }
+
+        std::uint64_t GetFileSize() const noexcept {
+            return file_size_;
+        }
+
+        // Время изменения файла в наносекундах, используется для ETag
+        std::int64_t GetModificationTime() const noexcept {
+            return modification_time_;
+        }
+
+    private:
+        beast::file file_;
+        std::uint64_t file_size_ = 0;
+        std::int64_t modification_time_ = 0;
+        std::uint64_t offset_ = 0;
+        std::uint64_t size_ = 0;
+    };
+
+    static std::uint64_t size(const value_type& body) {
+        return body.GetSize();
+    }
+
+    class writer {
+    public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template <bool isRequest, class Fields>
+        writer(const http::header<isRequest, Fields>&, const value_type& body)
+        : body_{body}, position_{body.GetOffset()}, remaining_{body.GetSize()}
+        {
+
+        }
+
+        void init(beast::error_code& ec) {
+            ec = {};
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec);
+
+    private:
+        constexpr static std::size_t BUFFER_SIZE = 64 * 1024;
+
+        const value_type& body_;
+        std::uint64_t position_;
+        std::uint64_t remaining_;
+        std::unique_ptr<char[]> buffer_;
+    };
+};
+
 // Ответ в виде фалйа
-using FileResponse = http::response<http::file_body>;
+using FileResponse = http::response<SendfileBody>;
+
+// Тело ответа, разделяющее неизменяемый буфер с кешем: содержимое не копируется в каждый ответ
+struct SharedBufferBody {
+    struct value_type {
+        std::shared_ptr<const std::string> buffer;
+        // Отдаваемая часть буфера, по умолчанию весь буфер (Range-запросы отдают его участок)
+        std::size_t offset = 0;
+        std::size_t length = std::string::npos;
+
+        std::string_view GetView() const {
+            return buffer ? std::string_view{*buffer}.substr(offset, length) : std::string_view{};
+        }
+    };
+
+    static std::uint64_t size(const value_type& body) {
+        return body.GetView().size();
+    }
+
+    class writer {
+    public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template <bool isRequest, class Fields>
+        writer(const http::header<isRequest, Fields>&, const value_type& body)
+        : body_{body}
+        {
+
+        }
+
+        void init(beast::error_code& ec) {
+            ec = {};
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec) {
+            ec = {};
+            const std::string_view view = body_.GetView();
+            if (view.empty()) {
+                return boost::none;
+            }
+            return std::make_pair(const_buffers_type{view.data(), view.size()}, false);
+        }
+
+    private:
+        const value_type& body_;
+    };
+};
+
+// Ответ с содержимым из кеша статических файлов
+using CachedFileResponse = http::response<SharedBufferBody>;
 
 struct ContentType {
     ContentType() = delete;
@@ -27,6 +157,8 @@ struct ContentType {
     constexpr static std::string_view TEXT_CSS = "text/css"sv;
     constexpr static std::string_view TEXT_PLAIN = "text/plain"sv;
     constexpr static std::string_view TEXT_JAVASCRIPT = "text/javascript"sv;
+    // Текстовый формат экспорта метрик Prometheus
+    constexpr static std::string_view TEXT_PROMETHEUS = "text/plain; version=0.0.4"sv;
     constexpr static std::string_view APPLICATION_JSON = "application/json"sv;
     constexpr static std::string_view APPLICATION_XML = "application/xml"sv;
     constexpr static std::string_view IMAGE_PNG = "image/png"sv;
@@ -51,7 +183,7 @@ StringResponse MakeStringResponse(
 // Создаёт FileResponse с заданными параметрами
 FileResponse MakeFileResponse(
     http::status status,
-    http::file_body::value_type body,
+    SendfileBody::value_type body,
     unsigned http_version,
     bool keep_alive,
     std::string_view content_type = ContentType::TEXT_JAVASCRIPT);
@@ -59,4 +191,7 @@ FileResponse MakeFileResponse(
 // В случае непредвиденной ошибки с обработкой запроса, возвращается 500 - internal server error
 StringResponse ReportServerError(unsigned http_version, bool keep_alive);
 
+// Когда сервер перегружен, запрос отклоняется сразу - 503 service unavailable
+StringResponse ReportServiceUnavailable(unsigned http_version, bool keep_alive);
+
 }  // namespace http_handler
\ No newline at end of file
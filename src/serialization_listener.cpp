@@ -1,5 +1,7 @@
 #include "serialization_listener.h"
 #include "logger.h"
+#include "metrics.h"
+#include "profiler.h"
 
 namespace serialization {
 
@@ -48,11 +50,11 @@ GameStateRepr SerializingListener::CaptureState() const {
     }
 
     // Сохраняем данные игроков и их токены
-    for (const auto& [token, player] : app_.GetPlayerTokens().GetTokenToPlayer()) {
+    app_.GetPlayerTokens().GetTokenToPlayer().ForEach([&game_state_repr](const application::Token& token, const auto& player) {
         PlayerRepr player_repr{*player};
-        player_repr.SetToken(*token);
+        player_repr.SetToken(token.ToHex());
         game_state_repr.AddPlayer(player_repr);
-    }
+    });
 
     return game_state_repr;
 }
@@ -89,7 +91,8 @@ void SerializingListener::ApplyState(const GameStateRepr& game_state_repr) {
         std::shared_ptr<model::GameSession> session = std::make_shared<model::GameSession>(
             session_repr.GetId(),
             map,
-            std::make_shared<extra_data::LootTypes>(app_.GetLootTypes())
+            app_.GetSharedLootTypes(),
+            app_.GetRandomSeed()
         );
 
         // Добавляем собак в сессию
@@ -129,10 +132,13 @@ void SerializingListener::ApplyState(const GameStateRepr& game_state_repr) {
         app_.AddPlayer(player);
 
         // Восстанавливаем токен
-        if (!player_repr.GetToken().empty()) {
-            app_.SetPlayerToken(application::Token{player_repr.GetToken()}, player);
+        if (auto token = application::Token::FromHex(player_repr.GetToken())) {
+            app_.SetPlayerToken(*token, player);
         }
     }
+
+    // Делаем восстановленное состояние видимым для GET-запросов
+    app_.PublishSessionSnapshots();
 }
 
 bool SerializingListener::TryLoadState() {
@@ -163,6 +169,8 @@ void SerializingListener::SaveState() {
         return;
     }
 
+    metrics::ScopedTimer timer{metrics::Histogram::STATE_SAVE};
+    profiler::Zone zone{"state.save"};
     try {
         // Сначала сохраняем во временный файл
         auto temp_file = state_file_;
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "model.h"
+
+namespace application {
+
+// Неизменяемый снимок состояния игровой сессии.
+// Собирается в api_strand в конце тика и читается GET-запросами из любых потоков
+struct SessionSnapshot {
+    struct BagItem {
+        size_t id;
+        size_t type;
+    };
+
+    struct DogState {
+        size_t player_id;
+        std::string player_name;
+        model::Position position;
+        model::Speed speed;
+        std::string direction;
+        std::vector<BagItem> bag;
+        int score;
+    };
+
+    struct LostObjectState {
+        size_t id;
+        size_t type;
+        model::Position position;
+    };
+
+    std::vector<DogState> dogs;
+    std::vector<LostObjectState> lost_objects;
+};
+
+// Опубликованный снимок сессии. Писатель подменяет указатель целиком,
+// читатель получает копию shared_ptr и работает со снимком без блокировок,
+// старый снимок живёт, пока его используют читатели
+class PublishedSessionSnapshot {
+public:
+    PublishedSessionSnapshot()
+    : snapshot_{std::make_shared<const SessionSnapshot>()}
+    {
+
+    }
+
+    std::shared_ptr<const SessionSnapshot> Load() const {
+        std::lock_guard lock{mutex_};
+        return snapshot_;
+    }
+
+    void Publish(std::shared_ptr<const SessionSnapshot> snapshot) {
+        std::lock_guard lock{mutex_};
+        snapshot_.swap(snapshot);
+        // Старый снимок освобождается вне блокировки, при выходе из функции
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<const SessionSnapshot> snapshot_;
+};
+
+}  // namespace application
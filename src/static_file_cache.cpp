@@ -0,0 +1,387 @@
+#include "static_file_cache.h"
+#include "logger.h"
+
+#include <brotli/encode.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <latch>
+#include <optional>
+#include <sstream>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace http_handler {
+
+using namespace std::literals;
+using namespace logger;
+
+namespace {
+
+// Сжимать имеет смысл только текстовые форматы, изображения и модели уже сжаты
+bool IsCompressible(const fs::path& path) {
+    static const std::unordered_set<std::string> compressible_extensions{
+        ".htm", ".html", ".css", ".txt", ".js", ".json", ".xml", ".svg", ".map"
+    };
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return compressible_extensions.contains(extension);
+}
+
+std::shared_ptr<const std::string> CompressGzip(const std::string& data) {
+    z_stream stream{};
+    // 15 + 16: максимальное окно и заголовок gzip вместо zlib
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nullptr;
+    }
+    std::string result(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(result.data());
+    stream.avail_out = static_cast<uInt>(result.size());
+    const int status = deflate(&stream, Z_FINISH);
+    result.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        return nullptr;
+    }
+    return std::make_shared<const std::string>(std::move(result));
+}
+
+// Качество 11 сжимает three.js несколько секунд, 9 даёт почти тот же размер заметно быстрее
+constexpr int BROTLI_QUALITY = 9;
+
+std::shared_ptr<const std::string> CompressBrotli(const std::string& data) {
+    size_t encoded_size = BrotliEncoderMaxCompressedSize(data.size());
+    if (encoded_size == 0) {
+        return nullptr;
+    }
+    std::string result(encoded_size, '\0');
+    if (!BrotliEncoderCompress(
+            BROTLI_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+            data.size(), reinterpret_cast<const uint8_t*>(data.data()),
+            &encoded_size, reinterpret_cast<uint8_t*>(result.data()))) {
+        return nullptr;
+    }
+    result.resize(encoded_size);
+    return std::make_shared<const std::string>(std::move(result));
+}
+
+// Сжатый вариант нужен, только если он действительно меньше исходного
+std::shared_ptr<const std::string> KeepIfSmaller(std::shared_ptr<const std::string> compressed, const std::string& data) {
+    return compressed && compressed->size() < data.size() ? std::move(compressed) : nullptr;
+}
+
+// Строгий ETag: 64-битный FNV-1a от содержимого и его размер
+std::string MakeETag(const std::string& data) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    std::ostringstream etag;
+    etag << '"' << std::hex << hash << '-' << data.size() << '"';
+    return etag.str();
+}
+
+std::string_view Trim(std::string_view str) {
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+// Вызывает fn для каждого элемента списка, разделённого запятыми
+template <typename Fn>
+bool AnyListItem(std::string_view list, Fn&& fn) {
+    while (!list.empty()) {
+        const size_t comma = list.find(',');
+        if (fn(Trim(list.substr(0, comma)))) {
+            return true;
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](unsigned char l, unsigned char r) {
+        return std::tolower(l) == std::tolower(r);
+    });
+}
+
+// "q=0" (а также "q=0.0", "Q=0.000") означает явный запрет кодирования
+bool IsNonZeroQuality(std::string_view params) {
+    params = Trim(params);
+    if (params.size() < 2 || std::tolower(static_cast<unsigned char>(params[0])) != 'q' || params[1] != '=') {
+        return true;
+    }
+    params.remove_prefix(2);
+    return params.find_first_not_of("0."sv) != std::string_view::npos;
+}
+
+}  // namespace
+
+bool AcceptsEncoding(std::string_view accept_encoding, std::string_view coding) {
+    // Явно названная кодировка важнее "*": "gzip;q=0, *" запрещает gzip
+    std::optional<bool> accepts_coding;
+    bool accepts_any = false;
+    AnyListItem(accept_encoding, [coding, &accepts_coding, &accepts_any](std::string_view item) {
+        const size_t semicolon = item.find(';');
+        const std::string_view name = Trim(item.substr(0, semicolon));
+        const bool accepted = semicolon == std::string_view::npos || IsNonZeroQuality(item.substr(semicolon + 1));
+        if (EqualsIgnoreCase(name, coding)) {
+            accepts_coding = accepted;
+            return true;
+        }
+        if (name == "*"sv) {
+            accepts_any = accepted;
+        }
+        return false;
+    });
+    return accepts_coding.value_or(accepts_any);
+}
+
+bool MatchesIfNoneMatch(std::string_view if_none_match, std::string_view etag) {
+    return AnyListItem(if_none_match, [etag](std::string_view item) {
+        // Для If-None-Match используется слабое сравнение
+        if (item.starts_with("W/"sv)) {
+            item.remove_prefix(2);
+        }
+        return item == "*"sv || item == etag;
+    });
+}
+
+StaticFileCache::StaticFileCache(fs::path root)
+: root_{fs::weakly_canonical(root)}
+{
+
+}
+
+StaticFileCache::~StaticFileCache() {
+    if (watcher_.joinable()) {
+        watcher_.request_stop();
+        watcher_.join();
+    }
+}
+
+void StaticFileCache::Build() {
+    LoadDirectory(root_);
+    LOG_WITH_DATA(info, (json::object{{"files", Size()}}), "static files cached"sv);
+}
+
+std::shared_ptr<const StaticFileCache::Entry> StaticFileCache::Find(const std::string& relative_path) const {
+    std::shared_lock lock{mutex_};
+    if (auto it = entries_.find(relative_path); it != entries_.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+size_t StaticFileCache::Size() const {
+    std::shared_lock lock{mutex_};
+    return entries_.size();
+}
+
+std::string StaticFileCache::MakeKey(const fs::path& path) const {
+    return path.lexically_relative(root_).generic_string();
+}
+
+void StaticFileCache::LoadDirectory(const fs::path& dir) {
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it{dir, ec}, end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec)) {
+            LoadFile(it->path());
+        }
+    }
+}
+
+void StaticFileCache::LoadFile(const fs::path& path) {
+    std::error_code ec;
+    const uintmax_t file_size = fs::file_size(path, ec);
+    const bool is_compressible = IsCompressible(path);
+    if (ec || !fs::is_regular_file(path, ec) || file_size > MAX_CACHED_FILE_SIZE
+        || (!is_compressible && file_size > MAX_CACHED_BINARY_FILE_SIZE)) {
+        return RemoveFile(path);
+    }
+
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        return RemoveFile(path);
+    }
+    std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+    // Сжатие выполняется без блокировки, читатели продолжают получать прежнюю запись
+    auto entry = std::make_shared<Entry>();
+    entry->etag = MakeETag(data);
+    if (is_compressible) {
+        entry->gzip = KeepIfSmaller(CompressGzip(data), data);
+        entry->brotli = KeepIfSmaller(CompressBrotli(data), data);
+    }
+    entry->identity = std::make_shared<const std::string>(std::move(data));
+
+    std::unique_lock lock{mutex_};
+    entries_[MakeKey(path)] = std::move(entry);
+}
+
+void StaticFileCache::RemoveFile(const fs::path& path) {
+    std::unique_lock lock{mutex_};
+    entries_.erase(MakeKey(path));
+}
+
+void StaticFileCache::RemoveDirectory(const fs::path& dir) {
+    const std::string prefix = MakeKey(dir) + '/';
+    std::unique_lock lock{mutex_};
+    std::erase_if(entries_, [&prefix](const auto& item) {
+        return item.first.starts_with(prefix);
+    });
+}
+
+void StaticFileCache::Rebuild() {
+    std::unordered_set<std::string> keys;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it{root_, ec}, end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec)) {
+            LoadFile(it->path());
+            keys.insert(MakeKey(it->path()));
+        }
+    }
+    std::unique_lock lock{mutex_};
+    std::erase_if(entries_, [&keys](const auto& item) {
+        return !keys.contains(item.first);
+    });
+}
+
+void StaticFileCache::StartWatching() {
+#ifdef __linux__
+    // Изменения, сделанные после возврата из StartWatching, уже не будут пропущены
+    std::latch watching{1};
+    watcher_ = std::jthread{[this, &watching](std::stop_token stop_token) {
+        Watch(stop_token, watching);
+    }};
+    watching.wait();
+#endif
+}
+
+void StaticFileCache::Watch(std::stop_token stop_token, std::latch& watching) {
+#ifdef __linux__
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        watching.count_down();
+        LOG_WITH_DATA(error, json::object{}, "inotify is unavailable, static files will not be reloaded"sv);
+        return;
+    }
+
+    constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+    std::unordered_map<int, fs::path> watched_dirs;
+    auto add_watch = [fd, &watched_dirs](const fs::path& dir) {
+        if (const int wd = inotify_add_watch(fd, dir.c_str(), WATCH_MASK); wd >= 0) {
+            watched_dirs[wd] = dir;
+        }
+    };
+    auto add_tree = [&add_watch](const fs::path& dir) {
+        add_watch(dir);
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it{dir, ec}, end; !ec && it != end; it.increment(ec)) {
+            if (it->is_directory(ec)) {
+                add_watch(it->path());
+            }
+        }
+    };
+    // Снимает наблюдение с каталога и всех вложенных: после удаления или переноса их пути устарели
+    auto remove_tree = [fd, &watched_dirs](const fs::path& dir) {
+        const std::string prefix = dir.generic_string() + '/';
+        std::erase_if(watched_dirs, [fd, &dir, &prefix](const auto& item) {
+            if (item.second != dir && !item.second.generic_string().starts_with(prefix)) {
+                return false;
+            }
+            inotify_rm_watch(fd, item.first);
+            return true;
+        });
+    };
+    add_tree(root_);
+    watching.count_down();
+
+    alignas(inotify_event) std::array<char, 64 * 1024> buffer;
+    while (!stop_token.stop_requested()) {
+        pollfd poll_fd{fd, POLLIN, 0};
+        // Периодически просыпаемся, чтобы проверить запрос на остановку
+        if (poll(&poll_fd, 1, 500) <= 0) {
+            continue;
+        }
+        const ssize_t length = read(fd, buffer.data(), buffer.size());
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Часть событий потеряна: сверяем наблюдения и весь кеш с диском
+                LOG_WITH_DATA(warning, json::object{}, "inotify queue overflowed, rebuilding static file cache"sv);
+                std::erase_if(watched_dirs, [fd](const auto& item) {
+                    std::error_code ec;
+                    if (fs::is_directory(item.second, ec)) {
+                        return false;
+                    }
+                    inotify_rm_watch(fd, item.first);
+                    return true;
+                });
+                add_tree(root_);
+                try {
+                    Rebuild();
+                } catch (const std::exception& e) {
+                    LOG_WITH_DATA(error, json::object{}, "Failed to rebuild static file cache: "s + e.what());
+                }
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                // Ядро само сняло наблюдение с удалённого каталога
+                watched_dirs.erase(event->wd);
+                continue;
+            }
+
+            auto dir_it = watched_dirs.find(event->wd);
+            if (dir_it == watched_dirs.end() || event->len == 0) {
+                continue;
+            }
+            const fs::path path = dir_it->second / event->name;
+            try {
+                if (event->mask & IN_ISDIR) {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        add_tree(path);
+                        LoadDirectory(path);
+                    } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                        remove_tree(path);
+                        RemoveDirectory(path);
+                    }
+                } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    LoadFile(path);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    RemoveFile(path);
+                }
+            } catch (const std::exception& e) {
+                LOG_WITH_DATA(error, json::object{}, "Failed to reload static file: "s + e.what());
+            }
+        }
+    }
+    close(fd);
+#endif
+}
+
+}  // namespace http_handler
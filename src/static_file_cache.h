@@ -0,0 +1,93 @@
+#pragma once
+
+#include <filesystem>
+#include <latch>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace http_handler {
+
+namespace fs = std::filesystem;
+
+/**
+ * Кеш статических файлов в памяти.
+ * Строится при старте по всему каталогу статики: для каждого файла хранит содержимое,
+ * его gzip- и brotli-варианты (для сжимаемых типов) и строгий ETag.
+ * При изменении файлов на диске записи перечитываются по событиям inotify.
+ */
+class StaticFileCache {
+public:
+    // Файлы крупнее этого размера не кешируются и отдаются с диска
+    constexpr static uintmax_t MAX_CACHED_FILE_SIZE = 16 * 1024 * 1024;
+    // Крупные несжимаемые файлы (модели, изображения) выгоднее отдавать с диска через sendfile
+    constexpr static uintmax_t MAX_CACHED_BINARY_FILE_SIZE = 128 * 1024;
+
+    struct Entry {
+        std::shared_ptr<const std::string> identity;
+        // Пустые указатели, если сжатие не уменьшает размер или тип файла не сжимается
+        std::shared_ptr<const std::string> gzip;
+        std::shared_ptr<const std::string> brotli;
+        std::string etag;
+    };
+
+    explicit StaticFileCache(fs::path root);
+
+    StaticFileCache(const StaticFileCache&) = delete;
+    StaticFileCache& operator=(const StaticFileCache&) = delete;
+
+    ~StaticFileCache();
+
+    // Загружает все файлы каталога
+    void Build();
+
+    // Перечитывает каталог и удаляет записи файлов, которых больше нет на диске
+    void Rebuild();
+
+    // Запускает поток, перечитывающий изменённые файлы (только Linux).
+    // Возвращает управление, когда наблюдение за каталогами уже установлено
+    void StartWatching();
+
+    // Ищет файл по пути относительно корня статики (с прямыми слешами)
+    std::shared_ptr<const Entry> Find(const std::string& relative_path) const;
+
+    const fs::path& GetRoot() const noexcept {
+        return root_;
+    }
+
+    size_t Size() const;
+
+private:
+    fs::path root_;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const Entry>> entries_;
+
+    std::jthread watcher_;
+
+    std::string MakeKey(const fs::path& path) const;
+
+    // Перечитывает файл в кеш; если файла нет или он не должен кешироваться, удаляет запись
+    void LoadFile(const fs::path& path);
+
+    void RemoveFile(const fs::path& path);
+
+    // Удаляет записи всех файлов внутри каталога
+    void RemoveDirectory(const fs::path& dir);
+
+    void LoadDirectory(const fs::path& dir);
+
+    // Сообщает через watching, что наблюдение за каталогами установлено
+    void Watch(std::stop_token stop_token, std::latch& watching);
+};
+
+// Проверяет, разрешает ли заголовок Accept-Encoding кодирование coding (с учётом q=0 и "*")
+bool AcceptsEncoding(std::string_view accept_encoding, std::string_view coding);
+
+// Проверяет, совпадает ли один из тегов заголовка If-None-Match с etag
+bool MatchesIfNoneMatch(std::string_view if_none_match, std::string_view etag);
+
+}  // namespace http_handler
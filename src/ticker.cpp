@@ -1,41 +1,147 @@
 #include "ticker.h"
 #include "logger.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace ticker {
 
 using namespace logger;
 using namespace std::literals;
 
+CatchUpPolicy ParseCatchUpPolicy(std::string_view name) {
+    if (name == "skip"sv) {
+        return CatchUpPolicy::SKIP;
+    } else if (name == "merge"sv) {
+        return CatchUpPolicy::MERGE;
+    } else if (name == "substeps"sv) {
+        return CatchUpPolicy::SUBSTEPS;
+    }
+    throw std::invalid_argument("Unknown tick catch-up policy: "s + std::string(name));
+}
+
+CatchUpPlan PlanCatchUp(CatchUpPolicy policy, std::chrono::milliseconds period, unsigned max_substeps,
+    std::chrono::steady_clock::time_point deadline, std::chrono::steady_clock::time_point now
+) {
+    // Сколько периодов наступило к этому моменту, включая запланированный.
+    // Больше одного, если таймер сработал с опозданием или предыдущий тик затянулся
+    const uint64_t due_periods = 1 + (now > deadline ? static_cast<uint64_t>((now - deadline) / period) : 0);
+
+    CatchUpPlan plan;
+    plan.late_periods = due_periods - 1;
+    plan.next_deadline = deadline + period * due_periods;
+    switch (policy) {
+        case CatchUpPolicy::SKIP:
+            plan.dropped_periods = plan.late_periods;
+            plan.delta = period;
+            break;
+        case CatchUpPolicy::MERGE:
+            plan.delta = period * due_periods;
+            break;
+        case CatchUpPolicy::SUBSTEPS:
+            plan.handler_calls = std::min<uint64_t>(due_periods, std::max(1u, max_substeps));
+            plan.dropped_periods = due_periods - plan.handler_calls;
+            plan.delta = period;
+            break;
+    }
+    return plan;
+}
+
+Ticker::Ticker(Strand strand, const Config& config, Handler handler)
+    : strand_{strand}
+    , period_{config.period}
+    , catch_up_{config.catch_up}
+    , max_substeps_{std::max(1u, config.max_substeps)}
+    , handler_{std::move(handler)} {
+    if (period_ <= std::chrono::milliseconds::zero()) {
+        throw std::invalid_argument("Tick period must be positive"s);
+    }
+}
+
 void Ticker::Start() {
     net::dispatch(strand_, [self = shared_from_this()] {
-        self->last_tick_ = Clock::now();
+        self->next_deadline_ = Clock::now() + self->period_;
         self->ScheduleTick();
     });
 }
 
+Ticker::Stats Ticker::GetStats() const noexcept {
+    Stats stats;
+    stats.ticks = ticks_.load(std::memory_order_relaxed);
+    stats.overruns = overruns_.load(std::memory_order_relaxed);
+    stats.late_periods = late_periods_.load(std::memory_order_relaxed);
+    stats.dropped_periods = dropped_periods_.load(std::memory_order_relaxed);
+    stats.max_duration = std::chrono::microseconds(max_duration_us_.load(std::memory_order_relaxed));
+    return stats;
+}
+
+void Ticker::RunHandler(std::chrono::milliseconds delta) {
+    try {
+        handler_(delta);
+    } catch (const std::exception& e) {
+        LOG_WITH_DATA(error, json::object{}, "Ticker error has occurred: "s + e.what());
+    }
+    ticks_.fetch_add(1, std::memory_order_relaxed);
+}
+
 void Ticker::OnTick(sys::error_code ec) {
     using namespace std::chrono;
     assert(strand_.running_in_this_thread());
 
-    if (!ec) {
-        auto this_tick = Clock::now();
-        auto delta = duration_cast<milliseconds>(this_tick - last_tick_);
-        last_tick_ = this_tick;
-        try {
-            handler_(delta);
-        } catch (const std::exception& e) {
-            LOG_WITH_DATA(error, json::object{}, "Ticker error has occurred: "s + e.what());
+    if (ec) {
+        return;
+    }
+
+    const auto this_tick = Clock::now();
+    const CatchUpPlan plan = PlanCatchUp(catch_up_, period_, max_substeps_, next_deadline_, this_tick);
+    next_deadline_ = plan.next_deadline;
+    for (uint64_t i = 0; i < plan.handler_calls; ++i) {
+        RunHandler(plan.delta);
+    }
+    const uint64_t late_periods = plan.late_periods;
+    const uint64_t dropped_periods = plan.dropped_periods;
+    const uint64_t handler_calls = plan.handler_calls;
+
+    const auto duration = Clock::now() - this_tick;
+    const bool is_overrun = duration > period_;
+    if (late_periods) {
+        late_periods_.fetch_add(late_periods, std::memory_order_relaxed);
+    }
+    if (dropped_periods) {
+        dropped_periods_.fetch_add(dropped_periods, std::memory_order_relaxed);
+    }
+    if (is_overrun) {
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Максимум пишет только strand тикера
+    const int64_t duration_us = duration_cast<microseconds>(duration).count();
+    if (duration_us > max_duration_us_.load(std::memory_order_relaxed)) {
+        max_duration_us_.store(duration_us, std::memory_order_relaxed);
+    }
+
+    if (metrics::IsEnabled()) {
+        // Тик дольше своего периода приводит к опозданию следующих
+        metrics::Observe(metrics::Histogram::TICK_DURATION, duration);
+        metrics::Increment(metrics::Counter::TICKS, handler_calls);
+        if (is_overrun) {
+            metrics::Increment(metrics::Counter::TICK_OVERRUNS);
         }
-        ScheduleTick();
+        metrics::Increment(metrics::Counter::TICK_LATE_PERIODS, late_periods);
+        metrics::Increment(metrics::Counter::TICK_DROPPED_PERIODS, dropped_periods);
     }
+
+    ScheduleTick();
 }
 
 void Ticker::ScheduleTick() {
     assert(strand_.running_in_this_thread());
-    timer_.expires_after(period_);
+    // Следующее срабатывание отсчитывается от расписания, а не от конца обработки,
+    // поэтому длительность тика не накапливается в периоде
+    timer_.expires_at(next_deadline_);
     timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
         self->OnTick(ec);
     });
 }
 
-} // namespace ticker
\ No newline at end of file
+} // namespace ticker
@@ -3,41 +3,110 @@
 #include <boost/asio/strand.hpp>
 #include <boost/asio.hpp>
 
+#include <atomic>
 #include <memory>
 #include <chrono>
+#include <cstdint>
 #include <functional>
+#include <string_view>
 
 namespace ticker {
 
 namespace net = boost::asio;
 namespace sys = boost::system;
 
+// Поведение тикера, когда он отстал от расписания на несколько периодов
+enum class CatchUpPolicy {
+    // Пропущенные периоды отбрасываются, handler получает один период, игровое время отстаёт от реального
+    SKIP,
+    // Пропущенные периоды объединяются в один вызов handler с суммарным временем
+    MERGE,
+    // handler вызывается отдельно для каждого пропущенного периода, но не более max_substeps раз подряд
+    SUBSTEPS
+};
+
+// Разбирает название политики: skip, merge или substeps
+CatchUpPolicy ParseCatchUpPolicy(std::string_view name);
+
+// Что тикер делает при одном срабатывании таймера
+struct CatchUpPlan {
+    // Сколько раз вызвать handler и какое время передать в каждый вызов
+    uint64_t handler_calls = 1;
+    std::chrono::milliseconds delta{0};
+    // Периоды, наступившие до срабатывания, кроме запланированного
+    uint64_t late_periods = 0;
+    // Периоды, время которых не передаётся в handler
+    uint64_t dropped_periods = 0;
+    // Момент следующего срабатывания
+    std::chrono::steady_clock::time_point next_deadline;
+};
+
+// Рассчитывает срабатывание в момент now, запланированное на deadline. Не зависит от часов и таймера
+CatchUpPlan PlanCatchUp(CatchUpPolicy policy, std::chrono::milliseconds period, unsigned max_substeps,
+    std::chrono::steady_clock::time_point deadline, std::chrono::steady_clock::time_point now);
+
 class Ticker : public std::enable_shared_from_this<Ticker> {
 public:
     using Strand = net::strand<net::io_context::executor_type>;
     using Handler = std::function<void(std::chrono::milliseconds delta)>;
 
+    struct Config {
+        std::chrono::milliseconds period{0};
+        CatchUpPolicy catch_up = CatchUpPolicy::MERGE;
+        // Максимум вызовов handler за одно срабатывание таймера для CatchUpPolicy::SUBSTEPS
+        unsigned max_substeps = 5;
+    };
+
+    struct Stats {
+        // Число вызовов handler
+        uint64_t ticks = 0;
+        // Число срабатываний, обработка которых заняла больше периода
+        uint64_t overruns = 0;
+        // Число периодов, наступивших до того, как тикер успел их обработать в срок
+        uint64_t late_periods = 0;
+        // Число периодов, время которых не передано в handler (SKIP и превышение max_substeps)
+        uint64_t dropped_periods = 0;
+        std::chrono::microseconds max_duration{0};
+    };
+
     // Функция handler будет вызываться внутри strand с интервалом period
     Ticker(Strand strand, std::chrono::milliseconds period, Handler handler)
-        : strand_{strand}
-        , period_{period}
-        , handler_{std::move(handler)} {
+        : Ticker(strand, Config{period}, std::move(handler)) {
     }
 
+    // Срабатывания планируются на моменты start + n * period независимо от длительности handler,
+    // поэтому средняя частота тиков не зависит от того, сколько длится сам тик
+    Ticker(Strand strand, const Config& config, Handler handler);
+
     void Start();
 
+    // Счётчики тикера, можно вызывать из любого потока
+    Stats GetStats() const noexcept;
+
 private:
     void ScheduleTick();
 
     void OnTick(sys::error_code ec);
 
+    // Вызывает handler, перехватывая исключения
+    void RunHandler(std::chrono::milliseconds delta);
+
     using Clock = std::chrono::steady_clock;
 
     Strand strand_;
     std::chrono::milliseconds period_;
+    CatchUpPolicy catch_up_;
+    unsigned max_substeps_;
     net::steady_timer timer_{strand_};
     Handler handler_;
-    std::chrono::steady_clock::time_point last_tick_;
+    // Момент, на который запланировано следующее срабатывание
+    Clock::time_point next_deadline_;
+
+    std::atomic<uint64_t> ticks_{0};
+    std::atomic<uint64_t> overruns_{0};
+    std::atomic<uint64_t> late_periods_{0};
+    std::atomic<uint64_t> dropped_periods_{0};
+    std::atomic<int64_t> max_duration_us_{0};
 };
 
-} // namespace ticker
\ No newline at end of file
+} // namespace ticker
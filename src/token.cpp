@@ -0,0 +1,75 @@
+#include "token.h"
+
+#include <array>
+
+namespace application {
+
+namespace {
+
+constexpr uint8_t INVALID_HEX = 0xFF;
+
+// Таблица значений hex-символов: индексирование вместо сравнений.
+// Допустимы только символы, которые выдаёт ToHex (0-9, a-f)
+constexpr std::array<uint8_t, 256> MakeHexTable() {
+    std::array<uint8_t, 256> table{};
+    for (uint8_t& value : table) {
+        value = INVALID_HEX;
+    }
+    for (int c = '0'; c <= '9'; ++c) {
+        table[c] = static_cast<uint8_t>(c - '0');
+    }
+    for (int c = 'a'; c <= 'f'; ++c) {
+        table[c] = static_cast<uint8_t>(c - 'a' + 10);
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> HEX_TABLE = MakeHexTable();
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+// Разбирает 16 символов в 64-битное число; в invalid накапливаются старшие биты ошибок
+uint64_t DecodeHalf(const char* hex, uint8_t& invalid) noexcept {
+    uint64_t result = 0;
+    for (size_t i = 0; i < 16; ++i) {
+        const uint8_t value = HEX_TABLE[static_cast<unsigned char>(hex[i])];
+        invalid |= value;
+        result = (result << 4) | (value & 0x0F);
+    }
+    return result;
+}
+
+void EncodeHalf(uint64_t value, char* out) noexcept {
+    for (size_t i = 0; i < 16; ++i) {
+        out[15 - i] = HEX_DIGITS[value & 0x0F];
+        value >>= 4;
+    }
+}
+
+}  // namespace
+
+std::optional<Token> Token::FromHex(std::string_view hex) noexcept {
+    if (hex.size() != HEX_SIZE) {
+        return std::nullopt;
+    }
+    // Значения допустимых символов не превышают 0x0F, у недопустимых установлены старшие биты
+    uint8_t invalid = 0;
+    const uint64_t high = DecodeHalf(hex.data(), invalid);
+    const uint64_t low = DecodeHalf(hex.data() + 16, invalid);
+    if (invalid & 0xF0) {
+        return std::nullopt;
+    }
+    return Token{high, low};
+}
+
+void Token::ToHex(char* out) const noexcept {
+    EncodeHalf(high_, out);
+    EncodeHalf(low_, out + 16);
+}
+
+std::string Token::ToHex() const {
+    std::string result(HEX_SIZE, '0');
+    ToHex(result.data());
+    return result;
+}
+
+}  // namespace application
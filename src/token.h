@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+namespace application {
+
+// Токен авторизации игрока: 128 случайных бит.
+// В API передаётся как 32 шестнадцатеричных символа в нижнем регистре
+class Token {
+public:
+    constexpr static size_t HEX_SIZE = 32;
+
+    Token() = default;
+
+    Token(uint64_t high, uint64_t low) noexcept
+    : high_(high), low_(low)
+    {
+
+    }
+
+    // Разбирает 32 hex-символа без ветвлений по символам, при неверном формате возвращает nullopt
+    static std::optional<Token> FromHex(std::string_view hex) noexcept;
+
+    // Записывает HEX_SIZE символов в out
+    void ToHex(char* out) const noexcept;
+
+    std::string ToHex() const;
+
+    uint64_t GetHigh() const noexcept {
+        return high_;
+    }
+
+    uint64_t GetLow() const noexcept {
+        return low_;
+    }
+
+    auto operator<=>(const Token&) const = default;
+
+private:
+    uint64_t high_ = 0;
+    uint64_t low_ = 0;
+};
+
+// Хеш-таблица с открытой адресацией (линейное пробирование) с ключом Token.
+// Токены случайны, поэтому для хеша достаточно перемешать их биты одним умножением.
+// Удаление выполняется сдвигом последующих элементов, без "надгробий"
+template <typename Value>
+class TokenMap {
+public:
+    TokenMap() = default;
+
+    Value* Find(const Token& token) noexcept {
+        return const_cast<Value*>(std::as_const(*this).Find(token));
+    }
+
+    const Value* Find(const Token& token) const noexcept {
+        if (size_ == 0) {
+            return nullptr;
+        }
+        for (size_t idx = Bucket(token); slots_[idx].occupied; idx = (idx + 1) & mask_) {
+            if (slots_[idx].token == token) {
+                return &slots_[idx].value;
+            }
+        }
+        return nullptr;
+    }
+
+    void InsertOrAssign(const Token& token, Value value) {
+        // Коэффициент заполнения не превышает 1/2, чтобы цепочки пробирования оставались короткими
+        if ((size_ + 1) * 2 > slots_.size()) {
+            Rehash(slots_.empty() ? MIN_CAPACITY : slots_.size() * 2);
+        }
+        size_t idx = Bucket(token);
+        for (; slots_[idx].occupied; idx = (idx + 1) & mask_) {
+            if (slots_[idx].token == token) {
+                slots_[idx].value = std::move(value);
+                return;
+            }
+        }
+        slots_[idx] = Slot{token, std::move(value), true};
+        ++size_;
+    }
+
+    bool Erase(const Token& token) {
+        if (size_ == 0) {
+            return false;
+        }
+        size_t idx = Bucket(token);
+        for (; slots_[idx].occupied; idx = (idx + 1) & mask_) {
+            if (slots_[idx].token == token) {
+                break;
+            }
+        }
+        if (!slots_[idx].occupied) {
+            return false;
+        }
+        // Сдвигаем назад элементы цепочки, которые могут занять освободившуюся ячейку
+        size_t hole = idx;
+        for (size_t next = (hole + 1) & mask_; slots_[next].occupied; next = (next + 1) & mask_) {
+            const size_t home = Bucket(slots_[next].token);
+            // Элемент можно переместить, если его "домашняя" ячейка не лежит между hole и next
+            if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+                slots_[hole] = std::move(slots_[next]);
+                hole = next;
+            }
+        }
+        slots_[hole] = Slot{};
+        --size_;
+        return true;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    // Вызывает fn(token, value) для каждого элемента
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        for (const Slot& slot : slots_) {
+            if (slot.occupied) {
+                fn(slot.token, slot.value);
+            }
+        }
+    }
+
+private:
+    constexpr static size_t MIN_CAPACITY = 16;
+
+    struct Slot {
+        Token token;
+        Value value{};
+        bool occupied = false;
+    };
+
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    size_t size_ = 0;
+
+    size_t Bucket(const Token& token) const noexcept {
+        const uint64_t mixed = (token.GetHigh() ^ token.GetLow()) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(mixed >> 32) & mask_;
+    }
+
+    void Rehash(size_t capacity) {
+        std::vector<Slot> old_slots(capacity);
+        old_slots.swap(slots_);
+        mask_ = capacity - 1;
+        size_ = 0;
+        for (Slot& slot : old_slots) {
+            if (slot.occupied) {
+                size_t idx = Bucket(slot.token);
+                while (slots_[idx].occupied) {
+                    idx = (idx + 1) & mask_;
+                }
+                slots_[idx] = std::move(slot);
+                ++size_;
+            }
+        }
+    }
+};
+
+}  // namespace application
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/json.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/application.h"
+#include "../src/database/memory/memory.h"
+
+using namespace std::literals;
+namespace json = boost::json;
+
+namespace {
+
+constexpr size_t PLAYERS = model::Map::DEFAULT_MAX_PLAYERS;
+// Дольше порога неактивности игры, чтобы неподвижные собаки выбывали за один тик
+constexpr std::chrono::milliseconds RETIREMENT_TICK{1500};
+
+model::Game MakeGame() {
+    // Неактивные собаки выбывают через секунду
+    model::Game game{model::LootGeneratorConfig{1000, 0.0}, std::chrono::milliseconds{1000}};
+    model::Map map{model::Map::Id{"map1"s}, "Map 1"s, 1.0, false, 1, 3};
+    map.AddRoad(std::make_shared<model::Road>(model::Road::HORIZONTAL, model::Point{0, 0}, 100));
+    game.AddMap(std::move(map));
+
+    extra_data::LootTypes loot_types;
+    loot_types.AddLootTypes("map1"s, json::array{json::object{
+        {"name"s, "key"s}, {"file"s, "assets/key.obj"s}, {"type"s, "obj"s}, {"scale"s, 0.03}, {"value"s, 10}
+    }});
+    game.SetLootTypes(std::move(loot_types));
+    return game;
+}
+
+std::vector<application::Player::Id> GetIds(const std::vector<std::shared_ptr<application::Player>>& players) {
+    std::vector<application::Player::Id> ids;
+    for (const auto& player : players) {
+        ids.push_back(player->GetId());
+    }
+    std::sort(ids.begin(), ids.end(), [](const auto& lhs, const auto& rhs) {
+        return *lhs < *rhs;
+    });
+    return ids;
+}
+
+}  // namespace
+
+SCENARIO("Retired players are removed from application indexes") {
+    memory::PlayerRepositoryImpl records;
+    application::Application app{MakeGame(), application::AppConfig{}, records};
+
+    std::vector<application::Token> tokens;
+    std::vector<application::Player::Id> ids;
+    for (size_t i = 0; i < PLAYERS; ++i) {
+        auto [token, id] = app.JoinGame("Dog"s + std::to_string(i), model::Map::Id{"map1"s});
+        tokens.push_back(token);
+        ids.push_back(id);
+    }
+    const std::shared_ptr<application::Player> first = app.FindPlayerByToken(tokens.front());
+    REQUIRE(first);
+    REQUIRE(app.GetCurrentPlayerGameSessionPlayers(first).size() == PLAYERS);
+
+    // Движущиеся собаки не выбывают
+    auto keep_moving = [&app, &tokens](std::initializer_list<size_t> indexes) {
+        for (size_t i : indexes) {
+            app.MovePlayer(app.FindPlayerByToken(tokens[i]), "R"s);
+        }
+    };
+
+    GIVEN("a session with several players") {
+        WHEN("a middle and the last player retire") {
+            keep_moving({0, 1, 3});
+            app.Tick(RETIREMENT_TICK);
+
+            THEN("the remaining players are still indexed") {
+                const std::vector<application::Player::Id> expected{ids[0], ids[1], ids[3]};
+                CHECK(GetIds(app.GetPlayers()) == expected);
+                CHECK(GetIds(app.GetCurrentPlayerGameSessionPlayers(first)) == expected);
+                CHECK(records.GetSize() == 2);
+
+                for (size_t i : {0, 1, 3}) {
+                    const auto player = app.FindPlayerByToken(tokens[i]);
+                    REQUIRE(player);
+                    CHECK(player->GetId() == ids[i]);
+                }
+                CHECK_FALSE(app.FindPlayerByToken(tokens[2]));
+                CHECK_FALSE(app.FindPlayerByToken(tokens[4]));
+
+                // Собаки оставшихся игроков остались в сессии
+                const auto& dogs = first->GetSession()->GetDogs();
+                CHECK(dogs.size() == 3);
+                for (size_t i : {0, 1, 3}) {
+                    const auto dog = app.FindPlayerByToken(tokens[i])->GetDog();
+                    CHECK(std::find(dogs.begin(), dogs.end(), dog) != dogs.end());
+                }
+
+                AND_WHEN("players moved into freed positions retire too") {
+                    // Игрок 3 мог переехать на освободившееся место, его позиции и собака должны найтись
+                    app.MovePlayer(app.FindPlayerByToken(tokens[3]), ""s);
+                    keep_moving({0, 1});
+                    app.Tick(RETIREMENT_TICK);
+
+                    CHECK(GetIds(app.GetPlayers()) == std::vector<application::Player::Id>{ids[0], ids[1]});
+                    CHECK(GetIds(app.GetCurrentPlayerGameSessionPlayers(first)) == std::vector<application::Player::Id>{ids[0], ids[1]});
+                    CHECK_FALSE(app.FindPlayerByToken(tokens[3]));
+                    CHECK(records.GetSize() == 3);
+
+                    // Остальные выбывают, все индексы пустеют
+                    app.MovePlayer(app.FindPlayerByToken(tokens[0]), ""s);
+                    app.MovePlayer(app.FindPlayerByToken(tokens[1]), ""s);
+                    app.Tick(RETIREMENT_TICK);
+
+                    CHECK(app.GetPlayers().empty());
+                    CHECK(app.GetCurrentPlayerGameSessionPlayers(first).empty());
+                    CHECK_FALSE(app.FindPlayerByToken(tokens[0]));
+                    CHECK_FALSE(app.FindPlayerByToken(tokens[1]));
+                    CHECK(records.GetSize() == PLAYERS);
+                }
+            }
+        }
+    }
+}
@@ -10,6 +10,7 @@
 #include <memory>
 #include <algorithm>
 #include <sstream>
+#include <tuple>
 
 // Напишите здесь тесты для функции collision_detector::FindGatherEvents
 
@@ -517,4 +518,67 @@ SCENARIO("Collision detection") {
             CHECK(events.empty());
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Grid search finds the same events as full search", TAG) {
+    collision_detector::ItemGathererProviderImpl provider;
+
+    // Предметы и базы, разбросанные по сетке 40x40
+    for (int x = -20; x < 20; x += 3) {
+        for (int y = -20; y < 20; y += 3) {
+            provider.AddItem({{x + 0.25, y - 0.5}, (x + y) % 2 ? 0.5 : 0.0});
+        }
+    }
+
+    // Собиратели, движущиеся вдоль осей на разные расстояния, в том числе через несколько ячеек
+    for (int i = -18; i < 18; i += 4) {
+        provider.AddGatherer({{static_cast<double>(i), -0.5}, {i + 2.5, -0.5}, 0.3});
+        provider.AddGatherer({{0.25, static_cast<double>(i)}, {0.25, i - 7.0}, 0.3});
+        provider.AddGatherer({{-30.0, i + 1.0}, {30.0, i + 1.0}, 0.6});
+    }
+
+    auto by_ids = [](const collision_detector::GatheringEvent& l, const collision_detector::GatheringEvent& r) {
+        return std::tie(l.gatherer_id, l.item_id) < std::tie(r.gatherer_id, r.item_id);
+    };
+
+    auto expected = collision_detector::FindGatherEvents(provider);
+    auto actual = collision_detector::FindGatherEventsInGrid(provider, 4.0);
+    REQUIRE_FALSE(expected.empty());
+
+    std::sort(expected.begin(), expected.end(), by_ids);
+    std::sort(actual.begin(), actual.end(), by_ids);
+    CHECK_THAT(actual, EqualsRange(expected, CompareEvents()));
+}
+
+TEST_CASE("Reused grid matches full search for different item sets", TAG) {
+    collision_detector::ItemGrid grid{4.0};
+
+    auto by_ids = [](const collision_detector::GatheringEvent& l, const collision_detector::GatheringEvent& r) {
+        return std::tie(l.gatherer_id, l.item_id) < std::tie(r.gatherer_id, r.item_id);
+    };
+
+    // Одна и та же сетка обслуживает разные наборы: маленький ищется перебором, большие - по ячейкам,
+    // в том числе с отрицательными и очень большими координатами
+    for (const double offset : {0.0, -1000.0, 1e12}) {
+        for (const int side : {2, 40}) {
+            collision_detector::ItemGathererProviderImpl provider;
+            for (int x = 0; x < side; ++x) {
+                for (int y = 0; y < side; ++y) {
+                    provider.AddItem({{offset + x * 1.5, offset - y * 1.5}, 0.0});
+                }
+            }
+            for (int i = 0; i < side; ++i) {
+                provider.AddGatherer({{offset, offset - i * 1.5}, {offset + side * 1.5, offset - i * 1.5}, 0.3});
+                provider.AddGatherer({{offset + i * 1.5, offset}, {offset + i * 1.5, offset - 3.0}, 0.3});
+            }
+
+            auto expected = collision_detector::FindGatherEvents(provider);
+            auto actual = grid.FindGatherEvents(provider);
+            REQUIRE_FALSE(expected.empty());
+
+            std::sort(expected.begin(), expected.end(), by_ids);
+            std::sort(actual.begin(), actual.end(), by_ids);
+            CHECK_THAT(actual, EqualsRange(expected, CompareEvents()));
+        }
+    }
+}
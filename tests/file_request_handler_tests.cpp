@@ -0,0 +1,120 @@
+#include <optional>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/file_request_handler.h"
+
+using namespace std::literals;
+using http_handler::ByteRange;
+using http_handler::FileRequestHandler;
+using http_handler::ParseRange;
+using http_handler::UnsatisfiableRange;
+
+namespace {
+
+// Путь относительно корня статики, как его получает обработчик, либо nullopt для 400 bad request
+std::optional<std::string> Resolve(std::string target) {
+    if (FileRequestHandler::DecodePath(target) && FileRequestHandler::NormalizePath(target)) {
+        return target;
+    }
+    return std::nullopt;
+}
+
+bool IsWholeFile(std::string_view range, std::uint64_t total_size) {
+    return std::holds_alternative<std::monostate>(ParseRange(range, total_size));
+}
+
+bool IsUnsatisfiable(std::string_view range, std::uint64_t total_size) {
+    return std::holds_alternative<UnsatisfiableRange>(ParseRange(range, total_size));
+}
+
+std::optional<std::pair<std::uint64_t, std::uint64_t>> GetByteRange(std::string_view range, std::uint64_t total_size) {
+    const auto result = ParseRange(range, total_size);
+    if (const ByteRange* byte_range = std::get_if<ByteRange>(&result)) {
+        return std::pair{byte_range->offset, byte_range->size};
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+TEST_CASE("Request target is resolved to a path under the static root") {
+    SECTION("directories are mapped to index.html") {
+        CHECK(Resolve(""s) == "index.html"s);
+        CHECK(Resolve("/"s) == "index.html"s);
+        CHECK(Resolve("/docs/"s) == "docs/index.html"s);
+        CHECK(Resolve("/docs/?page=2"s) == "docs/index.html"s);
+        CHECK(Resolve("/docs/.."s) == "index.html"s);
+        CHECK(Resolve("/docs"s) == "docs"s);
+    }
+
+    SECTION("empty segments, dots and parent references inside the root are collapsed") {
+        CHECK(Resolve("/a/./b//c.js"s) == "a/b/c.js"s);
+        CHECK(Resolve("/a/b/../c.js"s) == "a/c.js"s);
+        CHECK(Resolve("//a///b.css"s) == "a/b.css"s);
+    }
+
+    SECTION("paths escaping the root are rejected") {
+        CHECK_FALSE(Resolve("/../x"s));
+        CHECK_FALSE(Resolve("/a/../../x"s));
+        CHECK_FALSE(Resolve("/%2e%2e/x"s));
+        CHECK_FALSE(Resolve("/%2E%2E%2Fx"s));
+        CHECK_FALSE(Resolve("/..%2Fx"s));
+        CHECK_FALSE(Resolve("/a/..%2f..%2fx"s));
+    }
+
+    SECTION("malformed escapes and null characters are rejected") {
+        CHECK_FALSE(Resolve("/a%00b"s));
+        CHECK_FALSE(Resolve("/a%4"s));
+        CHECK_FALSE(Resolve("/a%"s));
+        CHECK_FALSE(Resolve("/a%zz"s));
+    }
+
+    SECTION("query and fragment are stripped before decoding") {
+        CHECK(Resolve("/game.js?v=1.2"s) == "game.js"s);
+        CHECK(Resolve("/page.html#top"s) == "page.html"s);
+        CHECK(Resolve("/a.txt?next=../../etc/passwd"s) == "a.txt"s);
+        CHECK(Resolve("/a.txt?bad=%4"s) == "a.txt"s);
+        // Экранированные '?' и '#' относятся к имени файла
+        CHECK(Resolve("/what%3F%23.txt"s) == "what?#.txt"s);
+    }
+
+    SECTION("plus and percent escapes are decoded") {
+        CHECK(Resolve("/my+file%20name.txt"s) == "my file name.txt"s);
+        CHECK(Resolve("/%41%62c.TXT"s) == "Abc.TXT"s);
+    }
+}
+
+TEST_CASE("Range header parsing") {
+    constexpr std::uint64_t size = 100;
+
+    SECTION("satisfiable ranges") {
+        CHECK(GetByteRange("bytes=0-"sv, size) == std::pair<std::uint64_t, std::uint64_t>{0, 100});
+        CHECK(GetByteRange("bytes=5-5"sv, size) == std::pair<std::uint64_t, std::uint64_t>{5, 1});
+        CHECK(GetByteRange("bytes=90-200"sv, size) == std::pair<std::uint64_t, std::uint64_t>{90, 10});
+        CHECK(GetByteRange("bytes=-10"sv, size) == std::pair<std::uint64_t, std::uint64_t>{90, 10});
+    }
+
+    SECTION("suffix larger than the file selects the whole file") {
+        CHECK(GetByteRange("bytes=-500"sv, size) == std::pair<std::uint64_t, std::uint64_t>{0, 100});
+    }
+
+    SECTION("unsatisfiable ranges") {
+        CHECK(IsUnsatisfiable("bytes=-0"sv, size));
+        CHECK(IsUnsatisfiable("bytes=100-"sv, size));
+        CHECK(IsUnsatisfiable("bytes=150-200"sv, size));
+        CHECK(IsUnsatisfiable("bytes=0-0"sv, 0));
+        CHECK(IsUnsatisfiable("bytes=-5"sv, 0));
+    }
+
+    SECTION("invalid or unsupported headers fall back to the whole file") {
+        CHECK(IsWholeFile(""sv, size));
+        CHECK(IsWholeFile("bytes=10-5"sv, size));
+        CHECK(IsWholeFile("bytes=0-10,20-30"sv, size));
+        CHECK(IsWholeFile("bytes=-10,-20"sv, size));
+        CHECK(IsWholeFile("items=0-10"sv, size));
+        CHECK(IsWholeFile("bytes=abc"sv, size));
+        CHECK(IsWholeFile("bytes=1x-5"sv, size));
+        CHECK(IsWholeFile("bytes=-"sv, size));
+    }
+}
@@ -1,4 +1,5 @@
 #include <cmath>
+#include <vector>
 #include <catch2/catch_test_macros.hpp>
 
 #include "../src/loot_generator.h"
@@ -71,4 +72,32 @@ SCENARIO("Loot generation") {
             }
         }
     }
+
+    GIVEN("a loot generator shared by several sessions") {
+        constexpr TimeInterval BASE_INTERVAL = 1s;
+        const LootGenerator gen{BASE_INTERVAL, 0.5};
+
+        WHEN("loot is generated for a batch of sessions") {
+            std::vector<LootGenerator::State> states(3);
+            std::vector<LootGenerator::Request> requests{
+                {&states[0], 0, 4},
+                {&states[1], 4, 4},
+                {&states[2], 0, 4}
+            };
+            std::vector<unsigned> generated(requests.size());
+            gen.Generate(BASE_INTERVAL * 2, requests, generated);
+
+            THEN("every session is evaluated independently") {
+                CHECK(generated[0] == 3);
+                CHECK(generated[1] == 0);
+                CHECK(generated[2] == 3);
+            }
+
+            THEN("only sessions without spawned loot keep accumulating time") {
+                CHECK(states[0].time_without_loot == TimeInterval::zero());
+                CHECK(states[1].time_without_loot == BASE_INTERVAL * 2);
+                CHECK(states[2].time_without_loot == TimeInterval::zero());
+            }
+        }
+    }
 }
@@ -0,0 +1,83 @@
+#include <memory>
+#include <string>
+#include <boost/json.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/application.h"
+#include "../src/database/memory/memory.h"
+
+using namespace std::literals;
+namespace json = boost::json;
+
+namespace {
+
+model::Game MakeGame() {
+    // Трофеи появляются только при входе игроков
+    model::Game game{model::LootGeneratorConfig{1000, 0.0}, std::chrono::milliseconds{1000}};
+    model::Map map{model::Map::Id{"map1"s}, "Map 1"s, 1.0, false, 1, 3};
+    map.AddRoad(std::make_shared<model::Road>(model::Road::HORIZONTAL, model::Point{0, 0}, 10));
+    map.AddRoad(std::make_shared<model::Road>(model::Road::VERTICAL, model::Point{0, 0}, 5));
+    game.AddMap(std::move(map));
+
+    extra_data::LootTypes loot_types;
+    loot_types.AddLootTypes("map1"s, json::array{json::object{
+        {"name"s, "key"s}, {"file"s, "assets/key.obj"s}, {"type"s, "obj"s}, {"scale"s, 0.03}, {"value"s, 10}
+    }});
+    game.SetLootTypes(std::move(loot_types));
+    return game;
+}
+
+}  // namespace
+
+SCENARIO("Map stats") {
+    GIVEN("an application with players on a map") {
+        memory::PlayerRepositoryImpl records;
+        application::Application app{MakeGame(), application::AppConfig{}, records};
+        app.JoinGame("Rex"s, model::Map::Id{"map1"s});
+        app.JoinGame("Pluto"s, model::Map::Id{"map1"s});
+
+        THEN("counters reflect sessions, dogs, loot and tokens") {
+            const std::vector<application::MapStats> stats = app.GetMapStats();
+            REQUIRE(stats.size() == 1);
+            CHECK(stats[0].map_id == "map1"sv);
+            CHECK(stats[0].sessions == 1);
+            CHECK(stats[0].dogs == 2);
+            CHECK(stats[0].lost_objects == 2);
+            CHECK(stats[0].tokens == 2);
+            CHECK(stats[0].road_index_bytes > 17 * sizeof(std::shared_ptr<model::Road>));
+            CHECK(stats[0].sessions_bytes > 0);
+            CHECK(stats[0].tokens_bytes > 0);
+        }
+
+        WHEN("idle players retire") {
+            app.Tick(std::chrono::milliseconds{1500});
+
+            THEN("their dogs and tokens are no longer counted") {
+                const application::MapStats stats = app.GetMapStats().at(0);
+                CHECK(stats.sessions == 1);
+                CHECK(stats.dogs == 0);
+                CHECK(stats.tokens == 0);
+                CHECK(records.GetSize() == 2);
+            }
+        }
+    }
+
+    GIVEN("a game session") {
+        auto map = std::make_shared<model::Map>(model::Map::Id{"map1"s}, "Map 1"s, 1.0, false, 1, 3);
+        map->AddRoad(std::make_shared<model::Road>(model::Road::HORIZONTAL, model::Point{0, 0}, 10));
+        const model::Game game = MakeGame();
+        {
+            model::GameSession session{map, game.GetSharedLootTypes()};
+            session.CreateDog("Rex"s);
+            CHECK(map->GetCounters().sessions == 1);
+            CHECK(map->GetCounters().dogs == 1);
+            CHECK(map->GetCounters().lost_objects == 1);
+        }
+
+        THEN("its dogs and loot are subtracted when it is destroyed") {
+            CHECK(map->GetCounters().sessions == 0);
+            CHECK(map->GetCounters().dogs == 0);
+            CHECK(map->GetCounters().lost_objects == 0);
+        }
+    }
+}
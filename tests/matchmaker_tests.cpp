@@ -0,0 +1,198 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/json.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/model.h"
+
+using namespace std::literals;
+namespace json = boost::json;
+
+namespace {
+
+constexpr size_t MAX_PLAYERS = 3;
+
+struct Fixture {
+    Fixture() {
+        map->AddRoad(std::make_shared<model::Road>(model::Road::HORIZONTAL, model::Point{0, 0}, 10));
+        loot_types->AddLootTypes("map1"s, json::array{json::object{
+            {"name"s, "key"s}, {"file"s, "assets/key.obj"s}, {"type"s, "obj"s}, {"scale"s, 0.03}, {"value"s, 10}
+        }});
+    }
+
+    std::shared_ptr<model::GameSession> MakeSession(size_t dogs) {
+        auto session = std::make_shared<model::GameSession>(map, loot_types);
+        Join(*session, dogs);
+        return session;
+    }
+
+    void Join(model::GameSession& session, size_t dogs) {
+        for (size_t i = 0; i < dogs; ++i) {
+            session.CreateDog("Dog"s + std::to_string(next_dog_++));
+        }
+    }
+
+    // Оставляет в сессии keep собак, остальные уходят по неактивности
+    static void Retire(model::GameSession& session, size_t keep) {
+        for (size_t i = 0; i < session.GetDogs().size(); ++i) {
+            session.GetDogs()[i]->SetDogSpeed(i < keep ? model::Speed{1.0, 0.0} : model::Speed{0.0, 0.0});
+        }
+        session.RemoveInactiveDogs(std::chrono::milliseconds{0});
+    }
+
+    std::shared_ptr<model::Map> map = std::make_shared<model::Map>(model::Map::Id{"map1"s}, "Map 1"s, 1.0, false, 1, 3, MAX_PLAYERS);
+    std::shared_ptr<extra_data::LootTypes> loot_types = std::make_shared<extra_data::LootTypes>();
+
+private:
+    size_t next_dog_ = 0;
+};
+
+bool AllIndexed(const model::SessionMatchmaker& matchmaker, const std::vector<std::shared_ptr<model::GameSession>>& sessions) {
+    for (const auto& session : sessions) {
+        if (!matchmaker.Contains(*session)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+SCENARIO("Session matchmaking") {
+    Fixture fixture;
+    const model::Map::Id map_id{"map1"s};
+
+    GIVEN("a game with fill-first policy") {
+        model::Game game{model::LootGeneratorConfig{1000, 0.0}, std::chrono::milliseconds{1000}, model::MatchmakingPolicy::FILL_FIRST};
+        CHECK(game.FindSession(map_id) == nullptr);
+
+        auto first = fixture.MakeSession(2);
+        auto second = fixture.MakeSession(1);
+        game.AddSession(map_id, first);
+        game.AddSession(map_id, second);
+
+        THEN("the fullest session with a free slot is chosen") {
+            CHECK(game.FindSession(map_id) == first);
+        }
+
+        WHEN("the fullest session becomes full") {
+            fixture.Join(*first, 1);
+            game.UpdateSessionOccupancy(first);
+
+            THEN("it leaves the index") {
+                CHECK(game.FindSession(map_id) == second);
+
+                AND_WHEN("its players retire") {
+                    Fixture::Retire(*first, 0);
+                    game.UpdateSessionOccupancy(first);
+
+                    THEN("the session with more players is still preferred") {
+                        CHECK(game.FindSession(map_id) == second);
+                    }
+
+                    AND_WHEN("players rejoin the empty session") {
+                        fixture.Join(*first, 2);
+                        game.UpdateSessionOccupancy(first);
+
+                        THEN("it is chosen again") {
+                            CHECK(game.FindSession(map_id) == first);
+                        }
+                    }
+                }
+            }
+        }
+
+        WHEN("all sessions are full") {
+            fixture.Join(*first, 1);
+            fixture.Join(*second, 2);
+            game.UpdateSessionOccupancy(first);
+            game.UpdateSessionOccupancy(second);
+
+            THEN("no session is found") {
+                CHECK(game.FindSession(map_id) == nullptr);
+            }
+        }
+    }
+
+    GIVEN("a game with balance policy") {
+        model::Game game{model::LootGeneratorConfig{1000, 0.0}, std::chrono::milliseconds{1000}, model::MatchmakingPolicy::BALANCE};
+
+        auto first = fixture.MakeSession(2);
+        auto second = fixture.MakeSession(1);
+        game.AddSession(map_id, first);
+        game.AddSession(map_id, second);
+
+        THEN("the emptiest session is chosen") {
+            CHECK(game.FindSession(map_id) == second);
+        }
+
+        WHEN("the emptiest session fills up") {
+            fixture.Join(*second, 2);
+            game.UpdateSessionOccupancy(second);
+
+            THEN("the other one is chosen") {
+                CHECK(game.FindSession(map_id) == first);
+
+                AND_WHEN("players of the full session retire and one rejoins") {
+                    Fixture::Retire(*second, 0);
+                    game.UpdateSessionOccupancy(second);
+                    CHECK(game.FindSession(map_id) == second);
+                    fixture.Join(*second, 1);
+                    game.UpdateSessionOccupancy(second);
+
+                    THEN("it is chosen as the least filled one") {
+                        CHECK(game.FindSession(map_id) == second);
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("several sessions in the same fill group") {
+        for (const auto policy : {model::MatchmakingPolicy::FILL_FIRST, model::MatchmakingPolicy::BALANCE}) {
+            model::SessionMatchmaker matchmaker{policy};
+            std::vector<std::shared_ptr<model::GameSession>> sessions;
+            for (int i = 0; i < 4; ++i) {
+                sessions.push_back(fixture.MakeSession(1));
+                matchmaker.Update(sessions.back());
+            }
+            REQUIRE(AllIndexed(matchmaker, sessions));
+            // Группа [0, 1, 2, 3], выбирается последняя добавленная
+            CHECK(matchmaker.Find() == sessions[3]);
+
+            // Из середины группы: на место сессии 1 переезжает сессия 3
+            fixture.Join(*sessions[1], 1);
+            matchmaker.Update(sessions[1]);
+            CHECK(AllIndexed(matchmaker, sessions));
+            CHECK(matchmaker.Find() == (policy == model::MatchmakingPolicy::FILL_FIRST ? sessions[1] : sessions[2]));
+
+            // Сессия 3 удаляется уже со своей новой позиции
+            Fixture::Retire(*sessions[3], 0);
+            matchmaker.Update(sessions[3]);
+            CHECK(AllIndexed(matchmaker, sessions));
+            CHECK(matchmaker.Find() == (policy == model::MatchmakingPolicy::FILL_FIRST ? sessions[1] : sessions[3]));
+
+            // Заполненная сессия исчезает из индекса, остальные не сдвигаются
+            fixture.Join(*sessions[1], 1);
+            matchmaker.Update(sessions[1]);
+            CHECK_FALSE(matchmaker.Contains(*sessions[1]));
+            CHECK(matchmaker.Contains(*sessions[0]));
+            CHECK(matchmaker.Contains(*sessions[2]));
+            CHECK(matchmaker.Contains(*sessions[3]));
+            CHECK(matchmaker.Find() == (policy == model::MatchmakingPolicy::FILL_FIRST ? sessions[2] : sessions[3]));
+
+            // Возвращение игроков в опустевшую сессию
+            fixture.Join(*sessions[3], 2);
+            matchmaker.Update(sessions[3]);
+            CHECK(matchmaker.Contains(*sessions[3]));
+            CHECK(matchmaker.Find() == (policy == model::MatchmakingPolicy::FILL_FIRST ? sessions[3] : sessions[2]));
+
+            for (const auto& session : {sessions[0], sessions[2], sessions[3]}) {
+                matchmaker.Remove(*session);
+                CHECK_FALSE(matchmaker.Contains(*session));
+            }
+            CHECK(matchmaker.Find() == nullptr);
+        }
+    }
+}
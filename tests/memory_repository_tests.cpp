@@ -0,0 +1,81 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/database/memory/memory.h"
+
+using namespace std::literals;
+
+namespace {
+
+std::vector<std::string> GetNames(const std::vector<domain::Player>& players) {
+    std::vector<std::string> names;
+    for (const domain::Player& player : players) {
+        names.push_back(player.GetName());
+    }
+    return names;
+}
+
+}  // namespace
+
+SCENARIO("In-memory player repository") {
+    GIVEN("a repository with retired players") {
+        memory::PlayerRepositoryImpl repository;
+        repository.RetirePlayer(domain::Player{"Bob"s, 10, 5.0});
+        repository.RetirePlayer(domain::Player{"Alice"s, 30, 7.5});
+        repository.RetirePlayer(domain::Player{"Carol"s, 10, 2.0});
+        repository.RetirePlayer(domain::Player{"Ann"s, 10, 5.0});
+
+        THEN("records are ordered by score, then by play time and name") {
+            CHECK(GetNames(repository.GetRecordsTable(0, 100)) == std::vector{"Alice"s, "Carol"s, "Ann"s, "Bob"s});
+        }
+
+        THEN("records table is paged by offset and limit") {
+            CHECK(GetNames(repository.GetRecordsTable(1, 2)) == std::vector{"Carol"s, "Ann"s});
+            CHECK(GetNames(repository.GetRecordsTable(3, 100)) == std::vector{"Bob"s});
+            CHECK(repository.GetRecordsTable(4, 100).empty());
+        }
+    }
+
+    GIVEN("a repository backed by a file") {
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "memory_repository_tests.records";
+        std::filesystem::remove(path);
+        {
+            memory::PlayerRepositoryImpl repository{path};
+            repository.RetirePlayer(domain::Player{"Rex"s, 20, 61.25});
+            repository.RetirePlayer(domain::Player{"Tab\tNew\nLine\\"s, 40, 0.1});
+        }
+
+        WHEN("the repository is opened again") {
+            memory::PlayerRepositoryImpl repository{path};
+
+            THEN("records are restored exactly") {
+                const std::vector<domain::Player> records = repository.GetRecordsTable(0, 100);
+                REQUIRE(records.size() == 2);
+                CHECK(records[0].GetName() == "Tab\tNew\nLine\\"s);
+                CHECK(records[0].GetScore() == 40);
+                CHECK(records[0].GetPlayTime() == 0.1);
+                CHECK(records[1].GetName() == "Rex"s);
+                CHECK(records[1].GetPlayTime() == 61.25);
+            }
+        }
+
+        WHEN("the last record was not written completely") {
+            std::ofstream{path, std::ios::binary | std::ios::app} << "15\t3.5\tTor";
+            {
+                memory::PlayerRepositoryImpl repository{path};
+                CHECK(repository.GetSize() == 2);
+                repository.RetirePlayer(domain::Player{"Max"s, 5, 1.0});
+            }
+
+            THEN("it is dropped and new records are appended after complete ones") {
+                memory::PlayerRepositoryImpl repository{path};
+                CHECK(GetNames(repository.GetRecordsTable(0, 100)) == std::vector{"Tab\tNew\nLine\\"s, "Rex"s, "Max"s});
+            }
+        }
+
+        std::filesystem::remove(path);
+    }
+}
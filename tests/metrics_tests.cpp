@@ -0,0 +1,88 @@
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/metrics.h"
+
+using namespace std::literals;
+
+SCENARIO("Metrics") {
+    metrics::Enable();
+
+    GIVEN("observations made in several threads") {
+        const metrics::Snapshot before = metrics::Collect();
+
+        constexpr int thread_count = 4;
+        constexpr int observations = 1000;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < thread_count; ++i) {
+            threads.emplace_back([] {
+                for (int j = 0; j < observations; ++j) {
+                    metrics::Observe(metrics::Histogram::STATE_SAVE, 3ms);
+                    metrics::Increment(metrics::Counter::TICKS);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        WHEN("metrics are collected") {
+            const metrics::Snapshot after = metrics::Collect();
+            const metrics::HistogramSnapshot& save_before = before.Get(metrics::Histogram::STATE_SAVE);
+            const metrics::HistogramSnapshot& save_after = after.Get(metrics::Histogram::STATE_SAVE);
+
+            THEN("values of all threads are summed up") {
+                CHECK(after.Get(metrics::Counter::TICKS) - before.Get(metrics::Counter::TICKS) == thread_count * observations);
+                CHECK(save_after.count - save_before.count == thread_count * observations);
+                CHECK(save_after.sum - save_before.sum == thread_count * observations * 3ms);
+            }
+
+            THEN("observations fall into the bucket with the nearest upper bound") {
+                // 3ms попадает в корзину le="0.005"
+                CHECK(save_after.buckets[6] - save_before.buckets[6] == thread_count * observations);
+            }
+        }
+    }
+
+    GIVEN("a snapshot with a single observation") {
+        metrics::Snapshot snapshot;
+        metrics::HistogramSnapshot& tick = snapshot.histograms[static_cast<size_t>(metrics::Histogram::TICK_DURATION)];
+        tick.buckets[1] = 1;
+        tick.count = 1;
+        tick.sum = 75us;
+
+        WHEN("it is written in the Prometheus text format") {
+            std::ostringstream os;
+            metrics::WriteText(os, snapshot);
+            const std::string text = os.str();
+
+            THEN("histogram buckets are cumulative") {
+                CHECK(text.find("game_tick_duration_seconds_bucket{le=\"0.00005\"} 0\n"s) != std::string::npos);
+                CHECK(text.find("game_tick_duration_seconds_bucket{le=\"0.0001\"} 1\n"s) != std::string::npos);
+                CHECK(text.find("game_tick_duration_seconds_bucket{le=\"+Inf\"} 1\n"s) != std::string::npos);
+                CHECK(text.find("game_tick_duration_seconds_sum 0.000075000\n"s) != std::string::npos);
+                CHECK(text.find("game_tick_duration_seconds_count 1\n"s) != std::string::npos);
+            }
+
+            THEN("labelled histograms of one family share a single header") {
+                constexpr std::string_view header = "# TYPE game_http_request_duration_seconds histogram\n"sv;
+                const size_t first = text.find(header);
+                REQUIRE(first != std::string::npos);
+                CHECK(text.find(header, first + 1) == std::string::npos);
+                CHECK(text.find("game_http_request_duration_seconds_count{route=\"state\"} 0\n"s) != std::string::npos);
+            }
+        }
+    }
+
+    GIVEN("a label value with special characters") {
+        std::ostringstream os;
+        metrics::WriteSample(os, "game_dogs"sv, 3, "map"sv, "a\"b\\c"sv);
+
+        THEN("it is escaped") {
+            CHECK(os.str() == "game_dogs{map=\"a\\\"b\\\\c\"} 3\n"s);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#include <sstream>
+#include <string>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/profiler.h"
+
+using namespace std::literals;
+
+namespace {
+
+size_t CountOccurrences(const std::string& text, std::string_view pattern) {
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + pattern.size())) {
+        ++count;
+    }
+    return count;
+}
+
+}  // namespace
+
+SCENARIO("Profiler") {
+    profiler::Enable(4);
+
+    GIVEN("a thread that recorded more intervals than its buffer holds") {
+        // Буфер создаётся при первой записи, поэтому поток новый
+        std::thread{[] {
+            const profiler::Clock::time_point start = profiler::Clock::now();
+            profiler::Record("test.evicted", start, start + 1us);
+            profiler::Record("test.evicted", start + 1us, start + 2us);
+            for (int i = 0; i < 3; ++i) {
+                profiler::Record("test.kept", start + 2us, start + 3500ns);
+            }
+            {
+                profiler::Zone zone{"test.zone"};
+            }
+        }}.join();
+
+        WHEN("the trace is written") {
+            std::ostringstream os;
+            profiler::WriteChromeTrace(os);
+            const std::string trace = os.str();
+
+            THEN("only the latest intervals are exported as complete events") {
+                CHECK(trace.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["sv));
+                CHECK(CountOccurrences(trace, "\"name\":\"test.evicted\""sv) == 0);
+                CHECK(CountOccurrences(trace, "\"name\":\"test.kept\""sv) == 3);
+                CHECK(CountOccurrences(trace, "\"name\":\"test.zone\""sv) == 1);
+                CHECK(trace.find("\"dur\":1.500}"sv) != std::string::npos);
+                CHECK(trace.ends_with("\n]}\n"sv));
+            }
+        }
+    }
+}
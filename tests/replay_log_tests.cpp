@@ -0,0 +1,69 @@
+#include <filesystem>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/replay_log.h"
+
+using namespace std::literals;
+
+SCENARIO("Replay log") {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "replay_log_tests.replay";
+
+    GIVEN("a log with every kind of event") {
+        replay::Header header;
+        header.random_seed = 0xfedcba9876543210ull;
+        header.fixed_time_step = 25ms;
+        header.randomize_spawn_points = true;
+        {
+            replay::ReplayWriter writer{path, header, 2};
+            writer.RecordJoin(0, "Rex"sv, "map1"sv);
+            writer.RecordMove(0, "L"sv);
+            writer.RecordTick(25ms);
+            CHECK_FALSE(writer.IsStateHashDue());
+            writer.RecordMove(0, ""sv);
+            writer.RecordTick(300000ms);
+            CHECK(writer.IsStateHashDue());
+            writer.RecordStateHash(0x8000000000000001ull);
+        }
+
+        WHEN("it is read back") {
+            replay::ReplayReader reader{path};
+
+            THEN("the header and the events are restored in order") {
+                CHECK(reader.GetHeader().random_seed == header.random_seed);
+                CHECK(reader.GetHeader().fixed_time_step == header.fixed_time_step);
+                CHECK(reader.GetHeader().randomize_spawn_points);
+
+                auto join = reader.Next();
+                REQUIRE(join);
+                REQUIRE(std::holds_alternative<replay::JoinEvent>(*join));
+                CHECK(std::get<replay::JoinEvent>(*join).player_name == "Rex"s);
+                CHECK(std::get<replay::JoinEvent>(*join).map_id == "map1"s);
+
+                auto move = reader.Next();
+                REQUIRE(move);
+                CHECK(std::get<replay::MoveEvent>(*move).direction == "L"s);
+
+                auto tick = reader.Next();
+                REQUIRE(tick);
+                CHECK(std::get<replay::TickEvent>(*tick).time_delta == 25ms);
+
+                auto stop = reader.Next();
+                REQUIRE(stop);
+                CHECK(std::get<replay::MoveEvent>(*stop).direction.empty());
+
+                auto long_tick = reader.Next();
+                REQUIRE(long_tick);
+                CHECK(std::get<replay::TickEvent>(*long_tick).time_delta == 300000ms);
+
+                auto hash = reader.Next();
+                REQUIRE(hash);
+                CHECK(std::get<replay::StateHashEvent>(*hash).hash == 0x8000000000000001ull);
+
+                CHECK_FALSE(reader.Next());
+            }
+        }
+    }
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,122 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/static_file_cache.h"
+
+using namespace std::literals;
+namespace fs = std::filesystem;
+using http_handler::AcceptsEncoding;
+using http_handler::MatchesIfNoneMatch;
+
+TEST_CASE("Accept-Encoding negotiation") {
+    SECTION("listed codings are accepted regardless of case and spaces") {
+        CHECK(AcceptsEncoding("gzip"sv, "gzip"sv));
+        CHECK(AcceptsEncoding("deflate, GZip , br"sv, "gzip"sv));
+        CHECK(AcceptsEncoding("gzip, BR"sv, "br"sv));
+        CHECK_FALSE(AcceptsEncoding("gzip, deflate"sv, "br"sv));
+        CHECK_FALSE(AcceptsEncoding(""sv, "gzip"sv));
+        CHECK_FALSE(AcceptsEncoding("gzipped"sv, "gzip"sv));
+    }
+
+    SECTION("zero quality excludes a coding") {
+        CHECK(AcceptsEncoding("gzip;q=0.5"sv, "gzip"sv));
+        CHECK(AcceptsEncoding("gzip; q=1"sv, "gzip"sv));
+        CHECK_FALSE(AcceptsEncoding("gzip;q=0"sv, "gzip"sv));
+        CHECK_FALSE(AcceptsEncoding("gzip; Q=0.000"sv, "gzip"sv));
+        CHECK_FALSE(AcceptsEncoding("br, gzip;q=0"sv, "gzip"sv));
+    }
+
+    SECTION("wildcard accepts codings that are not listed explicitly") {
+        CHECK(AcceptsEncoding("*"sv, "br"sv));
+        CHECK(AcceptsEncoding("gzip, *;q=0.1"sv, "br"sv));
+        CHECK_FALSE(AcceptsEncoding("*;q=0"sv, "br"sv));
+        CHECK_FALSE(AcceptsEncoding("gzip;q=0, *"sv, "gzip"sv));
+        CHECK_FALSE(AcceptsEncoding("*, gzip;q=0"sv, "gzip"sv));
+        CHECK(AcceptsEncoding("*;q=0, gzip"sv, "gzip"sv));
+    }
+}
+
+TEST_CASE("If-None-Match comparison") {
+    constexpr std::string_view etag = R"("abc-10")"sv;
+
+    CHECK(MatchesIfNoneMatch(R"("abc-10")"sv, etag));
+    CHECK(MatchesIfNoneMatch("*"sv, etag));
+    CHECK(MatchesIfNoneMatch(R"("old-1", "abc-10")"sv, etag));
+    CHECK(MatchesIfNoneMatch(R"("old-1",W/"abc-10")"sv, etag));
+    CHECK(MatchesIfNoneMatch(R"(W/"abc-10")"sv, etag));
+    CHECK_FALSE(MatchesIfNoneMatch(""sv, etag));
+    CHECK_FALSE(MatchesIfNoneMatch(R"("old-1", "abc-11")"sv, etag));
+    CHECK_FALSE(MatchesIfNoneMatch("abc-10"sv, etag));
+}
+
+TEST_CASE("Static file cache rebuild") {
+    const fs::path root = fs::temp_directory_path() / "game_server_static_cache_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "js");
+    auto write = [](const fs::path& path, std::string_view data) {
+        std::ofstream{path, std::ios::binary} << data;
+    };
+    write(root / "index.html", "<html></html>"sv);
+    write(root / "js" / "game.js", "let x = 1;"sv);
+
+    http_handler::StaticFileCache cache{root};
+    cache.Build();
+    REQUIRE(cache.Size() == 2);
+    REQUIRE(cache.Find("js/game.js"s));
+
+    fs::remove_all(root / "js");
+    write(root / "style.css", "body {}"sv);
+    write(root / "index.html", "<html><body></body></html>"sv);
+    cache.Rebuild();
+
+    CHECK(cache.Size() == 2);
+    CHECK_FALSE(cache.Find("js/game.js"s));
+    REQUIRE(cache.Find("style.css"s));
+    CHECK(*cache.Find("index.html"s)->identity == "<html><body></body></html>"s);
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("Static file cache follows directory moves and deletions") {
+    const fs::path root = fs::temp_directory_path() / "game_server_static_watch_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "assets" / "models");
+    std::ofstream{root / "assets" / "models" / "dog.obj", std::ios::binary} << "v 0 0 0"sv;
+    std::ofstream{root / "assets" / "key.txt", std::ios::binary} << "key"sv;
+
+    http_handler::StaticFileCache cache{root};
+    cache.Build();
+    cache.StartWatching();
+    REQUIRE(cache.Size() == 2);
+
+    // События inotify обрабатываются в отдельном потоке
+    auto wait_for = [&cache](auto&& condition) {
+        for (int i = 0; i < 500 && !condition(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+        return condition();
+    };
+
+    fs::rename(root / "assets", root / "moved");
+    CHECK(wait_for([&cache] {
+        return !cache.Find("assets/key.txt"s) && cache.Find("moved/models/dog.obj"s);
+    }));
+    CHECK(cache.Size() == 2);
+
+    // Вложенный каталог после переноса наблюдается по новому пути
+    std::ofstream{root / "moved" / "models" / "cat.obj", std::ios::binary} << "v 1 1 1"sv;
+    CHECK(wait_for([&cache] {
+        return cache.Find("moved/models/cat.obj"s) != nullptr;
+    }));
+
+    fs::remove_all(root / "moved");
+    CHECK(wait_for([&cache] {
+        return cache.Size() == 0;
+    }));
+
+    fs::remove_all(root);
+}
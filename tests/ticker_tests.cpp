@@ -0,0 +1,95 @@
+#include <chrono>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/ticker.h"
+
+using namespace std::literals;
+using ticker::CatchUpPolicy;
+using ticker::PlanCatchUp;
+
+namespace {
+
+constexpr std::chrono::milliseconds PERIOD = 50ms;
+constexpr unsigned MAX_SUBSTEPS = 3;
+
+// Запланированное срабатывание, от которого отсчитываются опоздания
+const std::chrono::steady_clock::time_point DEADLINE{1000s};
+
+}  // namespace
+
+TEST_CASE("Ticker on schedule runs one period") {
+    for (const auto policy : {CatchUpPolicy::SKIP, CatchUpPolicy::MERGE, CatchUpPolicy::SUBSTEPS}) {
+        // Опоздание меньше периода не считается пропуском
+        for (const auto now : {DEADLINE, DEADLINE + 1ms, DEADLINE + PERIOD - 1ms}) {
+            const auto plan = PlanCatchUp(policy, PERIOD, MAX_SUBSTEPS, DEADLINE, now);
+            CHECK(plan.handler_calls == 1);
+            CHECK(plan.delta == PERIOD);
+            CHECK(plan.late_periods == 0);
+            CHECK(plan.dropped_periods == 0);
+            CHECK(plan.next_deadline == DEADLINE + PERIOD);
+        }
+    }
+
+    SECTION("early timer does not move the schedule back") {
+        const auto plan = PlanCatchUp(CatchUpPolicy::MERGE, PERIOD, MAX_SUBSTEPS, DEADLINE, DEADLINE - 1ms);
+        CHECK(plan.late_periods == 0);
+        CHECK(plan.next_deadline == DEADLINE + PERIOD);
+    }
+}
+
+TEST_CASE("Ticker late by several periods") {
+    // Опоздание на 2 полных периода: наступили запланированный и ещё два
+    const auto now = DEADLINE + 2 * PERIOD + 10ms;
+
+    SECTION("skip drops missed periods") {
+        const auto plan = PlanCatchUp(CatchUpPolicy::SKIP, PERIOD, MAX_SUBSTEPS, DEADLINE, now);
+        CHECK(plan.handler_calls == 1);
+        CHECK(plan.delta == PERIOD);
+        CHECK(plan.late_periods == 2);
+        CHECK(plan.dropped_periods == 2);
+        CHECK(plan.next_deadline == DEADLINE + 3 * PERIOD);
+    }
+
+    SECTION("merge passes missed time in one call") {
+        const auto plan = PlanCatchUp(CatchUpPolicy::MERGE, PERIOD, MAX_SUBSTEPS, DEADLINE, now);
+        CHECK(plan.handler_calls == 1);
+        CHECK(plan.delta == 3 * PERIOD);
+        CHECK(plan.late_periods == 2);
+        CHECK(plan.dropped_periods == 0);
+        CHECK(plan.next_deadline == DEADLINE + 3 * PERIOD);
+    }
+
+    SECTION("substeps run a call per period within the cap") {
+        const auto plan = PlanCatchUp(CatchUpPolicy::SUBSTEPS, PERIOD, MAX_SUBSTEPS, DEADLINE, now);
+        CHECK(plan.handler_calls == 3);
+        CHECK(plan.delta == PERIOD);
+        CHECK(plan.late_periods == 2);
+        CHECK(plan.dropped_periods == 0);
+        CHECK(plan.next_deadline == DEADLINE + 3 * PERIOD);
+    }
+}
+
+TEST_CASE("Ticker substeps are capped") {
+    // Опоздание на 9 периодов: наступило 10, выполняется только MAX_SUBSTEPS
+    const auto now = DEADLINE + 9 * PERIOD;
+    const auto plan = PlanCatchUp(CatchUpPolicy::SUBSTEPS, PERIOD, MAX_SUBSTEPS, DEADLINE, now);
+    CHECK(plan.handler_calls == MAX_SUBSTEPS);
+    CHECK(plan.delta == PERIOD);
+    CHECK(plan.late_periods == 9);
+    CHECK(plan.dropped_periods == 10 - MAX_SUBSTEPS);
+    // Расписание не догоняет пропущенное: следующее срабатывание после текущего момента
+    CHECK(plan.next_deadline == DEADLINE + 10 * PERIOD);
+
+    SECTION("zero cap still runs one step") {
+        const auto zero_cap = PlanCatchUp(CatchUpPolicy::SUBSTEPS, PERIOD, 0, DEADLINE, now);
+        CHECK(zero_cap.handler_calls == 1);
+        CHECK(zero_cap.dropped_periods == 9);
+    }
+}
+
+TEST_CASE("Ticker catch-up policy names") {
+    CHECK(ticker::ParseCatchUpPolicy("skip"sv) == CatchUpPolicy::SKIP);
+    CHECK(ticker::ParseCatchUpPolicy("merge"sv) == CatchUpPolicy::MERGE);
+    CHECK(ticker::ParseCatchUpPolicy("substeps"sv) == CatchUpPolicy::SUBSTEPS);
+    CHECK_THROWS_AS(ticker::ParseCatchUpPolicy("catch-up"sv), std::invalid_argument);
+}
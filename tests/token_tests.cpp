@@ -0,0 +1,83 @@
+#include <map>
+#include <random>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/token.h"
+
+using namespace std::literals;
+
+SCENARIO("Player token") {
+    using application::Token;
+
+    GIVEN("a token") {
+        Token token{0x0123456789abcdefull, 0xfedcba9876543210ull};
+
+        THEN("it is encoded as 32 lowercase hex digits") {
+            CHECK(token.ToHex() == "0123456789abcdeffedcba9876543210"s);
+        }
+
+        THEN("it is decoded back from its hex representation") {
+            CHECK(Token::FromHex(token.ToHex()) == token);
+        }
+    }
+
+    WHEN("hex string has invalid format") {
+        THEN("token is not parsed") {
+            CHECK_FALSE(Token::FromHex(""sv));
+            CHECK_FALSE(Token::FromHex("0123456789abcdeffedcba987654321"sv));
+            CHECK_FALSE(Token::FromHex("0123456789abcdeffedcba98765432100"sv));
+            CHECK_FALSE(Token::FromHex("0123456789abcdeffedcba987654321g"sv));
+            CHECK_FALSE(Token::FromHex("0123456789ABCDEFfedcba9876543210"sv));
+        }
+    }
+}
+
+SCENARIO("Token map") {
+    using application::Token;
+    using application::TokenMap;
+
+    GIVEN("a token map filled with random tokens") {
+        std::mt19937_64 generator{42};
+        TokenMap<int> token_map;
+        std::map<Token, int> expected;
+        for (int i = 0; i < 1000; ++i) {
+            Token token{generator(), generator()};
+            token_map.InsertOrAssign(token, i);
+            expected[token] = i;
+        }
+
+        THEN("every token is found") {
+            REQUIRE(token_map.Size() == expected.size());
+            for (const auto& [token, value] : expected) {
+                const int* found = token_map.Find(token);
+                REQUIRE(found);
+                CHECK(*found == value);
+            }
+            CHECK_FALSE(token_map.Find(Token{generator(), generator()}));
+        }
+
+        WHEN("part of tokens is erased") {
+            int index = 0;
+            for (auto it = expected.begin(); it != expected.end();) {
+                if (index++ % 3 == 0) {
+                    REQUIRE(token_map.Erase(it->first));
+                    it = expected.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            THEN("only remaining tokens are found") {
+                REQUIRE(token_map.Size() == expected.size());
+                size_t visited = 0;
+                token_map.ForEach([&](const Token& token, int value) {
+                    ++visited;
+                    REQUIRE(expected.count(token));
+                    CHECK(expected.at(token) == value);
+                });
+                CHECK(visited == expected.size());
+            }
+        }
+    }
+}
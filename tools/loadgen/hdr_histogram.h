@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace loadgen {
+
+/**
+ * Гистограмма задержек в духе HdrHistogram.
+ * Диапазон значений разбит на интервалы [2^k, 2^(k+1)), каждый интервал - на одинаковые поддиапазоны,
+ * поэтому относительная погрешность хранимого значения не превышает 2^-(SUB_BUCKET_BITS - 1)
+ * при постоянной стоимости записи и фиксированной памяти.
+ */
+class HdrHistogram {
+public:
+    // 1024 поддиапазона - погрешность около 0.1%
+    constexpr static int SUB_BUCKET_BITS = 10;
+    // Значения не больше 2^36 мкс (~19 часов), большие значения записываются как максимальное
+    constexpr static int MAX_VALUE_BITS = 36;
+    constexpr static uint64_t MAX_VALUE = (uint64_t{1} << MAX_VALUE_BITS) - 1;
+
+    HdrHistogram()
+    : counts_(CountsSize(), 0)
+    {
+
+    }
+
+    void Record(uint64_t value) {
+        value = std::min(value, MAX_VALUE);
+        ++counts_[GetIndex(value)];
+        ++total_count_;
+        sum_ += value;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void Merge(const HdrHistogram& other) {
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_count_ += other.total_count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void Reset() {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        total_count_ = 0;
+        sum_ = 0;
+        min_ = MAX_VALUE;
+        max_ = 0;
+    }
+
+    uint64_t GetCount() const noexcept {
+        return total_count_;
+    }
+
+    uint64_t GetMax() const noexcept {
+        return max_;
+    }
+
+    uint64_t GetMin() const noexcept {
+        return total_count_ ? min_ : 0;
+    }
+
+    double GetMean() const noexcept {
+        return total_count_ ? static_cast<double>(sum_) / static_cast<double>(total_count_) : 0.;
+    }
+
+    // Наименьшее значение, не меньше которого percentile процентов записанных значений (с точностью гистограммы)
+    uint64_t GetValueAtPercentile(double percentile) const {
+        if (total_count_ == 0) {
+            return 0;
+        }
+        const double fraction = std::clamp(percentile, 0., 100.) / 100.;
+        const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * static_cast<double>(total_count_) + 0.5));
+        uint64_t accumulated = 0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            accumulated += counts_[i];
+            if (accumulated >= target) {
+                return std::min(GetHighestEquivalentValue(i), max_);
+            }
+        }
+        return max_;
+    }
+
+private:
+    constexpr static uint64_t SUB_BUCKET_COUNT = uint64_t{1} << SUB_BUCKET_BITS;
+    constexpr static uint64_t SUB_BUCKET_HALF_COUNT = SUB_BUCKET_COUNT / 2;
+    constexpr static int BUCKET_COUNT = MAX_VALUE_BITS - SUB_BUCKET_BITS + 1;
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = MAX_VALUE;
+    uint64_t max_ = 0;
+
+    static size_t CountsSize() {
+        return static_cast<size_t>(BUCKET_COUNT + 1) * SUB_BUCKET_HALF_COUNT;
+    }
+
+    // Номер интервала: значения меньше SUB_BUCKET_COUNT попадают в нулевой интервал с шагом 1
+    static int GetBucketIndex(uint64_t value) {
+        return std::max(0, static_cast<int>(std::bit_width(value)) - SUB_BUCKET_BITS);
+    }
+
+    static size_t GetIndex(uint64_t value) {
+        const int bucket_index = GetBucketIndex(value);
+        const uint64_t sub_bucket_index = value >> bucket_index;
+        // Нижняя половина поддиапазонов каждого интервала, кроме нулевого, совпадает с предыдущим интервалом
+        return static_cast<size_t>(((static_cast<uint64_t>(bucket_index) + 1) << (SUB_BUCKET_BITS - 1))
+            + sub_bucket_index - SUB_BUCKET_HALF_COUNT);
+    }
+
+    static uint64_t GetHighestEquivalentValue(size_t index) {
+        int bucket_index = static_cast<int>(index >> (SUB_BUCKET_BITS - 1)) - 1;
+        uint64_t sub_bucket_index = (index & (SUB_BUCKET_HALF_COUNT - 1)) + SUB_BUCKET_HALF_COUNT;
+        if (bucket_index < 0) {
+            sub_bucket_index -= SUB_BUCKET_HALF_COUNT;
+            bucket_index = 0;
+        }
+        return (sub_bucket_index << bucket_index) + (uint64_t{1} << bucket_index) - 1;
+    }
+};
+
+}  // namespace loadgen
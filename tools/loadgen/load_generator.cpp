@@ -0,0 +1,313 @@
+#include "load_generator.h"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/json.hpp>
+
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+namespace loadgen {
+
+using namespace std::literals;
+namespace json = boost::json;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Response = http::response<http::string_body>;
+
+constexpr std::array<std::string_view, 5> MOVES{"L"sv, "R"sv, "U"sv, "D"sv, ""sv};
+// Пауза перед переподключением бота после ошибки
+constexpr auto RECONNECT_DELAY = 500ms;
+
+http::request<http::string_body> MakeRequest(
+    http::verb method,
+    std::string_view target,
+    std::string_view host,
+    std::string_view token,
+    std::string body = {}
+) {
+    http::request<http::string_body> request{method, target, 11};
+    request.set(http::field::host, host);
+    request.keep_alive(true);
+    if (!token.empty()) {
+        request.set(http::field::authorization, "Bearer "s.append(token));
+    }
+    if (method == http::verb::post) {
+        request.set(http::field::content_type, "application/json"sv);
+        request.body() = std::move(body);
+    }
+    request.prepare_payload();
+    return request;
+}
+
+// Отправляет запрос и дожидается ответа, учитывая задержку в stats. Сетевые ошибки выбрасываются как исключения
+net::awaitable<Response> SendRequest(
+    beast::tcp_stream& stream,
+    beast::flat_buffer& buffer,
+    const http::request<http::string_body>& request,
+    Endpoint endpoint,
+    std::mutex& stats_mutex,
+    Stats& stats
+) {
+    const Clock::time_point start = Clock::now();
+    stream.expires_after(10s);
+    Response response;
+    try {
+        co_await http::async_write(stream, request, net::use_awaitable);
+        co_await http::async_read(stream, buffer, response, net::use_awaitable);
+    } catch (...) {
+        std::lock_guard lock{stats_mutex};
+        ++stats[static_cast<size_t>(endpoint)].errors;
+        throw;
+    }
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+
+    std::lock_guard lock{stats_mutex};
+    EndpointStats& endpoint_stats = stats[static_cast<size_t>(endpoint)];
+    if (response.result() == http::status::ok) {
+        endpoint_stats.latency.Record(static_cast<uint64_t>(latency.count()));
+    } else {
+        ++endpoint_stats.errors;
+    }
+    co_return response;
+}
+
+double ToMilliseconds(uint64_t microseconds) {
+    return static_cast<double>(microseconds) / 1000.;
+}
+
+}  // namespace
+
+std::string_view GetEndpointName(Endpoint endpoint) {
+    switch (endpoint) {
+        case Endpoint::MAPS:
+            return "maps"sv;
+        case Endpoint::JOIN:
+            return "join"sv;
+        case Endpoint::ACTION:
+            return "action"sv;
+        case Endpoint::STATE:
+            return "state"sv;
+    }
+    return "unknown"sv;
+}
+
+void PrintStats(std::ostream& out, const Stats& stats, std::chrono::duration<double> elapsed) {
+    out << std::left << std::setw(8) << "endpoint" << std::right
+        << std::setw(10) << "requests" << std::setw(10) << "req/s" << std::setw(8) << "errors"
+        << std::setw(9) << "p50 ms" << std::setw(9) << "p90 ms" << std::setw(9) << "p99 ms"
+        << std::setw(10) << "p99.9 ms" << std::setw(9) << "max ms" << '\n';
+    out << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < ENDPOINT_COUNT; ++i) {
+        const EndpointStats& endpoint_stats = stats[i];
+        const HdrHistogram& latency = endpoint_stats.latency;
+        if (latency.GetCount() == 0 && endpoint_stats.errors == 0) {
+            continue;
+        }
+        const double seconds = elapsed.count() > 0 ? elapsed.count() : 1.;
+        out << std::left << std::setw(8) << GetEndpointName(static_cast<Endpoint>(i)) << std::right
+            << std::setw(10) << latency.GetCount()
+            << std::setw(10) << static_cast<double>(latency.GetCount()) / seconds
+            << std::setw(8) << endpoint_stats.errors
+            << std::setw(9) << ToMilliseconds(latency.GetValueAtPercentile(50.))
+            << std::setw(9) << ToMilliseconds(latency.GetValueAtPercentile(90.))
+            << std::setw(9) << ToMilliseconds(latency.GetValueAtPercentile(99.))
+            << std::setw(10) << ToMilliseconds(latency.GetValueAtPercentile(99.9))
+            << std::setw(9) << ToMilliseconds(latency.GetMax()) << '\n';
+    }
+    out << std::defaultfloat << std::flush;
+}
+
+LoadGenerator::LoadGenerator(Config config)
+: config_{std::move(config)}
+{
+    if (config_.threads == 0) {
+        config_.threads = 1;
+    }
+    for (unsigned i = 0; i < config_.threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    tcp::resolver resolver{workers_.front()->ioc};
+    endpoints_ = resolver.resolve(config_.host, config_.port);
+    if (config_.map_id.empty()) {
+        LoadMapIds();
+    } else {
+        map_ids_.push_back(config_.map_id);
+    }
+}
+
+void LoadGenerator::LoadMapIds() {
+    Worker& worker = *workers_.front();
+    std::exception_ptr error;
+    net::co_spawn(worker.ioc, [this, &worker]() -> net::awaitable<void> {
+        beast::tcp_stream stream{co_await net::this_coro::executor};
+        co_await stream.async_connect(endpoints_, net::use_awaitable);
+        beast::flat_buffer buffer;
+        Response response = co_await SendRequest(
+            stream, buffer,
+            MakeRequest(http::verb::get, "/api/v1/maps"sv, config_.host, {}),
+            Endpoint::MAPS, worker.stats_mutex, worker.stats
+        );
+        for (const json::value& map : json::parse(response.body()).as_array()) {
+            map_ids_.emplace_back(map.at("id"sv).as_string());
+        }
+    }, [&error](std::exception_ptr e) {
+        error = e;
+    });
+    worker.ioc.run();
+    worker.ioc.restart();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (map_ids_.empty()) {
+        throw std::runtime_error("Server has no maps to join"s);
+    }
+}
+
+net::awaitable<void> LoadGenerator::RunBot(Worker& worker, size_t bot_index) {
+    auto executor = co_await net::this_coro::executor;
+    std::mt19937_64 random{std::random_device{}() ^ bot_index};
+    std::exponential_distribution<double> action_interval{config_.action_rate > 0 ? config_.action_rate : 1.};
+    std::exponential_distribution<double> state_interval{config_.state_rate > 0 ? config_.state_rate : 1.};
+    auto next_after = [&random](std::exponential_distribution<double>& interval, double rate) {
+        return rate > 0
+            ? Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{interval(random)})
+            : Clock::time_point::max();
+    };
+
+    net::steady_timer timer{executor};
+    // Подключения ботов растянуты на время разгона, чтобы не создавать всплеск join-запросов
+    timer.expires_after(config_.ramp_up * bot_index / std::max<size_t>(config_.bots, 1));
+    co_await timer.async_wait(net::use_awaitable);
+
+    const std::string& map_id = map_ids_[random() % map_ids_.size()];
+    const std::string join_body = json::serialize(json::object{
+        {"userName", "bot-" + std::to_string(bot_index)},
+        {"mapId", map_id}
+    });
+
+    while (Clock::now() < deadline_) {
+        try {
+            beast::tcp_stream stream{executor};
+            beast::flat_buffer buffer;
+            co_await stream.async_connect(endpoints_, net::use_awaitable);
+            stream.socket().set_option(tcp::no_delay{true});
+
+            Response join = co_await SendRequest(
+                stream, buffer,
+                MakeRequest(http::verb::post, "/api/v1/game/join"sv, config_.host, {}, join_body),
+                Endpoint::JOIN, worker.stats_mutex, worker.stats
+            );
+            if (join.result() != http::status::ok) {
+                throw std::runtime_error("join failed"s);
+            }
+            const std::string token{json::parse(join.body()).at("authToken"sv).as_string()};
+
+            Clock::time_point next_action = next_after(action_interval, config_.action_rate);
+            Clock::time_point next_state = next_after(state_interval, config_.state_rate);
+            while (true) {
+                const Clock::time_point next = std::min({next_action, next_state, deadline_});
+                if (next == deadline_) {
+                    timer.expires_at(deadline_);
+                    co_await timer.async_wait(net::use_awaitable);
+                    break;
+                }
+                timer.expires_at(next);
+                co_await timer.async_wait(net::use_awaitable);
+
+                if (next == next_action) {
+                    const std::string action_body = json::serialize(json::object{
+                        {"move", json::string{MOVES[random() % MOVES.size()]}}
+                    });
+                    co_await SendRequest(
+                        stream, buffer,
+                        MakeRequest(http::verb::post, "/api/v1/game/player/action"sv, config_.host, token, action_body),
+                        Endpoint::ACTION, worker.stats_mutex, worker.stats
+                    );
+                    next_action = next_after(action_interval, config_.action_rate);
+                } else {
+                    co_await SendRequest(
+                        stream, buffer,
+                        MakeRequest(http::verb::get, "/api/v1/game/state"sv, config_.host, token),
+                        Endpoint::STATE, worker.stats_mutex, worker.stats
+                    );
+                    next_state = next_after(state_interval, config_.state_rate);
+                }
+            }
+        } catch (const std::exception&) {
+            // Ошибка уже учтена в статистике, переподключаемся после паузы
+        }
+        if (Clock::now() < deadline_) {
+            timer.expires_after(RECONNECT_DELAY);
+            co_await timer.async_wait(net::use_awaitable);
+        }
+    }
+}
+
+Stats LoadGenerator::CollectStats() {
+    Stats result;
+    for (const std::unique_ptr<Worker>& worker : workers_) {
+        std::lock_guard lock{worker->stats_mutex};
+        for (size_t i = 0; i < ENDPOINT_COUNT; ++i) {
+            result[i].Merge(worker->stats[i]);
+            worker->stats[i].Reset();
+        }
+    }
+    return result;
+}
+
+void LoadGenerator::Run(std::ostream& out) {
+    const Clock::time_point start = Clock::now();
+    deadline_ = start + config_.duration;
+    // Статистика загрузки карт не относится к нагрузке
+    CollectStats();
+
+    for (size_t bot_index = 0; bot_index < config_.bots; ++bot_index) {
+        Worker& worker = *workers_[bot_index % workers_.size()];
+        net::co_spawn(worker.ioc, RunBot(worker, bot_index), net::detached);
+    }
+
+    std::vector<std::jthread> threads;
+    for (const std::unique_ptr<Worker>& worker : workers_) {
+        threads.emplace_back([&ioc = worker->ioc] {
+            ioc.run();
+        });
+    }
+
+    Stats total;
+    Clock::time_point last_report = start;
+    while (true) {
+        const Clock::time_point now = Clock::now();
+        const Clock::time_point next_report = std::min(last_report + config_.report_interval, deadline_);
+        if (now >= deadline_) {
+            break;
+        }
+        std::this_thread::sleep_until(next_report);
+
+        Stats interval = CollectStats();
+        const Clock::time_point report_time = Clock::now();
+        out << "--- " << std::chrono::duration_cast<std::chrono::seconds>(report_time - start).count() << "s ---\n";
+        PrintStats(out, interval, report_time - last_report);
+        for (size_t i = 0; i < ENDPOINT_COUNT; ++i) {
+            total[i].Merge(interval[i]);
+        }
+        last_report = report_time;
+    }
+
+    // Боты завершаются сами по истечении deadline_, дожидаемся ответов на последние запросы
+    threads.clear();
+    Stats rest = CollectStats();
+    for (size_t i = 0; i < ENDPOINT_COUNT; ++i) {
+        total[i].Merge(rest[i]);
+    }
+    out << "=== total (" << config_.bots << " bots, " << config_.duration.count() << "s) ===\n";
+    PrintStats(out, total, Clock::now() - start);
+}
+
+}  // namespace loadgen
@@ -0,0 +1,110 @@
+#pragma once
+// boost.beast будет использовать std::string_view вместо boost::string_view
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hdr_histogram.h"
+
+namespace loadgen {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = net::ip::tcp;
+
+enum class Endpoint {
+    MAPS,
+    JOIN,
+    ACTION,
+    STATE
+};
+
+constexpr size_t ENDPOINT_COUNT = 4;
+
+std::string_view GetEndpointName(Endpoint endpoint);
+
+struct Config {
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    // Число одновременно играющих ботов, у каждого своё keep-alive соединение
+    size_t bots = 1000;
+    // Число потоков, у каждого свой io_context и своя часть ботов
+    unsigned threads = 1;
+    std::chrono::seconds duration{30};
+    // Боты подключаются равномерно в течение этого времени
+    std::chrono::milliseconds ramp_up{1000};
+    // Средняя частота запросов одного бота в секунду (интервалы распределены экспоненциально), 0 - не отправлять
+    double action_rate = 5.;
+    double state_rate = 10.;
+    // Карта, к которой присоединяются боты; если не задана, каждый бот выбирает случайную из /api/v1/maps
+    std::string map_id;
+    std::chrono::seconds report_interval{5};
+};
+
+// Статистика по одному виду запросов
+struct EndpointStats {
+    // Задержки успешных запросов в микросекундах
+    HdrHistogram latency;
+    uint64_t errors = 0;
+
+    void Merge(const EndpointStats& other) {
+        latency.Merge(other.latency);
+        errors += other.errors;
+    }
+
+    void Reset() {
+        latency.Reset();
+        errors = 0;
+    }
+};
+
+using Stats = std::array<EndpointStats, ENDPOINT_COUNT>;
+
+// Печатает таблицу: запросы в секунду, ошибки и перцентили задержки по каждому виду запросов
+void PrintStats(std::ostream& out, const Stats& stats, std::chrono::duration<double> elapsed);
+
+class LoadGenerator {
+public:
+    explicit LoadGenerator(Config config);
+
+    // Запускает ботов и блокирует поток до окончания нагрузки, периодически печатая статистику в out
+    void Run(std::ostream& out);
+
+private:
+    // Поток нагрузки: однопоточный io_context и статистика его ботов
+    struct Worker {
+        net::io_context ioc{1};
+        std::mutex stats_mutex;
+        Stats stats;
+    };
+
+    Config config_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    tcp::resolver::results_type endpoints_;
+    std::vector<std::string> map_ids_;
+    std::chrono::steady_clock::time_point deadline_;
+
+    // Загружает список карт через /api/v1/maps
+    void LoadMapIds();
+
+    // Забирает накопленную потоками статистику
+    Stats CollectStats();
+
+    net::awaitable<void> RunBot(Worker& worker, size_t bot_index);
+};
+
+}  // namespace loadgen
@@ -0,0 +1,85 @@
+#include <boost/program_options.hpp>
+
+#include <sys/resource.h>
+
+#include <iostream>
+#include <optional>
+#include <thread>
+
+#include "load_generator.h"
+
+using namespace std::literals;
+
+namespace {
+
+[[nodiscard]] std::optional<loadgen::Config> ParseCommandLine(int argc, const char* const argv[]) {
+    namespace po = boost::program_options;
+
+    po::options_description desc{"All options"s};
+
+    loadgen::Config config;
+    config.threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+    int64_t duration = config.duration.count();
+    int64_t ramp_up = config.ramp_up.count();
+    int64_t report_interval = config.report_interval.count();
+    desc.add_options()
+        ("help,h", "Usage: ./game_server_loadgen --host <host> --port <port> --bots <n> --duration <seconds>")
+        // Адрес и порт игрового сервера
+        ("host", po::value(&config.host)->value_name("host"s), "set server host")
+        ("port,p", po::value(&config.port)->value_name("port"s), "set server port")
+        // Число ботов, каждый присоединяется к игре и держит своё соединение
+        ("bots,b", po::value(&config.bots)->value_name("n"s), "set number of simulated players")
+        ("threads", po::value(&config.threads)->value_name("n"s), "set number of load threads")
+        ("duration,d", po::value(&duration)->value_name("seconds"s), "set load duration")
+        ("ramp-up", po::value(&ramp_up)->value_name("milliseconds"s), "spread bot joins over this time")
+        // Средняя частота запросов одного бота, 0 отключает запросы этого вида
+        ("action-rate", po::value(&config.action_rate)->value_name("per-second"s), "set player/action requests per bot per second")
+        ("state-rate", po::value(&config.state_rate)->value_name("per-second"s), "set game/state requests per bot per second")
+        ("map", po::value(&config.map_id)->value_name("id"s), "join this map (random map per bot by default)")
+        ("report-interval", po::value(&report_interval)->value_name("seconds"s), "set interval between progress reports");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.contains("help"s)) {
+        std::cout << desc;
+        return std::nullopt;
+    }
+
+    config.duration = std::chrono::seconds{duration};
+    config.ramp_up = std::chrono::milliseconds{ramp_up};
+    config.report_interval = std::chrono::seconds{std::max<int64_t>(report_interval, 1)};
+    return config;
+}
+
+// Каждый бот держит сокет, поэтому поднимаем лимит открытых файлов до максимально разрешённого
+void RaiseOpenFilesLimit(size_t required) {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur >= required + 64) {
+        return;
+    }
+    limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, required + 64);
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if (limit.rlim_cur < required + 64) {
+        std::cerr << "Warning: open files limit " << limit.rlim_cur << " is too low for " << required << " bots\n";
+    }
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    try {
+        std::optional<loadgen::Config> config = ParseCommandLine(argc, argv);
+        if (!config) {
+            return EXIT_SUCCESS;
+        }
+        RaiseOpenFilesLimit(config->bots);
+
+        loadgen::LoadGenerator generator{std::move(*config)};
+        generator.Run(std::cout);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
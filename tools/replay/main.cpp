@@ -0,0 +1,152 @@
+#include <boost/program_options.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <unordered_map>
+
+#include "../../src/application.h"
+#include "../../src/json_loader.h"
+#include "../../src/replay_log.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct Args {
+    std::string config_file;
+    std::string replay_file;
+    // Сверять контрольные суммы состояния, записанные в журнал
+    bool verify = true;
+};
+
+[[nodiscard]] std::optional<Args> ParseCommandLine(int argc, const char* const argv[]) {
+    namespace po = boost::program_options;
+
+    po::options_description desc{"All options"s};
+
+    Args args;
+    bool no_verify = false;
+    desc.add_options()
+        ("help,h", "Usage: ./game_server_replay --config-file <config-path> --replay-file <replay-path>")
+        // Файл конфигурации должен совпадать с тем, с которым сервер записывал журнал
+        ("config-file,c", po::value(&args.config_file)->value_name("file"s), "set config file path")
+        ("replay-file,r", po::value(&args.replay_file)->value_name("file"s), "set replay file recorded by game_server --record-replay")
+        ("no-verify", po::bool_switch(&no_verify), "do not compare state hashes stored in the replay");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.contains("help"s)) {
+        std::cout << desc;
+        return std::nullopt;
+    }
+    if (!vm.contains("config-file"s)) {
+        throw std::runtime_error("Config file path has not been specified"s);
+    }
+    if (!vm.contains("replay-file"s)) {
+        throw std::runtime_error("Replay file path has not been specified"s);
+    }
+    args.verify = !no_verify;
+    return args;
+}
+
+// Повторяет события журнала на приложении без HTTP-сервера и таймеров
+class Replayer {
+public:
+    Replayer(application::Application& app, bool verify)
+    : app_{app}, verify_{verify}
+    {
+
+    }
+
+    void operator()(const replay::JoinEvent& event) {
+        auto [token, player_id] = app_.JoinGame(event.player_name, model::Map::Id{event.map_id});
+        if (*player_id != event.player_id) {
+            throw std::runtime_error("Replay diverged at tick "s + std::to_string(ticks_) + ": player id "s
+                + std::to_string(*player_id) + " instead of "s + std::to_string(event.player_id));
+        }
+        players_[event.player_id] = app_.FindPlayerByToken(token);
+        ++joins_;
+    }
+
+    void operator()(const replay::MoveEvent& event) {
+        auto it = players_.find(event.player_id);
+        if (it == players_.end() || !it->second->GetDog()) {
+            throw std::runtime_error("Replay diverged at tick "s + std::to_string(ticks_) + ": unknown player "s
+                + std::to_string(event.player_id));
+        }
+        app_.MovePlayer(it->second, event.direction);
+        ++moves_;
+    }
+
+    void operator()(const replay::TickEvent& event) {
+        app_.Tick(event.time_delta);
+        game_time_ += event.time_delta;
+        ++ticks_;
+    }
+
+    void operator()(const replay::StateHashEvent& event) {
+        if (!verify_) {
+            return;
+        }
+        const uint64_t hash = app_.ComputeStateHash();
+        if (hash != event.hash) {
+            throw std::runtime_error("Replay diverged: state hash mismatch after tick "s + std::to_string(ticks_));
+        }
+        ++verified_hashes_;
+    }
+
+    void PrintSummary(std::ostream& os, std::chrono::steady_clock::duration elapsed) const {
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        os << "joins: "sv << joins_ << ", moves: "sv << moves_ << ", ticks: "sv << ticks_ << '\n';
+        os << "game time: "sv << std::chrono::duration<double>(game_time_).count() << " s, wall time: "sv << seconds << " s\n"sv;
+        os << "ticks/sec: "sv << (seconds > 0 ? ticks_ / seconds : 0.0)
+           << ", speedup: "sv << (seconds > 0 ? std::chrono::duration<double>(game_time_).count() / seconds : 0.0) << "x\n"sv;
+        os << "verified state hashes: "sv << verified_hashes_ << ", final state hash: "sv
+           << std::hex << app_.ComputeStateHash() << std::dec << '\n';
+    }
+
+private:
+    application::Application& app_;
+    bool verify_;
+    std::unordered_map<uint64_t, std::shared_ptr<application::Player>> players_;
+    uint64_t joins_ = 0;
+    uint64_t moves_ = 0;
+    uint64_t ticks_ = 0;
+    uint64_t verified_hashes_ = 0;
+    std::chrono::milliseconds game_time_{0};
+};
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    try {
+        std::optional<Args> args = ParseCommandLine(argc, argv);
+        if (!args) {
+            return EXIT_SUCCESS;
+        }
+
+        replay::ReplayReader reader{args->replay_file};
+        const replay::Header& header = reader.GetHeader();
+
+        // Рекорды выбывших игроков не должны попасть в базу сервера, поэтому хранятся в памяти
+        application::AppConfig config;
+        config.records_storage = application::RecordsStorage::MEMORY;
+        config.random_seed = header.random_seed;
+        config.fixed_time_step = header.fixed_time_step;
+        application::Application app{json_loader::LoadGame(args->config_file, header.randomize_spawn_points), config};
+
+        Replayer replayer{app, args->verify};
+        const auto start = std::chrono::steady_clock::now();
+        while (std::optional<replay::Event> event = reader.Next()) {
+            std::visit(replayer, *event);
+        }
+        replayer.PrintSummary(std::cout, std::chrono::steady_clock::now() - start);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
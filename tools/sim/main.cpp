@@ -0,0 +1,235 @@
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+
+#include "../../src/application.h"
+#include "../../src/json_loader.h"
+#include "../../src/profiler.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct Args {
+    std::string config_file;
+    size_t players = 1000;
+    uint64_t ticks = 10'000;
+    int64_t tick_period = 50;
+    // Через сколько тиков игрок меняет направление движения
+    uint64_t turn_period = 20;
+    // Доля игроков, которые не двигаются и выбывают по таймауту бездействия. Вместо них присоединяются новые
+    double idle_share = 0.0;
+    std::optional<std::string> map_id;
+    uint64_t random_seed = 0;
+    bool randomize_spawn_points = false;
+    // Файл для трассировки последних тиков в формате Chrome trace event
+    std::string profile_file;
+};
+
+[[nodiscard]] std::optional<Args> ParseCommandLine(int argc, const char* const argv[]) {
+    namespace po = boost::program_options;
+
+    po::options_description desc{"All options"s};
+
+    Args args;
+    std::string map_id;
+    desc.add_options()
+        ("help,h", "Usage: ./game_server_sim --config-file <config-path> --players <n> --ticks <n>")
+        ("config-file,c", po::value(&args.config_file)->value_name("file"s), "set config file path")
+        ("players,p", po::value(&args.players)->value_name("n"s), "set number of simulated players")
+        ("ticks,t", po::value(&args.ticks)->value_name("n"s), "set number of ticks to run")
+        // Время, которое передаётся в каждый тик. Тики выполняются без пауз
+        ("tick-period", po::value(&args.tick_period)->value_name("milliseconds"s), "set game time per tick")
+        ("turn-period", po::value(&args.turn_period)->value_name("ticks"s), "set ticks between direction changes of a player")
+        ("idle-share", po::value(&args.idle_share)->value_name("fraction"s), "set share of players that never move and retire")
+        ("map", po::value(&map_id)->value_name("id"s), "join this map (players are spread over all maps by default)")
+        ("random-seed", po::value(&args.random_seed)->value_name("n"s), "set seed for the game and the movement script")
+        ("randomize-spawn-points", po::bool_switch(&args.randomize_spawn_points), "spawn dogs at random positions")
+        ("profile-file", po::value(&args.profile_file)->value_name("file"s), "save Chrome trace of the last ticks to file");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.contains("help"s)) {
+        std::cout << desc;
+        return std::nullopt;
+    }
+    if (!vm.contains("config-file"s)) {
+        throw std::runtime_error("Config file path has not been specified"s);
+    }
+    if (args.tick_period <= 0) {
+        throw std::runtime_error("Tick period must be positive"s);
+    }
+    if (args.turn_period == 0) {
+        throw std::runtime_error("Turn period must be positive"s);
+    }
+    if (args.idle_share < 0.0 || args.idle_share > 1.0) {
+        throw std::runtime_error("Idle share must be between 0 and 1"s);
+    }
+    if (vm.contains("map"s)) {
+        args.map_id = map_id;
+    }
+    return args;
+}
+
+// Игроки с заданным сценарием движения: каждый turn_period тиков активный игрок выбирает
+// случайное направление, неактивные игроки стоят на месте
+class Simulation {
+public:
+    Simulation(application::Application& app, const Args& args)
+    : app_{app}, args_{args}, random_{args.random_seed}
+    {
+        for (const std::shared_ptr<model::Map>& map : app_.GetMaps()) {
+            if (!args_.map_id || *map->GetId() == *args_.map_id) {
+                map_ids_.push_back(map->GetId());
+            }
+        }
+        if (map_ids_.empty()) {
+            throw std::runtime_error(args_.map_id ? "Map "s + *args_.map_id + " not found"s : "Config has no maps"s);
+        }
+        bots_.reserve(args_.players);
+        for (size_t i = 0; i < args_.players; ++i) {
+            bots_.push_back(Join(i));
+        }
+    }
+
+    void Run() {
+        const std::chrono::milliseconds tick_period{args_.tick_period};
+        app_.EnablePhaseTiming(true);
+        app_.ResetPhaseTimes();
+        const auto start = Clock::now();
+        for (uint64_t tick = 0; tick < args_.ticks; ++tick) {
+            for (size_t i = 0; i < bots_.size(); ++i) {
+                Bot& bot = bots_[i];
+                if (!bot.idle && (tick + i) % args_.turn_period == 0) {
+                    app_.MovePlayer(bot.player, std::string{DIRECTIONS[random_() % DIRECTIONS.size()]});
+                }
+            }
+
+            const auto tick_start = Clock::now();
+            app_.Tick(tick_period);
+            tick_time_ += Clock::now() - tick_start;
+
+            ReplaceRetiredBots();
+        }
+        wall_time_ = Clock::now() - start;
+    }
+
+    void PrintReport(std::ostream& os, const memory::PlayerRepositoryImpl& records) const {
+        const double tick_seconds = std::chrono::duration<double>(tick_time_).count();
+        const double wall_seconds = std::chrono::duration<double>(wall_time_).count();
+        const double game_seconds = std::chrono::duration<double>(std::chrono::milliseconds{args_.tick_period}).count() * args_.ticks;
+
+        size_t sessions = 0;
+        size_t lost_objects = 0;
+        for (const auto& [map_id, map_sessions] : app_.GetMapIdToSession()) {
+            sessions += map_sessions.size();
+            for (const std::shared_ptr<model::GameSession>& session : map_sessions) {
+                lost_objects += session->GetLostObjects().size();
+            }
+        }
+
+        os << "maps: "sv << map_ids_.size() << ", sessions: "sv << sessions << ", players: "sv << bots_.size()
+           << ", lost objects: "sv << lost_objects << '\n';
+        os << "ticks: "sv << args_.ticks << ", joins: "sv << joins_ << ", retired: "sv << records.GetSize() << '\n';
+        os << std::fixed << std::setprecision(1);
+        os << "ticks/sec: "sv << (tick_seconds > 0 ? args_.ticks / tick_seconds : 0.0)
+           << " (with driver overhead "sv << (wall_seconds > 0 ? args_.ticks / wall_seconds : 0.0) << ")"sv
+           << ", speedup: "sv << (tick_seconds > 0 ? game_seconds / tick_seconds : 0.0) << "x\n"sv;
+
+        const application::TickPhaseTimes& phases = app_.GetPhaseTimes();
+        const std::chrono::nanoseconds phases_total = phases.move + phases.retire + phases.collide + phases.loot + phases.publish;
+        os << "phase       total ms   us/tick   share\n"sv;
+        auto print_phase = [&](std::string_view name, std::chrono::nanoseconds time) {
+            os << std::left << std::setw(9) << name << std::right
+               << std::setw(11) << std::chrono::duration<double, std::milli>(time).count()
+               << std::setw(10) << (args_.ticks ? std::chrono::duration<double, std::micro>(time).count() / args_.ticks : 0.0)
+               << std::setw(7) << (phases_total.count() ? 100.0 * time.count() / phases_total.count() : 0.0) << "%\n"sv;
+        };
+        print_phase("move"sv, phases.move);
+        print_phase("retire"sv, phases.retire);
+        print_phase("collide"sv, phases.collide);
+        print_phase("loot"sv, phases.loot);
+        print_phase("publish"sv, phases.publish);
+        // Остаток времени тика: обход сессий, журнал воспроизведения, слушатель
+        print_phase("other"sv, std::max(tick_time_ - phases_total, std::chrono::nanoseconds::zero()));
+        os << std::defaultfloat;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::array DIRECTIONS{"L"sv, "R"sv, "U"sv, "D"sv};
+
+    struct Bot {
+        application::Token token;
+        std::shared_ptr<application::Player> player;
+        bool idle = false;
+    };
+
+    Bot Join(size_t index) {
+        const model::Map::Id& map_id = map_ids_[index % map_ids_.size()];
+        auto [token, player_id] = app_.JoinGame("bot "s + std::to_string(joins_++), map_id);
+        std::bernoulli_distribution idle{args_.idle_share};
+        return Bot{token, app_.FindPlayerByToken(token), idle(random_)};
+    }
+
+    // Выбывших игроков заменяют новые, чтобы число игроков не менялось
+    void ReplaceRetiredBots() {
+        if (app_.GetPlayers().size() == bots_.size()) {
+            return;
+        }
+        for (size_t i = 0; i < bots_.size(); ++i) {
+            if (!app_.FindPlayerByToken(bots_[i].token)) {
+                bots_[i] = Join(i);
+            }
+        }
+    }
+
+    application::Application& app_;
+    const Args& args_;
+    std::mt19937_64 random_;
+    std::vector<model::Map::Id> map_ids_;
+    std::vector<Bot> bots_;
+    uint64_t joins_ = 0;
+    Clock::duration tick_time_{};
+    Clock::duration wall_time_{};
+};
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    try {
+        std::optional<Args> args = ParseCommandLine(argc, argv);
+        if (!args) {
+            return EXIT_SUCCESS;
+        }
+
+        // Рекорды выбывших игроков хранятся в памяти, база данных не нужна
+        memory::PlayerRepositoryImpl records;
+        application::AppConfig config;
+        config.random_seed = args->random_seed;
+        application::Application app{json_loader::LoadGame(args->config_file, args->randomize_spawn_points), config, records};
+
+        if (!args->profile_file.empty()) {
+            profiler::Enable();
+        }
+        Simulation simulation{app, *args};
+        simulation.Run();
+        simulation.PrintReport(std::cout, records);
+        if (!args->profile_file.empty()) {
+            profiler::SaveChromeTrace(args->profile_file);
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}